@@ -1,19 +1,21 @@
 #include "lmStruct.hpp"
 #include "standard.hpp"
 #include "interpreter.hpp"
+#include <climits>
 #include <ranges>
+#include <string>
 
 Value range(const std::vector<Value>& args) {
     if (args.empty()) return LAMINA_NULL;
 
     const int start = args.size() > 1
-                              ? std::get<int>(args[0].data)
+                              ? args[0].get<int>()
                               : 0;
     const int end = args.size() > 1
-                            ? std::get<int>(args[1].data)
-                            : std::get<int>(args[0].data);
+                            ? args[1].get<int>()
+                            : args[0].get<int>();
     const int sep = args.size() > 2
-                            ? std::get<int>(args[2].data)
+                            ? args[2].get<int>()
                             : 1;
     std::vector<Value> vec;
     for (auto i = start; i < end; i += sep) {
@@ -22,6 +24,187 @@ Value range(const std::vector<Value>& args) {
     return vec;
 }
 
+// 读取可选的类型名参数
+static NumArray::DType dtype_arg(const std::vector<Value>& args, size_t pos, NumArray::DType fallback) {
+    if (args.size() <= pos) return fallback;
+    NumArray::DType dtype;
+    if (!args[pos].is_string() || !NumArray::parse_dtype(args[pos].get<std::string>(), dtype)) {
+        L_ERR("dtype must be one of \"int64\", \"float64\", \"float32\"");
+    }
+    return dtype;
+}
+
+// 嵌套数组 / 矩阵按行优先顺序展开，同时推出形状；同一层的长度必须一致，数值只能出现在最内层
+namespace {
+struct Nested {
+    NumArray::Shape shape;
+    std::vector<const Value*> leaves;
+    size_t leaf_depth = SIZE_MAX;
+
+    void list(size_t n, size_t depth) {
+        if (leaf_depth != SIZE_MAX && depth >= leaf_depth) L_ERR("numarray() requires a rectangular nested array");
+        if (shape.size() == depth) shape.push_back(n);
+        else if (shape[depth] != n) L_ERR("numarray() requires a rectangular nested array");
+    }
+
+    void walk(const Value& v, size_t depth) {
+        if (v.is_array()) {
+            const auto& items = v.get<std::vector<Value>>();
+            list(items.size(), depth);
+            for (const auto& item : items) walk(item, depth + 1);
+        } else if (v.is_matrix()) {
+            const auto& rows = v.get<std::vector<std::vector<Value>>>();
+            list(rows.size(), depth);
+            for (const auto& row : rows) {
+                list(row.size(), depth + 1);
+                for (const auto& item : row) walk(item, depth + 2);
+            }
+        } else {
+            if (!v.is_numeric()) L_ERR("numarray() requires numeric elements");
+            if (leaf_depth == SIZE_MAX) leaf_depth = depth;
+            if (depth != leaf_depth || depth != shape.size()) L_ERR("numarray() requires a rectangular nested array");
+            leaves.push_back(&v);
+        }
+    }
+};
+}// namespace
+
+// 落在 int64 范围内的 BigInt 按整数写入，不经过 double
+static bool int64_value(const ::BigInt& v, std::int64_t& out) {
+    static const ::BigInt lo(std::to_string(INT64_MIN)), hi(std::to_string(INT64_MAX));
+    if (v < lo || v > hi) return false;
+    out = std::stoll(v.to_string());
+    return true;
+}
+
+// 形状参数：整数或整数数组，-1 表示由其余维推出
+static NumArray::Shape shape_arg(const Value& v) {
+    if (v.is_int() && v.get<int>() >= 0) return {static_cast<size_t>(v.get<int>())};
+    if (!v.is_array()) L_ERR("Shape must be an integer or an array of integers");
+    NumArray::Shape shape;
+    for (const auto& d : v.get<std::vector<Value>>()) {
+        if (!d.is_int() || d.get<int>() < -1) L_ERR("Shape must be an integer or an array of integers");
+        shape.push_back(d.get<int>() == -1 ? SIZE_MAX : static_cast<size_t>(d.get<int>()));
+    }
+    return shape;
+}
+
+static const NumArray& numarray_arg(const Value& v, const char* func) {
+    if (!v.is_numarray()) L_ERR(std::string(func) + "() requires a typed array");
+    return v.get<NumArray>();
+}
+
+Value numarray(const std::vector<Value>& args) {
+    if (args.empty() || args.size() > 2) {
+        L_ERR("numarray() takes an array and an optional dtype");
+    }
+    if (args[0].is_numarray()) {
+        const auto& arr = args[0].get<NumArray>();
+        return arr.astype(dtype_arg(args, 1, arr.dtype()));
+    }
+    if (!args[0].is_array() && !args[0].is_matrix()) {
+        L_ERR("numarray() requires an array");
+    }
+    Nested nested;
+    nested.walk(args[0], 0);
+    bool all_int = true;
+    for (const auto* v : nested.leaves) all_int = all_int && (v->is_int() || v->is_bigint());
+    const auto dtype = dtype_arg(args, 1, all_int ? NumArray::DType::Int64 : NumArray::DType::Float64);
+    NumArray arr(dtype, nested.shape);
+    for (size_t i = 0; i < nested.leaves.size(); i++) {
+        const Value& v = *nested.leaves[i];
+        if (v.is_int()) {
+            arr.set(i, static_cast<std::int64_t>(v.get<int>()));
+        } else if (v.is_bigint() && dtype == NumArray::DType::Int64) {
+            std::int64_t n;
+            if (!int64_value(v.get<::BigInt>(), n)) L_ERR("numarray() element " + v.to_string() + " does not fit in int64");
+            arr.set(i, n);
+        } else {
+            arr.set(i, v.as_number());
+        }
+    }
+    return arr;
+}
+
+Value zeros(const std::vector<Value>& args) {
+    if (args.empty() || args.size() > 2) {
+        L_ERR("zeros() requires a shape and an optional dtype");
+    }
+    auto shape = shape_arg(args[0]);
+    if (std::ranges::find(shape, SIZE_MAX) != shape.end()) L_ERR("zeros() cannot infer a dimension");
+    return NumArray(dtype_arg(args, 1, NumArray::DType::Float64), std::move(shape));
+}
+
+static Value to_nested(const NumArray& arr) {
+    std::vector<Value> vec;
+    vec.reserve(arr.shape()[0]);
+    for (size_t i = 0; i < arr.shape()[0]; i++) {
+        vec.push_back(arr.ndim() == 1 ? Value::numarray_element(arr, i) : to_nested(arr.take(i)));
+    }
+    return vec;
+}
+
+Value to_array(const std::vector<Value>& args) {
+    check_cpp_function_argv(args, 1);
+    return to_nested(numarray_arg(args[0], "to_array"));
+}
+
+Value shape(const std::vector<Value>& args) {
+    check_cpp_function_argv(args, 1);
+    std::vector<Value> dims;
+    for (auto d : numarray_arg(args[0], "shape").shape()) dims.emplace_back(static_cast<int>(d));
+    return dims;
+}
+
+Value reshape(const std::vector<Value>& args) {
+    check_cpp_function_argv(args, 2);
+    try {
+        return numarray_arg(args[0], "reshape").reshape(shape_arg(args[1]));
+    } catch (const std::invalid_argument& e) {
+        L_ERR(e.what());
+        return LAMINA_NULL;
+    }
+}
+
+Value transpose(const std::vector<Value>& args) {
+    if (args.empty() || args.size() > 2) {
+        L_ERR("transpose() takes a typed array and an optional axes array");
+    }
+    const auto& arr = numarray_arg(args[0], "transpose");
+    if (args.size() == 1) return arr.transpose();
+    std::vector<size_t> axes;
+    for (auto d : shape_arg(args[1])) axes.push_back(d);
+    try {
+        return arr.transpose(axes);
+    } catch (const std::invalid_argument& e) {
+        L_ERR(e.what());
+        return LAMINA_NULL;
+    }
+}
+
+Value slice(const std::vector<Value>& args) {
+    if (args.size() < 4 || args.size() > 5) {
+        L_ERR("slice() takes a typed array, axis, start, stop and an optional step");
+    }
+    for (size_t i = 1; i < args.size(); i++) {
+        if (!args[i].is_int()) L_ERR("slice() bounds must be integers");
+    }
+    const auto& arr = numarray_arg(args[0], "slice");
+    if (args[1].get<int>() < 0) L_ERR("Axis out of range");
+    try {
+        return arr.slice(args[1].get<int>(), args[2].get<int>(), args[3].get<int>(),
+                         args.size() > 4 ? args[4].get<int>() : 1);
+    } catch (const std::invalid_argument& e) {
+        L_ERR(e.what());
+        return LAMINA_NULL;
+    }
+}
+
+Value dtype(const std::vector<Value>& args) {
+    check_cpp_function_argv(args, 1);
+    return Value(NumArray::dtype_name(numarray_arg(args[0], "dtype").dtype()));
+}
+
 Value arr_at(const std::vector<Value>& args) {
     if (!args[0].is_array()) {
         L_ERR("First Arg Must Be A Array");
@@ -35,14 +218,14 @@ Value arr_at(const std::vector<Value>& args) {
             L_ERR("Index argument must be an integer");
             return LAMINA_NULL;
         }
-        int index = std::get<int>(args[i].data);
+        int index = args[i].get<int>();
 
         if (!current->is_array()) {
             L_ERR("Cannot index non-array value at level " + std::to_string(i));
             return LAMINA_NULL;
         }
 
-        const auto& arr = std::get<std::vector<Value>>(current->data);
+        const auto& arr = current->get<std::vector<Value>>();
 
         if (index < 0 || static_cast<size_t>(index) >= arr.size()) {
             L_ERR("Array Index Out Of Range at level " + std::to_string(i));
@@ -57,17 +240,18 @@ Value arr_at(const std::vector<Value>& args) {
 
 Value arr_set(const std::vector<Value>& args) {
     check_cpp_function_argv(args, 3);
-    if (!args[1].is_array() and !args[2].is_int()) {
+    if (!args[0].is_array() or !args[1].is_int()) {
         L_ERR("First Arg Must Be A Array, Second Arg Must Be a int");
         return LAMINA_NULL;
     }
-    auto arr = std::get<std::vector<Value>>(args[0].data);
-    const auto idx = std::get<int>(args[1].data);
-    if (idx > arr.size()) {
+    // 返回新数组，原数组不变；共享存储在 get_mut 时才复制
+    Value arr = args[0];
+    auto& elems = arr.get_mut<std::vector<Value>>();
+    const auto idx = args[1].get<int>();
+    if (idx < 0 or static_cast<size_t>(idx) >= elems.size()) {
         L_ERR("Array Index Out Of Range");
     }
-    const auto& val = args[3];
-    arr[idx] = val;
+    elems[idx] = args[2];
 
     return arr;
 }
@@ -78,8 +262,8 @@ Value arr_index_of(const std::vector<Value>& args) {
         return LAMINA_NULL;
     }
 
-    const std::string target_key = std::get<std::string>(args[1].data);
-    const auto& arr = std::get<std::vector<Value>>(args[0].data);
+    const std::string target_key = args[1].get<std::string>();
+    const auto& arr = args[0].get<std::vector<Value>>();
     Value result = LAMINA_NULL;
     bool found = false;
 
@@ -93,7 +277,7 @@ Value arr_index_of(const std::vector<Value>& args) {
 
             if (!key_elem.is_string()) continue;
 
-            const std::string current_key = std::get<std::string>(key_elem.data);
+            const std::string current_key = key_elem.get<std::string>();
             if (current_key == target_key) {
                 result = value_elem;
                 found = true;
@@ -113,10 +297,10 @@ Value arr_index_of(const std::vector<Value>& args) {
 // 遍历容器：需2个参数（容器、遍历执行的函数），对容器每个元素执行函数并返回执行结果集
 Value foreach(const std::vector<Value>& args){
     check_cpp_function_argv(args, 2);
-    const auto func = std::get<std::shared_ptr<LambdaDeclExpr>>(args[1].data);
+    const auto func = args[1].get<std::shared_ptr<LambdaDeclExpr>>();
 
     if (args[0].is_array()) {
-        const auto arr = std::get<std::vector<Value>>(args[0].data);
+        const auto arr = args[0].get<std::vector<Value>>();
         int cnt = 0;
         for (const auto& value: arr) {
             Interpreter::call_function(func.get(), {cnt, value});
@@ -125,14 +309,14 @@ Value foreach(const std::vector<Value>& args){
         return LAMINA_NULL;
     }
     if (args[0].is_lstruct()) {
-        const auto arr = std::get<std::shared_ptr<lmStruct>>(args[0].data)->to_vector();
+        const auto arr = args[0].get<std::shared_ptr<lmStruct>>()->to_vector();
         for (auto [key, value] : arr) {
             Interpreter::call_function(func.get(), {Value(key), value});
         }
         return LAMINA_NULL;
     }
     if (args[0].is_string()) {
-        const auto arr = std::get<std::string>(args[0].data);
+        const auto arr = args[0].get<std::string>();
         int cnt = 0;
         for (const auto value: arr) {
             Interpreter::call_function(func.get(), {Value(cnt), Value(value)});
@@ -146,8 +330,8 @@ Value foreach(const std::vector<Value>& args){
 // 查找符合条件的元素：需2个参数（容器、判断函数），返回第一个满足条件的元素；无则返回空
 Value find(const std::vector<Value>& args) {
     check_cpp_function_argv(args, 2);
-    const auto arr = std::get<std::vector<Value>>(args[0].data);
-    const auto func = std::get<std::shared_ptr<LambdaDeclExpr>>(args[1].data);
+    const auto arr = args[0].get<std::vector<Value>>();
+    const auto func = args[1].get<std::shared_ptr<LambdaDeclExpr>>();
     for (const auto& value: arr) {
         auto ret = Interpreter::call_function(
             func.get(), {value});
@@ -162,8 +346,8 @@ Value find(const std::vector<Value>& args) {
 // 映射转换：需2个参数（容器、转换函数），对容器每个元素执行函数，返回转换后的新容器
 Value map(const std::vector<Value>& args){
     check_cpp_function_argv(args, 2);
-    const auto arr = std::get<std::vector<Value>>(args[0].data);
-    const auto func = std::get<std::shared_ptr<LambdaDeclExpr>>(args[1].data);
+    const auto arr = args[0].get<std::vector<Value>>();
+    const auto func = args[1].get<std::shared_ptr<LambdaDeclExpr>>();
     std::vector<Value> result{};
     for (const auto& value: arr) {
         result.emplace_back(Interpreter::call_function(
@@ -176,8 +360,8 @@ Value map(const std::vector<Value>& args){
 // 替换内容：需2个参数（原容器、转换函数）
 Value replace(const std::vector<Value>& args) {
     check_cpp_function_argv(args, 2);
-    auto arr = std::get<std::vector<Value>>(args[0].data);
-    const auto func = std::get<std::shared_ptr<LambdaDeclExpr>>(args[1].data);
+    auto arr = args[0].get<std::vector<Value>>();
+    const auto func = args[1].get<std::shared_ptr<LambdaDeclExpr>>();
     std::vector<Value> result{};
     for (const auto& value: arr) {
         result.emplace_back(Interpreter::call_function(
@@ -14,7 +14,9 @@ Value input(const std::vector<Value>& args) {
     std::string input_line;
 
     if (args.size() == 1) {
-        std::cout << args[0].to_string();
+        std::string prompt;
+        args[0].write_to(prompt);
+        std::cout << prompt;
     }
 
     if (std::getline(std::cin, input_line)) {
@@ -26,14 +28,14 @@ Value input(const std::vector<Value>& args) {
 }
 
 Value print(const std::vector<Value>& args) {
+    // 整行写入同一个缓冲区，只输出一次
+    std::string line;
     for (size_t i = 0; i < args.size(); ++i) {
-        std::cout << args[i].to_string();
-        if (i != args.size() - 1) {
-            std::cout << " ";
-        }
+        if (i) line += ' ';
+        args[i].write_to(line);
     }
-
-    std::cout << std::endl;
+    line += '\n';
+    std::cout << line << std::flush;
     return Value();
 }
 
@@ -111,7 +113,7 @@ Value vars(const std::vector<Value>& args) {
 // 退出程序
 Value exit_(const std::vector<Value>& args){
     if (args.empty()) return LAMINA_NULL;
-    const auto err_code = std::get<int>(args[0].data);
+    const auto err_code = args[0].get<int>();
     std::exit(err_code);
     return LAMINA_NULL;
 }
@@ -120,8 +122,8 @@ Value exit_(const std::vector<Value>& args){
 Value xpcall(const std::vector<Value>& args){
     if (args.size() < 2) return LAMINA_NULL;
     if (!args[0].is_lambda() and !args[1].is_lambda()) return LAMINA_NULL;
-    const auto func = std::get<std::shared_ptr<LambdaDeclExpr>>(args[0].data);
-    const auto handle = std::get<std::shared_ptr<LambdaDeclExpr>>(args[1].data);
+    const auto func = args[0].get<std::shared_ptr<LambdaDeclExpr>>();
+    const auto handle = args[1].get<std::shared_ptr<LambdaDeclExpr>>();
     const auto new_args = std::vector(args.begin() + 2, args.end());
     try {
         Value result = Interpreter::call_function(
@@ -163,6 +165,8 @@ Value typeof_(const std::vector<Value>& args) {
         case Value::Type::Matrix:    return LAMINA_STRING("matrix");
         case Value::Type::lmCppFunction:return LAMINA_STRING("cpp_func");
         case Value::Type::lmModule:  return LAMINA_STRING("module");
+        case Value::Type::CasExpr:   return LAMINA_STRING("cas_expr");
+        case Value::Type::NumArray:  return LAMINA_STRING("numarray");
         default: return LAMINA_NULL;
     }
 
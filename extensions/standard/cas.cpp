@@ -4,41 +4,136 @@
  */
 #include "standard.hpp"
 #include "cas.hpp"
+#include "lmStruct.hpp"
+#include "../../interpreter/lamina_api/ast.hpp"
+#include "../../interpreter/lamina_api/linsolve.hpp"
 #include "../../interpreter/lamina_api/value.hpp"
+#include <climits>
 #include <cstring>
 #include <iostream>
+#include <list>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
 
 using namespace LaminaCAS;
 
 // 表达式存储
-static std::map<std::string, ExprPtr> stored_expressions;
+static std::map<std::string, SharedExpr> stored_expressions;
+
+// 解析缓存：按表达式文本缓存解析结果（LRU，容量有限）
+// 循环里对同一公式反复求值时直接取缓存的树，不再解析
+namespace {
+    class ParseCache {
+    public:
+        static constexpr size_t capacity = 256;
+
+        // 返回解析结果，解析失败时抛出异常（失败不缓存）
+        SharedExpr parsed(const std::string& text) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return lookup(text).parsed;
+        }
+
+        // 返回解析并化简后的结果，化简在首次需要时进行
+        SharedExpr simplified(const std::string& text) {
+            std::lock_guard<std::mutex> lock(mutex);
+            Entry& entry = lookup(text);
+            if (!entry.simplified) {
+                entry.simplified = entry.parsed->simplify();
+            }
+            return entry.simplified;
+        }
+
+        struct Stats {
+            size_t hits;
+            size_t misses;
+            size_t size;
+        };
+
+        Stats stats() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return {hits, misses, entries.size()};
+        }
+
+    private:
+        struct Entry {
+            std::string text;
+            SharedExpr parsed;
+            SharedExpr simplified;
+        };
+
+        Entry& lookup(const std::string& text) {
+            auto it = index.find(text);
+            if (it != index.end()) {
+                hits++;
+                entries.splice(entries.begin(), entries, it->second);
+                return entries.front();
+            }
+            misses++;
+            Parser parser(text);
+            SharedExpr expr = parser.parse();
+            if (entries.size() >= capacity) {
+                index.erase(entries.back().text);
+                entries.pop_back();
+            }
+            entries.push_front({text, std::move(expr), nullptr});
+            index[text] = entries.begin();
+            return entries.front();
+        }
+
+        std::mutex mutex;
+        size_t hits = 0;
+        size_t misses = 0;
+        std::list<Entry> entries;// 最近使用的在前
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    };
+
+    ParseCache parse_cache;
+}
 
 // 辅助函数：将Lamina Value转换为Expression
-ExprPtr valueToExpression(const Value& value) {
-    if (value.is_int()) {
-        return std::make_unique<Number>(static_cast<double>(std::get<int>(value.data)));
+// CAS 表达式值直接共享已解析的树，只有字符串才需要解析
+SharedExpr valueToExpression(const Value& value) {
+    if (value.is_cas_expr()) {
+        return value.get<SharedExpr>();
+    } else if (value.is_int()) {
+        return std::make_shared<Number>(static_cast<double>(value.get<int>()));
     } else if (value.is_float()) {
-        return std::make_unique<Number>(std::get<double>(value.data));
+        return std::make_shared<Number>(value.get<double>());
     } else if (value.is_string()) {
-        std::string str = std::get<std::string>(value.data);
+        const std::string& str = value.get<std::string>();
         try {
-            Parser parser(str);
-            return parser.parse();
+            return parse_cache.parsed(str);
         } catch (const std::exception& e) {
-            return std::make_unique<Variable>(str);
+            return std::make_shared<Variable>(str);
         }
     }
     throw std::runtime_error("Unsupported value type for CAS operation");
 }
 
 // 辅助函数：将Expression转换为Lamina Value
-Value expressionToValue(const Expr& expr) {
-    if (const auto* num = dynamic_cast<const Number*>(&expr)) {
+// 数字结果仍返回普通数值，其余返回表达式树，打印时才格式化为字符串
+Value expressionToValue(ExprPtr expr) {
+    if (const auto* num = dynamic_cast<const Number*>(expr.get())) {
         return Value(num->getValue());
-    } else {
-        return Value(expr.toString());
     }
+    return Value(SharedExpr(std::move(expr)));
+}
+
+Value expressionToValue(const SharedExpr& expr) {
+    if (const auto* num = dynamic_cast<const Number*>(expr.get())) {
+        return Value(num->getValue());
+    }
+    return Value(expr);
+}
+
+void cas_expr_write_to(const SharedExpr& expr, std::string& out) {
+    if (!expr) {
+        out += "null";
+        return;
+    }
+    expr->writeTo(out);
 }
 
 // CAS函数实现
@@ -50,11 +145,8 @@ Value cas_parse(const std::vector<Value>& args) {
     }
 
     try {
-        std::string expr_str = std::get<std::string>(args[0].data);
-        Parser parser(expr_str);
-        auto expr = parser.parse();
-        auto simplified = expr->simplify();
-        return expressionToValue(*simplified);
+        const std::string& expr_str = args[0].get<std::string>();
+        return expressionToValue(parse_cache.simplified(expr_str));
     } catch (const std::exception& e) {
         std::cerr << "CAS Parse Error: " << e.what() << std::endl;
         return Value();
@@ -69,8 +161,7 @@ Value cas_simplify(const std::vector<Value>& args) {
 
     try {
         auto expr = valueToExpression(args[0]);
-        auto simplified = expr->simplify();
-        return expressionToValue(*simplified);
+        return expressionToValue(expr->simplify());
     } catch (const std::exception& e) {
         std::cerr << "CAS Simplify Error: " << e.what() << std::endl;
         return Value();
@@ -85,10 +176,9 @@ Value cas_differentiate(const std::vector<Value>& args) {
 
     try {
         auto expr = valueToExpression(args[0]);
-        std::string variable = std::get<std::string>(args[1].data);
+        std::string variable = args[1].get<std::string>();
         auto derivative = expr->differentiate(variable);
-        auto simplified = derivative->simplify();
-        return expressionToValue(*simplified);
+        return expressionToValue(derivative->simplify());
     } catch (const std::exception& e) {
         std::cerr << "CAS Differentiate Error: " << e.what() << std::endl;
         return Value();
@@ -108,7 +198,7 @@ Value cas_evaluate(const std::vector<Value>& args) {
         // 处理变量赋值
         for (size_t i = 1; i < args.size(); i++) {
             if (args[i].is_string()) {
-                std::string assignment = std::get<std::string>(args[i].data);
+                std::string assignment = args[i].get<std::string>();
                 size_t eq_pos = assignment.find('=');
                 if (eq_pos != std::string::npos) {
                     std::string var_name = assignment.substr(0, eq_pos);
@@ -135,9 +225,8 @@ Value cas_store(const std::vector<Value>& args) {
     }
 
     try {
-        std::string name = std::get<std::string>(args[0].data);
-        auto expr = valueToExpression(args[1]);
-        stored_expressions[name] = std::move(expr);
+        std::string name = args[0].get<std::string>();
+        stored_expressions[name] = valueToExpression(args[1]);
         return Value("Expression stored as: " + name);
     } catch (const std::exception& e) {
         std::cerr << "CAS Store Error: " << e.what() << std::endl;
@@ -153,10 +242,10 @@ Value cas_load(const std::vector<Value>& args) {
     }
 
     try {
-        std::string name = std::get<std::string>(args[0].data);
+        std::string name = args[0].get<std::string>();
         auto it = stored_expressions.find(name);
         if (it != stored_expressions.end()) {
-            return expressionToValue(*it->second);
+            return expressionToValue(it->second);
         } else {
             return Value("Expression not found: " + name);
         }
@@ -175,13 +264,13 @@ Value cas_evaluate_at(const std::vector<Value>& args) {
 
     try {
         auto expr = valueToExpression(args[0]);
-        std::string variable = std::get<std::string>(args[1].data);
+        std::string variable = args[1].get<std::string>();
 
         double point;
         if (args[2].is_int()) {
-            point = static_cast<double>(std::get<int>(args[2].data));
+            point = static_cast<double>(args[2].get<int>());
         } else if (args[2].is_float()) {
-            point = std::get<double>(args[2].data);
+            point = args[2].get<double>();
         } else {
             throw std::runtime_error("Point must be a number");
         }
@@ -204,15 +293,17 @@ Value cas_solve_linear(const std::vector<Value>& args) {
 
     try {
         auto expr = valueToExpression(args[0]);
-        std::string variable = std::get<std::string>(args[1].data);
+        std::string variable = args[1].get<std::string>();
 
         // 简单的线性方程求解：ax + b = 0 的解为 x = -b/a
         // 计算 f(0) 和 f(1) 来估算线性系数
-        std::map<std::string, double> vars_0 = {{variable, 0.0}};
-        std::map<std::string, double> vars_1 = {{variable, 1.0}};
+        const Program& prog = expr->program();
+        auto inputs = prog.bind({{variable, 0.0}});
+        const size_t slot = prog.slot_of(variable);
 
-        double f_0 = expr->evaluate(vars_0);    // b
-        double f_1 = expr->evaluate(vars_1);    // a + b
+        double f_0 = prog.evaluate(inputs.data());  // b
+        if (slot < inputs.size()) inputs[slot] = 1.0;
+        double f_1 = prog.evaluate(inputs.data());  // a + b
 
         double a = f_1 - f_0;   // 斜率
         double b = f_0;         // 截距
@@ -243,24 +334,26 @@ Value cas_numerical_derivative(const std::vector<Value>& args) {
 
     try {
         auto expr = valueToExpression(args[0]);
-        std::string variable = std::get<std::string>(args[1].data);
+        std::string variable = args[1].get<std::string>();
         double point;
 
         if (args[2].is_int()) {
-            point = static_cast<double>(std::get<int>(args[2].data));
+            point = static_cast<double>(args[2].get<int>());
         } else if (args[2].is_float()) {
-            point = std::get<double>(args[2].data);
+            point = args[2].get<double>();
         } else {
             throw std::runtime_error("Point must be a number");
         }
 
         // 使用差分近似求导数：f'(x) ≈ (f(x+h) - f(x-h)) / (2h)
         double h = 1e-8;
-        std::map<std::string, double> vars_plus = {{variable, point + h}};
-        std::map<std::string, double> vars_minus = {{variable, point - h}};
+        const Program& prog = expr->program();
+        auto inputs = prog.bind({{variable, point + h}});
+        const size_t slot = prog.slot_of(variable);
 
-        double f_plus = expr->evaluate(vars_plus);
-        double f_minus = expr->evaluate(vars_minus);
+        double f_plus = prog.evaluate(inputs.data());
+        if (slot < inputs.size()) inputs[slot] = point - h;
+        double f_minus = prog.evaluate(inputs.data());
 
         double derivative = (f_plus - f_minus) / (2 * h);
         return Value(derivative);
@@ -270,3 +363,439 @@ Value cas_numerical_derivative(const std::vector<Value>& args) {
         return Value();
     }
 }
+
+// 解析缓存统计
+Value cas_cache_stats(const std::vector<Value>& args) {
+    if (!args.empty()) {
+        std::cerr << "Error: cas_cache_stats() takes no arguments" << std::endl;
+        return Value();
+    }
+
+    const auto stats = parse_cache.stats();
+    std::vector<std::pair<std::string, Value>> fields = {
+        {"hits", Value(static_cast<int>(stats.hits))},
+        {"misses", Value(static_cast<int>(stats.misses))},
+        {"size", Value(static_cast<int>(stats.size))},
+        {"capacity", Value(static_cast<int>(ParseCache::capacity))},
+    };
+    return {std::make_shared<lmStruct>(fields)};
+}
+
+// 取出一列数值
+static std::vector<double> toDoubleColumn(const std::vector<Value>& arr) {
+    std::vector<double> column;
+    column.reserve(arr.size());
+    for (const auto& v : arr) {
+        if (!v.is_numeric()) {
+            throw std::runtime_error("Values must be an array of numbers");
+        }
+        column.push_back(v.as_number());
+    }
+    return column;
+}
+
+// 按槽位绑定变量：返回每个槽位对应的 names 下标
+static std::vector<size_t> bindSlots(const Program& prog, const std::vector<std::string>& names) {
+    std::vector<size_t> binding;
+    binding.reserve(prog.slots().size());
+    for (const auto& slot : prog.slots()) {
+        auto it = std::find(names.begin(), names.end(), slot);
+        if (it == names.end()) {
+            throw std::runtime_error("Variable " + slot + " not found");
+        }
+        binding.push_back(it - names.begin());
+    }
+    return binding;
+}
+
+// 批量求值：表达式只编译一次，点数较多时按区间分给多个线程
+static std::vector<double> runBatch(const Program& prog, const std::vector<const double*>& inputs, size_t n) {
+    std::vector<double> out(n);
+    constexpr size_t parallel_threshold = 1 << 16;
+    const size_t workers = std::min<size_t>(std::thread::hardware_concurrency(), n / parallel_threshold + 1);
+    if (workers <= 1) {
+        prog.run(inputs.data(), out.data(), n);
+        return out;
+    }
+
+    std::vector<std::thread> threads;
+    const size_t step = (n + workers - 1) / workers;
+    for (size_t begin = 0; begin < n; begin += step) {
+        const size_t count = std::min(step, n - begin);
+        threads.emplace_back([&prog, &inputs, &out, begin, count] {
+            std::vector<const double*> shifted(inputs.size());
+            for (size_t i = 0; i < inputs.size(); i++) shifted[i] = inputs[i] + begin;
+            prog.run(shifted.data(), out.data() + begin, count);
+        });
+    }
+    for (auto& t : threads) t.join();
+    return out;
+}
+
+// 对数组批量求值
+// cas_evaluate_batch(expr, "x", [..])
+// cas_evaluate_batch(expr, ["x", "y"], [[..], [..]])
+Value cas_evaluate_batch(const std::vector<Value>& args) {
+    if (args.size() != 3 || !(args[1].is_string() || args[1].is_array()) || !(args[2].is_array() || args[2].is_matrix())) {
+        std::cerr << "Error: cas_evaluate_batch() requires expression, variable(s), and array of values" << std::endl;
+        return Value();
+    }
+
+    try {
+        auto expr = valueToExpression(args[0]);
+
+        std::vector<std::string> names;
+        std::vector<std::vector<double>> columns;
+        if (args[1].is_string()) {
+            if (!args[2].is_array()) {
+                throw std::runtime_error("Values must be an array of numbers");
+            }
+            names.push_back(args[1].get<std::string>());
+            columns.push_back(toDoubleColumn(args[2].get<std::vector<Value>>()));
+        } else {
+            // 多个变量时每行是一个变量的取值
+            if (!args[2].is_matrix()) {
+                throw std::runtime_error("Values must be one array per variable");
+            }
+            const auto& vars = args[1].get<std::vector<Value>>();
+            const auto& values = args[2].get<std::vector<std::vector<Value>>>();
+            if (vars.size() != values.size()) {
+                throw std::runtime_error("Number of variables and value arrays must match");
+            }
+            for (size_t i = 0; i < vars.size(); i++) {
+                if (!vars[i].is_string()) {
+                    throw std::runtime_error("Variable names must be strings");
+                }
+                names.push_back(vars[i].get<std::string>());
+                columns.push_back(toDoubleColumn(values[i]));
+            }
+        }
+
+        const size_t n = columns.empty() ? 0 : columns[0].size();
+        for (const auto& column : columns) {
+            if (column.size() != n) {
+                throw std::runtime_error("Value arrays must have the same length");
+            }
+        }
+
+        const Program& prog = expr->program();
+
+        std::vector<const double*> inputs;
+        for (size_t index : bindSlots(prog, names)) inputs.push_back(columns[index].data());
+
+        auto out = runBatch(prog, inputs, n);
+        std::vector<Value> result;
+        result.reserve(n);
+        for (double v : out) result.emplace_back(v);
+        return Value(result);
+    } catch (const std::exception& e) {
+        std::cerr << "CAS Evaluate Batch Error: " << e.what() << std::endl;
+        return Value();
+    }
+}
+
+// 取出精确系数，浮点数按其二进制值精确转换
+static ::Rational toExactRational(const Value& value) {
+    if (value.is_int()) return ::Rational(value.get<int>());
+    if (value.is_bigint()) return ::Rational(value.get<::BigInt>());
+    if (value.is_rational()) return value.get<::Rational>();
+    if (value.is_float()) return ::Rational::from_double(value.get<double>());
+    throw std::runtime_error("Coefficients must be integers, rationals or floats");
+}
+
+// 整数结果还原为 int 或 BigInt
+static Value exactToValue(const ::Rational& q) {
+    if (!q.is_integer()) return Value(q);
+    ::BigInt n = q.get_numerator();
+    if (n >= ::BigInt(INT_MIN) && n <= ::BigInt(INT_MAX)) return Value(n.to_int());
+    return Value(n);
+}
+
+// 精确求解线性方程组 A x = b
+Value cas_solve_system(const std::vector<Value>& args) {
+    if (args.size() != 2 || !args[0].is_matrix() || !args[1].is_array()) {
+        std::cerr << "Error: cas_solve_system() requires coefficient matrix and right-hand side array" << std::endl;
+        return Value();
+    }
+
+    try {
+        const auto& mat = args[0].get<std::vector<std::vector<Value>>>();
+        const auto& rhs = args[1].get<std::vector<Value>>();
+
+        std::vector<std::vector<::Rational>> a(mat.size());
+        for (size_t i = 0; i < mat.size(); i++) {
+            a[i].reserve(mat[i].size());
+            for (const auto& v : mat[i]) a[i].push_back(toExactRational(v));
+        }
+        std::vector<::Rational> b;
+        b.reserve(rhs.size());
+        for (const auto& v : rhs) b.push_back(toExactRational(v));
+
+        auto solution = solve_linear_exact(a, b);
+        if (!solution) {
+            return Value("No unique solution");
+        }
+        std::vector<Value> result;
+        result.reserve(solution->size());
+        for (const auto& q : *solution) result.push_back(exactToValue(q));
+        return Value(result);
+    } catch (const std::exception& e) {
+        std::cerr << "CAS Solve System Error: " << e.what() << std::endl;
+        return Value();
+    }
+}
+
+// 读取变量名与取值：单个变量时为字符串和数值，多个变量时为两个等长数组
+static void readPoint(const Value& vars, const Value& point, std::vector<std::string>& names, std::vector<double>& values) {
+    if (vars.is_string() && point.is_numeric()) {
+        names.push_back(vars.get<std::string>());
+        values.push_back(point.as_number());
+        return;
+    }
+    if (!vars.is_array() || !point.is_array()) {
+        throw std::runtime_error("Variables and point must be a name and a number, or two arrays");
+    }
+    const auto& var_list = vars.get<std::vector<Value>>();
+    const auto& point_list = point.get<std::vector<Value>>();
+    if (var_list.size() != point_list.size()) {
+        throw std::runtime_error("Number of variables and values must match");
+    }
+    for (size_t i = 0; i < var_list.size(); i++) {
+        if (!var_list[i].is_string() || !point_list[i].is_numeric()) {
+            throw std::runtime_error("Variables must be names and values must be numbers");
+        }
+        names.push_back(var_list[i].get<std::string>());
+        values.push_back(point_list[i].as_number());
+    }
+}
+
+// 把 Lamina 匿名函数编译成寄存器程序，供自动微分使用
+// 函数体须为直线型代码：若干 var 声明或赋值，最后 return 一个算术表达式；
+// 支持 + - * / ^、取负、数字、参数与局部变量，以及 sqrt、log、sin、cos、tan、pow、pi、e
+// 参数按声明顺序占用槽位 0..n-1
+namespace {
+    class LambdaCompiler {
+    public:
+        explicit LambdaCompiler(Program& prog) : prog(prog) {}
+
+        void compile(const LambdaDeclExpr& func) {
+            for (const auto& param : func.params) locals[param] = prog.load(param);
+            if (func.body) {
+                for (const auto& stmt : func.body->statements) {
+                    if (!stmt) continue;  // 空行
+                    if (const auto* ret = dynamic_cast<const ReturnStmt*>(stmt.get()); ret && ret->expr) {
+                        size_t r = expr(*ret->expr);
+                        // 返回值是参数或局部变量时，补一条指令使结果落在最后一个寄存器
+                        if (r != prog.size() - 1) prog.binary(Program::Op::Mul, r, prog.constant(1.0));
+                        return;
+                    }
+                    if (const auto* decl = dynamic_cast<const VarDeclStmt*>(stmt.get()); decl && decl->expr) {
+                        locals[decl->name] = expr(*decl->expr);
+                    } else if (const auto* assign = dynamic_cast<const AssignStmt*>(stmt.get()); assign && assign->expr) {
+                        locals[assign->name] = expr(*assign->expr);
+                    } else {
+                        throw std::runtime_error("Lambda body must be var declarations followed by return");
+                    }
+                }
+            }
+            throw std::runtime_error("Lambda must return an arithmetic expression");
+        }
+
+    private:
+        using Op = Program::Op;
+
+        size_t expr(const Expression& e) {
+            if (const auto* lit = dynamic_cast<const LiteralExpr*>(&e)) {
+                if (lit->type != Value::Type::Int) throw std::runtime_error("Unsupported literal in lambda: " + lit->value);
+                return prog.constant(std::stod(lit->value));
+            }
+            if (const auto* id = dynamic_cast<const IdentifierExpr*>(&e)) return name(id->name);
+            if (const auto* var = dynamic_cast<const VarExpr*>(&e)) return name(var->name);
+            if (const auto* un = dynamic_cast<const UnaryExpr*>(&e); un && un->op == "-") {
+                size_t x = expr(*un->operand);
+                return prog.binary(Op::Mul, x, prog.constant(-1.0));
+            }
+            if (const auto* bin = dynamic_cast<const BinaryExpr*>(&e)) {
+                size_t l = expr(*bin->left);
+                size_t r = expr(*bin->right);
+                if (bin->op == "+") return prog.binary(Op::Add, l, r);
+                if (bin->op == "-") return prog.binary(Op::Add, l, prog.binary(Op::Mul, r, prog.constant(-1.0)));
+                if (bin->op == "*") return prog.binary(Op::Mul, l, r);
+                if (bin->op == "/") return prog.binary(Op::Mul, l, prog.binary(Op::Pow, r, prog.constant(-1.0)));
+                if (bin->op == "^") return prog.binary(Op::Pow, l, r);
+                throw std::runtime_error("Unsupported operator in lambda: " + bin->op);
+            }
+            if (const auto* call = dynamic_cast<const CallExpr*>(&e)) {
+                const auto* callee = dynamic_cast<const IdentifierExpr*>(call->callee.get());
+                if (!callee) throw std::runtime_error("Unsupported call in lambda");
+                return function(callee->name, call->args);
+            }
+            throw std::runtime_error("Unsupported expression in lambda");
+        }
+
+        size_t function(const std::string& fn, const std::vector<std::unique_ptr<Expression>>& args) {
+            auto arity = [&](size_t n) {
+                if (args.size() != n) throw std::runtime_error(fn + "() takes " + std::to_string(n) + " argument(s)");
+            };
+            if (fn == "pi") {
+                arity(0);
+                return prog.constant(3.14159265358979323846);
+            }
+            if (fn == "e") {
+                arity(0);
+                return prog.constant(2.718281828459045);
+            }
+            if (fn == "pow") {
+                arity(2);
+                size_t b = expr(*args[0]);
+                size_t x = expr(*args[1]);
+                return prog.binary(Op::Pow, b, x);
+            }
+            arity(1);
+            if (fn == "sqrt") {
+                size_t x = expr(*args[0]);
+                return prog.binary(Op::Pow, x, prog.constant(0.5));
+            }
+            static const std::map<std::string, Op> unary = {
+                {"log", Op::Log}, {"sin", Op::Sin}, {"cos", Op::Cos}, {"tan", Op::Tan}};
+            auto it = unary.find(fn);
+            if (it == unary.end()) throw std::runtime_error("Unsupported function in lambda: " + fn);
+            return prog.unary(it->second, expr(*args[0]));
+        }
+
+        size_t name(const std::string& n) {
+            auto it = locals.find(n);
+            if (it == locals.end()) throw std::runtime_error("Unknown variable in lambda: " + n);
+            return it->second;
+        }
+
+        Program& prog;
+        std::map<std::string, size_t> locals;
+    };
+}
+
+// 编译匿名函数，slots() 即按顺序排列的参数
+static Program compileLambda(const Value& func) {
+    Program prog;
+    LambdaCompiler(prog).compile(*func.get<std::shared_ptr<LambdaDeclExpr>>());
+    return prog;
+}
+
+// 匿名函数的取值：单个参数时可直接给数值，否则为与参数等长的数组
+static std::vector<double> readArguments(const Value& point, size_t count) {
+    std::vector<double> values;
+    if (point.is_numeric()) {
+        values.push_back(point.as_number());
+    } else if (point.is_array()) {
+        for (const auto& v : point.get<std::vector<Value>>()) {
+            if (!v.is_numeric()) throw std::runtime_error("Values must be numbers");
+            values.push_back(v.as_number());
+        }
+    } else {
+        throw std::runtime_error("Point must be a number or an array of numbers");
+    }
+    if (values.size() != count) throw std::runtime_error("Number of values must match the lambda parameters");
+    return values;
+}
+
+// 前向模式自动微分求导数值
+// cas_derivative_at(expr, "x", 2)
+// cas_derivative_at(expr, "x", ["x", "y"], [2, 3])
+// cas_derivative_at(|x| x^2, 3)
+// cas_derivative_at(|x, y| x * y, "y", [2, 3])
+Value cas_derivative_at(const std::vector<Value>& args) {
+    if (!args.empty() && args[0].is_lambda()) {
+        if ((args.size() != 2 && args.size() != 3) || (args.size() == 3 && !args[1].is_string())) {
+            std::cerr << "Error: cas_derivative_at() requires lambda, optional parameter name, and point" << std::endl;
+            return Value();
+        }
+        try {
+            const Program prog = compileLambda(args[0]);
+            const auto values = readArguments(args.back(), prog.slots().size());
+            size_t wrt = 0;
+            if (args.size() == 3) {
+                wrt = prog.slot_of(args[1].get<std::string>());
+                if (wrt == prog.slots().size()) throw std::runtime_error("Lambda has no parameter " + args[1].get<std::string>());
+            }
+            return Value(prog.forward(values.data(), wrt).second);
+        } catch (const std::exception& e) {
+            std::cerr << "CAS Derivative At Error: " << e.what() << std::endl;
+            return Value();
+        }
+    }
+    if ((args.size() != 3 && args.size() != 4) || !args[1].is_string()) {
+        std::cerr << "Error: cas_derivative_at() requires expression, variable, and point" << std::endl;
+        return Value();
+    }
+
+    try {
+        auto expr = valueToExpression(args[0]);
+        const std::string& variable = args[1].get<std::string>();
+        std::vector<std::string> names;
+        std::vector<double> values;
+        if (args.size() == 3) {
+            readPoint(args[1], args[2], names, values);
+        } else {
+            readPoint(args[2], args[3], names, values);
+        }
+
+        const Program& prog = expr->program();
+        const auto binding = bindSlots(prog, names);
+        std::vector<double> inputs(binding.size());
+        for (size_t i = 0; i < binding.size(); i++) inputs[i] = values[binding[i]];
+
+        // 表达式不含该变量时导数为 0
+        return Value(prog.forward(inputs.data(), prog.slot_of(variable)).second);
+    } catch (const std::exception& e) {
+        std::cerr << "CAS Derivative At Error: " << e.what() << std::endl;
+        return Value();
+    }
+}
+
+// 反向模式自动微分求梯度
+// cas_gradient(expr, ["x", "y"], [1, 2])
+// cas_gradient(|x, y| x * y, [1, 2])
+Value cas_gradient(const std::vector<Value>& args) {
+    if (args.size() == 2 && args[0].is_lambda()) {
+        try {
+            const Program prog = compileLambda(args[0]);
+            const auto values = readArguments(args[1], prog.slots().size());
+            std::vector<double> grad(values.size());
+            prog.gradient(values.data(), grad.data());
+            std::vector<Value> result;
+            result.reserve(grad.size());
+            for (double g : grad) result.emplace_back(g);
+            return Value(result);
+        } catch (const std::exception& e) {
+            std::cerr << "CAS Gradient Error: " << e.what() << std::endl;
+            return Value();
+        }
+    }
+    if (args.size() != 3) {
+        std::cerr << "Error: cas_gradient() requires expression, variables, and point" << std::endl;
+        return Value();
+    }
+
+    try {
+        auto expr = valueToExpression(args[0]);
+        std::vector<std::string> names;
+        std::vector<double> values;
+        readPoint(args[1], args[2], names, values);
+
+        const Program& prog = expr->program();
+        const auto binding = bindSlots(prog, names);
+        std::vector<double> inputs(binding.size());
+        for (size_t i = 0; i < binding.size(); i++) inputs[i] = values[binding[i]];
+
+        std::vector<double> grad(binding.size());
+        prog.gradient(inputs.data(), grad.data());
+
+        // 按调用者给出的变量顺序返回，未出现在表达式中的变量偏导为 0
+        std::vector<Value> result(names.size(), Value(0.0));
+        for (size_t i = 0; i < binding.size(); i++) result[binding[i]] = Value(grad[i]);
+        return Value(result);
+    } catch (const std::exception& e) {
+        std::cerr << "CAS Gradient Error: " << e.what() << std::endl;
+        return Value();
+    }
+}
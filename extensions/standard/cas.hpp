@@ -1,29 +1,348 @@
 // Lamina CAS系统 - 计算机代数系统
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 #include <cctype>
 
 namespace LaminaCAS {
 
+    // 编译后的表达式：树按后序展开成寄存器指令，每条指令的结果放在与其下标相同的寄存器里，
+    // 变量在编译时分配槽位，求值时按槽位直接取输入数组，不再查 map
+    // 批量求值按块进行，每条指令对整块数据做一次紧凑循环，便于编译器向量化
+    class Program {
+    public:
+        enum class Op { Const, Load, Add, Mul, Pow, Log, Sin, Cos, Tan };
+
+        struct Instr {
+            Op op;
+            size_t a = 0;       // 左操作数寄存器，Load 时为变量槽位
+            size_t b = 0;       // 右操作数寄存器，一元运算不用
+            double value = 0.0; // Const 的值
+        };
+
+        static constexpr size_t block = 256;
+
+        size_t constant(double v) {
+            return push({Op::Const, 0, 0, v});
+        }
+
+        size_t load(const std::string& name) {
+            auto it = std::find(variables.begin(), variables.end(), name);
+            size_t slot = it - variables.begin();
+            if (it == variables.end()) variables.push_back(name);
+            return push({Op::Load, slot, 0, 0.0});
+        }
+
+        size_t binary(Op op, size_t a, size_t b) {
+            // 常量折叠：两个常量须是最后两条指令，否则截断会删掉无关的指令
+            if (code[a].op == Op::Const && code[b].op == Op::Const
+                && std::max(a, b) == code.size() - 1 && std::min(a, b) == code.size() - 2) {
+                double x = code[a].value, y = code[b].value;
+                code.resize(std::min(a, b));
+                return constant(op == Op::Add ? x + y : op == Op::Mul ? x * y : std::pow(x, y));
+            }
+            // x^2 按乘法计算
+            if (op == Op::Pow && code[b].op == Op::Const && code[b].value == 2.0 && b == code.size() - 1) {
+                code.pop_back();
+                return push({Op::Mul, a, a, 0.0});
+            }
+            return push({op, a, b, 0.0});
+        }
+
+        // 一元函数（对数、三角函数），CAS 表达式不产生这些指令，只用于编译 Lamina 匿名函数
+        size_t unary(Op op, size_t a) {
+            if (code[a].op == Op::Const && a == code.size() - 1) {
+                double x = code[a].value;
+                code.pop_back();
+                return constant(apply(op, x));
+            }
+            return push({op, a, 0, 0.0});
+        }
+
+        // 指令条数，结果总在最后一个寄存器
+        size_t size() const { return code.size(); }
+
+        // 变量名，下标即槽位
+        const std::vector<std::string>& slots() const { return variables; }
+
+        // 变量 name 的槽位，不存在时返回 slots().size()
+        size_t slot_of(const std::string& name) const {
+            return std::find(variables.begin(), variables.end(), name) - variables.begin();
+        }
+
+        // 把按名字给出的变量值排成槽位数组
+        std::vector<double> bind(const std::map<std::string, double>& vars) const {
+            std::vector<double> inputs;
+            inputs.reserve(variables.size());
+            for (const auto& name : variables) {
+                auto it = vars.find(name);
+                if (it == vars.end()) {
+                    throw std::runtime_error("Variable " + name + " not found");
+                }
+                inputs.push_back(it->second);
+            }
+            return inputs;
+        }
+
+        // 单点求值：inputs[slot] 为各变量取值
+        double evaluate(const double* inputs) const {
+            if (code.empty()) return 0.0;
+            double* val = scratch(0, code.size());
+            for (size_t i = 0; i < code.size(); i++) {
+                const Instr& ins = code[i];
+                switch (ins.op) {
+                    case Op::Const: val[i] = ins.value; break;
+                    case Op::Load: val[i] = inputs[ins.a]; break;
+                    case Op::Add: val[i] = val[ins.a] + val[ins.b]; break;
+                    case Op::Mul: val[i] = val[ins.a] * val[ins.b]; break;
+                    case Op::Pow: val[i] = std::pow(val[ins.a], val[ins.b]); break;
+                    default: val[i] = apply(ins.op, val[ins.a]); break;
+                }
+            }
+            return val[code.size() - 1];
+        }
+
+        // 对 n 个点求值：inputs[slot] 指向该变量的 n 个取值，结果写入 out
+        void run(const double* const* inputs, double* out, size_t n) const {
+            if (code.empty()) return;
+            double* regs = scratch(0, code.size() * block);
+            std::vector<const double*> src(code.size());
+            for (size_t start = 0; start < n; start += block) {
+                const size_t m = std::min(block, n - start);
+                for (size_t i = 0; i < code.size(); i++) {
+                    const Instr& ins = code[i];
+                    double* dst = regs + i * block;
+                    src[i] = dst;
+                    switch (ins.op) {
+                        case Op::Const:
+                            std::fill(dst, dst + m, ins.value);
+                            break;
+                        case Op::Load:
+                            src[i] = inputs[ins.a] + start;
+                            break;
+                        case Op::Add: {
+                            const double* x = src[ins.a];
+                            const double* y = src[ins.b];
+                            for (size_t k = 0; k < m; k++) dst[k] = x[k] + y[k];
+                            break;
+                        }
+                        case Op::Mul: {
+                            const double* x = src[ins.a];
+                            const double* y = src[ins.b];
+                            for (size_t k = 0; k < m; k++) dst[k] = x[k] * y[k];
+                            break;
+                        }
+                        case Op::Pow: {
+                            const double* x = src[ins.a];
+                            const double* y = src[ins.b];
+                            for (size_t k = 0; k < m; k++) dst[k] = std::pow(x[k], y[k]);
+                            break;
+                        }
+                        default: {
+                            const double* x = src[ins.a];
+                            for (size_t k = 0; k < m; k++) dst[k] = apply(ins.op, x[k]);
+                            break;
+                        }
+                    }
+                }
+                const double* result = src.back();
+                std::copy(result, result + m, out + start);
+            }
+        }
+
+        // 前向模式自动微分（对偶数）：inputs[slot] 为各变量取值，对槽位 wrt 求导
+        // 返回 {函数值, 导数}，代价约为一次求值
+        std::pair<double, double> forward(const double* inputs, size_t wrt) const {
+            if (code.empty()) return {0.0, 0.0};
+            double* val = scratch(0, code.size());
+            double* dot = scratch(1, code.size());
+            for (size_t i = 0; i < code.size(); i++) {
+                const Instr& ins = code[i];
+                switch (ins.op) {
+                    case Op::Const:
+                        val[i] = ins.value;
+                        dot[i] = 0.0;
+                        break;
+                    case Op::Load:
+                        val[i] = inputs[ins.a];
+                        dot[i] = ins.a == wrt ? 1.0 : 0.0;
+                        break;
+                    case Op::Add:
+                        val[i] = val[ins.a] + val[ins.b];
+                        dot[i] = dot[ins.a] + dot[ins.b];
+                        break;
+                    case Op::Mul:
+                        val[i] = val[ins.a] * val[ins.b];
+                        dot[i] = dot[ins.a] * val[ins.b] + val[ins.a] * dot[ins.b];
+                        break;
+                    case Op::Pow: {
+                        const double x = val[ins.a], y = val[ins.b];
+                        val[i] = std::pow(x, y);
+                        dot[i] = pow_partial_base(x, y) * dot[ins.a];
+                        if (dot[ins.b] != 0.0) dot[i] += pow_partial_exponent(x, val[i]) * dot[ins.b];
+                        break;
+                    }
+                    default:
+                        val[i] = apply(ins.op, val[ins.a]);
+                        dot[i] = unary_partial(ins.op, val[ins.a]) * dot[ins.a];
+                        break;
+                }
+            }
+            return {val[code.size() - 1], dot[code.size() - 1]};
+        }
+
+        // 反向模式自动微分：一次正向求值加一次反向传播得到全部偏导
+        // grad[slot] 写入对各变量的偏导，返回函数值
+        double gradient(const double* inputs, double* grad) const {
+            std::fill(grad, grad + variables.size(), 0.0);
+            if (code.empty()) return 0.0;
+            double* val = scratch(0, code.size());
+            for (size_t i = 0; i < code.size(); i++) {
+                const Instr& ins = code[i];
+                switch (ins.op) {
+                    case Op::Const: val[i] = ins.value; break;
+                    case Op::Load: val[i] = inputs[ins.a]; break;
+                    case Op::Add: val[i] = val[ins.a] + val[ins.b]; break;
+                    case Op::Mul: val[i] = val[ins.a] * val[ins.b]; break;
+                    case Op::Pow: val[i] = std::pow(val[ins.a], val[ins.b]); break;
+                    default: val[i] = apply(ins.op, val[ins.a]); break;
+                }
+            }
+
+            double* adj = scratch(1, code.size());
+            std::fill(adj, adj + code.size(), 0.0);
+            adj[code.size() - 1] = 1.0;
+            for (size_t i = code.size(); i-- > 0;) {
+                const Instr& ins = code[i];
+                const double g = adj[i];
+                if (g == 0.0) continue;
+                switch (ins.op) {
+                    case Op::Const:
+                        break;
+                    case Op::Load:
+                        grad[ins.a] += g;
+                        break;
+                    case Op::Add:
+                        adj[ins.a] += g;
+                        adj[ins.b] += g;
+                        break;
+                    case Op::Mul:
+                        adj[ins.a] += g * val[ins.b];
+                        adj[ins.b] += g * val[ins.a];
+                        break;
+                    case Op::Pow:
+                        adj[ins.a] += g * pow_partial_base(val[ins.a], val[ins.b]);
+                        if (code[ins.b].op != Op::Const) adj[ins.b] += g * pow_partial_exponent(val[ins.a], val[i]);
+                        break;
+                    default:
+                        adj[ins.a] += g * unary_partial(ins.op, val[ins.a]);
+                        break;
+                }
+            }
+            return val[code.size() - 1];
+        }
+
+    private:
+        // 每个线程复用的寄存器缓冲区，只增不减，求值时不再分配内存
+        // which 区分同一次求值中同时使用的两块缓冲区
+        static double* scratch(size_t which, size_t n) {
+            thread_local std::vector<double> buffers[2];
+            std::vector<double>& buf = buffers[which];
+            if (buf.size() < n) buf.resize(n);
+            return buf.data();
+        }
+
+        static double apply(Op op, double x) {
+            switch (op) {
+                case Op::Log: return std::log(x);
+                case Op::Sin: return std::sin(x);
+                case Op::Cos: return std::cos(x);
+                case Op::Tan: return std::tan(x);
+                default: return x;
+            }
+        }
+
+        // 一元函数在 x 处的导数
+        static double unary_partial(Op op, double x) {
+            switch (op) {
+                case Op::Log: return 1.0 / x;
+                case Op::Sin: return std::cos(x);
+                case Op::Cos: return -std::sin(x);
+                case Op::Tan: {
+                    const double c = std::cos(x);
+                    return 1.0 / (c * c);
+                }
+                default: return 0.0;
+            }
+        }
+
+        // ∂(x^y)/∂x = y·x^(y-1)
+        static double pow_partial_base(double x, double y) {
+            return y == 0.0 ? 0.0 : y * std::pow(x, y - 1.0);
+        }
+
+        // ∂(x^y)/∂y = x^y·ln x，x^y 为 0 时取 0
+        static double pow_partial_exponent(double x, double value) {
+            return value == 0.0 ? 0.0 : value * std::log(x);
+        }
+
+        size_t push(const Instr& ins) {
+            code.push_back(ins);
+            return code.size() - 1;
+        }
+
+        std::vector<Instr> code;
+        std::vector<std::string> variables;
+    };
+
     // 基础表达式类
     class Expr {
     public:
         virtual ~Expr() = default;
         virtual std::string toString() const = 0;
+        // 追加到 out 末尾，复合表达式直接写入子节点，不生成中间字符串
+        virtual void writeTo(std::string& out) const { out += toString(); }
         virtual std::unique_ptr<Expr> clone() const = 0;
         virtual std::unique_ptr<Expr> simplify() const = 0;
         virtual std::unique_ptr<Expr> differentiate(const std::string& var) const = 0;
-        virtual double evaluate(const std::map<std::string, double>& vars = {}) const = 0;
+        // 把表达式追加到 prog，返回结果所在的寄存器
+        virtual size_t compile(Program& prog) const = 0;
+
+        // 按变量名求值，只是对编译结果的包装：变量先换成槽位，再按槽位求值
+        double evaluate(const std::map<std::string, double>& vars = {}) const {
+            const Program& prog = program();
+            std::vector<double> inputs = prog.bind(vars);
+            return prog.evaluate(inputs.data());
+        }
+
+        // 编译结果，首次使用时生成；表达式不可变，之后一直复用
+        const Program& program() const {
+            std::call_once(compiled_once, [this] {
+                auto prog = std::make_unique<Program>();
+                compile(*prog);
+                compiled = std::move(prog);
+            });
+            return *compiled;
+        }
+
+    private:
+        mutable std::once_flag compiled_once;
+        mutable std::unique_ptr<Program> compiled;
     };
 
     using ExprPtr = std::unique_ptr<Expr>;
+    // 作为 Lamina 值保存的表达式，只读共享
+    using SharedExpr = std::shared_ptr<const Expr>;
 
     // 数字表达式
     class Number : public Expr {
@@ -51,8 +370,8 @@ namespace LaminaCAS {
             return std::make_unique<Number>(0);
         }
 
-        double evaluate(const std::map<std::string, double>& vars = {}) const override {
-            return value;
+        size_t compile(Program& prog) const override {
+            return prog.constant(value);
         }
 
         double getValue() const { return value; }
@@ -86,12 +405,8 @@ namespace LaminaCAS {
             return std::make_unique<Number>(0);
         }
 
-        double evaluate(const std::map<std::string, double>& vars = {}) const override {
-            auto it = vars.find(name);
-            if (it != vars.end()) {
-                return it->second;
-            }
-            throw std::runtime_error("Variable " + name + " not found");
+        size_t compile(Program& prog) const override {
+            return prog.load(name);
         }
 
         const std::string& getName() const { return name; }
@@ -104,42 +419,37 @@ namespace LaminaCAS {
     public:
         Add(ExprPtr l, ExprPtr r) : left(std::move(l)), right(std::move(r)) {}
 
+        const Expr& getLeft() const { return *left; }
+        const Expr& getRight() const { return *right; }
+
         std::string toString() const override {
-            return "(" + left->toString() + " + " + right->toString() + ")";
+            std::string out;
+            writeTo(out);
+            return out;
+        }
+
+        void writeTo(std::string& out) const override {
+            out += '(';
+            left->writeTo(out);
+            out += " + ";
+            right->writeTo(out);
+            out += ')';
         }
 
         ExprPtr clone() const override {
             return std::make_unique<Add>(left->clone(), right->clone());
         }
 
-        ExprPtr simplify() const override {
-            auto l = left->simplify();
-            auto r = right->simplify();
-
-            // 0 + x = x
-            if (auto ln = dynamic_cast<Number*>(l.get())) {
-                if (ln->isZero()) return r;
-            }
-            // x + 0 = x
-            if (auto rn = dynamic_cast<Number*>(r.get())) {
-                if (rn->isZero()) return l;
-            }
-            // num + num = num
-            if (auto ln = dynamic_cast<Number*>(l.get())) {
-                if (auto rn = dynamic_cast<Number*>(r.get())) {
-                    return std::make_unique<Number>(ln->getValue() + rn->getValue());
-                }
-            }
-
-            return std::make_unique<Add>(std::move(l), std::move(r));
-        }
+        ExprPtr simplify() const override;
 
         ExprPtr differentiate(const std::string& var) const override {
             return std::make_unique<Add>(left->differentiate(var), right->differentiate(var));
         }
 
-        double evaluate(const std::map<std::string, double>& vars = {}) const override {
-            return left->evaluate(vars) + right->evaluate(vars);
+        size_t compile(Program& prog) const override {
+            size_t l = left->compile(prog);
+            size_t r = right->compile(prog);
+            return prog.binary(Program::Op::Add, l, r);
         }
     };
 
@@ -150,8 +460,21 @@ namespace LaminaCAS {
     public:
         Multiply(ExprPtr l, ExprPtr r) : left(std::move(l)), right(std::move(r)) {}
 
+        const Expr& getLeft() const { return *left; }
+        const Expr& getRight() const { return *right; }
+
         std::string toString() const override {
-            return "(" + left->toString() + " * " + right->toString() + ")";
+            std::string out;
+            writeTo(out);
+            return out;
+        }
+
+        void writeTo(std::string& out) const override {
+            out += '(';
+            left->writeTo(out);
+            out += " * ";
+            right->writeTo(out);
+            out += ')';
         }
 
         ExprPtr clone() const override {
@@ -191,8 +514,10 @@ namespace LaminaCAS {
             return std::make_unique<Add>(std::move(fg_prime), std::move(gf_prime));
         }
 
-        double evaluate(const std::map<std::string, double>& vars = {}) const override {
-            return left->evaluate(vars) * right->evaluate(vars);
+        size_t compile(Program& prog) const override {
+            size_t l = left->compile(prog);
+            size_t r = right->compile(prog);
+            return prog.binary(Program::Op::Mul, l, r);
         }
     };
 
@@ -204,7 +529,17 @@ namespace LaminaCAS {
         Power(ExprPtr b, ExprPtr e) : base(std::move(b)), exponent(std::move(e)) {}
 
         std::string toString() const override {
-            return "(" + base->toString() + " ^ " + exponent->toString() + ")";
+            std::string out;
+            writeTo(out);
+            return out;
+        }
+
+        void writeTo(std::string& out) const override {
+            out += '(';
+            base->writeTo(out);
+            out += " ^ ";
+            exponent->writeTo(out);
+            out += ')';
         }
 
         ExprPtr clone() const override {
@@ -250,11 +585,86 @@ namespace LaminaCAS {
             throw std::runtime_error("Differentiation of general exponentials not implemented");
         }
 
-        double evaluate(const std::map<std::string, double>& vars = {}) const override {
-            return std::pow(base->evaluate(vars), exponent->evaluate(vars));
+        size_t compile(Program& prog) const override {
+            size_t b = base->compile(prog);
+            size_t e = exponent->compile(prog);
+            return prog.binary(Program::Op::Pow, b, e);
         }
     };
 
+    inline ExprPtr Add::simplify() const {
+        auto l = left->simplify();
+        auto r = right->simplify();
+
+        // 0 + x = x
+        if (auto ln = dynamic_cast<Number*>(l.get())) {
+            if (ln->isZero()) return r;
+        }
+        // x + 0 = x
+        if (auto rn = dynamic_cast<Number*>(r.get())) {
+            if (rn->isZero()) return l;
+        }
+        // num + num = num
+        if (auto ln = dynamic_cast<Number*>(l.get())) {
+            if (auto rn = dynamic_cast<Number*>(r.get())) {
+                return std::make_unique<Number>(ln->getValue() + rn->getValue());
+            }
+        }
+
+        // 合并同类项：把和拆成 系数 * 项，按项的打印形式归并系数，常数归为一组
+        // 各组保持第一次出现的顺序；没有可合并的项时保留原来的结构
+        struct Term {
+            std::string key;
+            double coeff;
+            const Expr* rest;// 常数组为 nullptr
+        };
+        std::vector<Term> groups;
+        size_t count = 0;
+        std::vector<const Expr*> stack{r.get(), l.get()};
+        while (!stack.empty()) {
+            const Expr* e = stack.back();
+            stack.pop_back();
+            if (auto sum = dynamic_cast<const Add*>(e)) {
+                stack.push_back(&sum->getRight());
+                stack.push_back(&sum->getLeft());
+                continue;
+            }
+            count++;
+            double coeff = 1.0;
+            const Expr* rest = e;
+            if (auto num = dynamic_cast<const Number*>(e)) {
+                coeff = num->getValue();
+                rest = nullptr;
+            } else if (auto mul = dynamic_cast<const Multiply*>(e)) {
+                if (auto n = dynamic_cast<const Number*>(&mul->getLeft())) {
+                    coeff = n->getValue();
+                    rest = &mul->getRight();
+                } else if (auto n = dynamic_cast<const Number*>(&mul->getRight())) {
+                    coeff = n->getValue();
+                    rest = &mul->getLeft();
+                }
+            }
+            std::string key = rest ? rest->toString() : std::string();
+            auto it = std::find_if(groups.begin(), groups.end(), [&](const Term& t) {
+                return (t.rest == nullptr) == (rest == nullptr) && t.key == key;
+            });
+            if (it == groups.end()) groups.push_back({std::move(key), coeff, rest});
+            else it->coeff += coeff;
+        }
+        if (groups.size() == count) return std::make_unique<Add>(std::move(l), std::move(r));
+
+        ExprPtr result;
+        for (const auto& t : groups) {
+            if (t.coeff == 0.0) continue;
+            ExprPtr term;
+            if (!t.rest) term = std::make_unique<Number>(t.coeff);
+            else if (t.coeff == 1.0) term = t.rest->clone();
+            else term = std::make_unique<Multiply>(std::make_unique<Number>(t.coeff), t.rest->clone());
+            result = result ? std::make_unique<Add>(std::move(result), std::move(term)) : std::move(term);
+        }
+        return result ? std::move(result) : std::make_unique<Number>(0);
+    }
+
     // 简单的解析器
     class Parser {
         std::string expr;
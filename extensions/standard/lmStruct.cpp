@@ -43,7 +43,7 @@ std::shared_ptr<Node> lmStruct::find(const std::string& key) const {
         return nullptr;
     }
     // 用get_if替代std::get，避免类型不匹配时抛异常
-    const auto parent_struct_ptr = std::get_if<std::shared_ptr<lmStruct>>(&parent_value.data);
+    const auto parent_struct_ptr = parent_value.get_if<std::shared_ptr<lmStruct>>();
     if (parent_struct_ptr == nullptr || *parent_struct_ptr == nullptr) {
         return nullptr;
     }
@@ -123,38 +123,25 @@ std::vector<std::pair<std::string, Value>> lmStruct::to_vector() const {
 
 
 std::string lmStruct::to_string() const {
-    std::stringstream ss;
-    ss << "{ ";
-
-    // 统计总节点数
-    size_t total_node_count = 0;
-    for (const std::shared_ptr<Node>& bucket_head : buckets_) {
-        auto current = bucket_head;
-        while (current != nullptr) {
-            total_node_count++;
-            current = current->next;
-        }
-    }
+    std::string out;
+    write_to(out);
+    return out;
+}
 
-    // 添加键值对
-    size_t current_node_idx = 0;  // 记录当前节点
+void lmStruct::write_to(std::string& out) const {
+    out += "{ ";
+    bool first = true;
     for (const std::shared_ptr<Node>& bucket_head : buckets_) {
-        auto current = bucket_head;
-        while (current != nullptr) {
+        for (auto current = bucket_head; current != nullptr; current = current->next) {
             // 写入当前键值对
-            ss << current->key << ": " << current->value.to_string();
-
-            if (current_node_idx < total_node_count - 1) {
-                ss << ", ";
-            }
-
-            current = current->next;
-            current_node_idx++;  // 更新节点索引
+            if (!first) out += ", ";
+            first = false;
+            out += current->key;
+            out += ": ";
+            current->value.write_to(out);
         }
     }
-
-    ss << " }";
-    return ss.str();  // 转换为string返回
+    out += " }";
 }
 
 
@@ -164,8 +151,8 @@ Value new_lm_struct(const std::vector<std::pair<std::string, Value>>& vec) {
 }
 
 Value getattr(const std::vector<Value>& args) {
-    const auto& lstruct_ = std::get<std::shared_ptr<lmStruct>>(args[0].data);
-    const auto& attr_name = std::get<std::string>(args[1].data);
+    const auto& lstruct_ = args[0].get<std::shared_ptr<lmStruct>>();
+    const auto& attr_name = args[1].get<std::string>();
     auto res = lstruct_->find(attr_name);
     if (res == nullptr) {
         L_ERR("AttrError: struct hasn't attribute named " + attr_name);
@@ -175,16 +162,16 @@ Value getattr(const std::vector<Value>& args) {
 }
 
 Value setattr(const std::vector<Value>& args) {
-    std::shared_ptr<lmStruct> lstruct_ = std::get<std::shared_ptr<lmStruct>>(args[0].data);
-    const auto& attr_name = std::get<std::string>(args[1].data);
+    std::shared_ptr<lmStruct> lstruct_ = args[0].get<std::shared_ptr<lmStruct>>();
+    const auto& attr_name = args[1].get<std::string>();
     Value value = args[2];
     lstruct_->insert(attr_name, value);
     return LAMINA_NULL;
 }
 
 Value update(const std::vector<Value>& args) {
-    std::shared_ptr<lmStruct> lstruct_a = std::get<std::shared_ptr<lmStruct>>(args[0].data);
-    const auto& lstruct_b = std::get<std::shared_ptr<lmStruct>>(args[1].data);
+    std::shared_ptr<lmStruct> lstruct_a = args[0].get<std::shared_ptr<lmStruct>>();
+    const auto& lstruct_b = args[1].get<std::shared_ptr<lmStruct>>();
     auto vec = lstruct_b->to_vector();
     for (auto& [key, val]: vec) {
         lstruct_a->insert(key, val);
@@ -194,8 +181,7 @@ Value update(const std::vector<Value>& args) {
 
 Value copy_struct(const std::vector<Value>& args){
     if (args.empty()) return LAMINA_NULL;
-    const auto& arg_data = args[0].data;
-    auto& original_ptr = std::get<std::shared_ptr<lmStruct>>(arg_data);
+    const auto& original_ptr = args[0].get<std::shared_ptr<lmStruct>>();
 
     if (!original_ptr) return LAMINA_NULL;
 
@@ -212,10 +198,17 @@ std::string lStruct_to_string(const std::shared_ptr<lmStruct>& lstruct) {
     return lstruct->to_string();
 }
 
+void lStruct_write_to(const std::shared_ptr<lmStruct>& lstruct, std::string& out) {
+    if (lstruct == nullptr) {
+        out += "{}";
+        return;
+    }
+    lstruct->write_to(out);
+}
+
 Value new_struct_from(const std::vector<Value>& args) {
     check_cpp_function_argv(args, {Value::Type::lmStruct});
-    const auto arg_data = args[0].data;
-    const auto original_ptr = std::get<std::shared_ptr<lmStruct>>(arg_data);
+    const auto original_ptr = args[0].get<std::shared_ptr<lmStruct>>();
 
     if (!original_ptr) return LAMINA_NULL;
 
@@ -230,8 +223,8 @@ Value is_same_thing(const std::vector<Value>& args) {
     check_cpp_function_argv(args,
     {Value::Type::lmStruct, Value::Type::lmStruct}
     );
-    const auto arg_0 = std::get<std::shared_ptr<lmStruct>>(args[0].data);
-    const auto arg_1 = std::get<std::shared_ptr<lmStruct>>(args[1].data);
+    const auto arg_0 = args[0].get<std::shared_ptr<lmStruct>>();
+    const auto arg_1 = args[1].get<std::shared_ptr<lmStruct>>();
     if (arg_0.get() == arg_1.get()) {
         return LAMINA_BOOL(true);
     }
@@ -84,6 +84,8 @@ public:
     [[nodiscard]] std::shared_ptr<Node> find(const std::string& key) const;
     [[nodiscard]] std::shared_ptr<Node> find_in_current(const std::string& key) const;
     [[nodiscard]] std::string to_string() const;
+    // 追加到 out 末尾
+    void write_to(std::string& out) const;
     [[nodiscard]] std::vector<std::pair<std::string, Value>> to_vector() const;
     // 深拷贝结构体
     lmStruct(const lmStruct& other)
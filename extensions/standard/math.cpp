@@ -1,4 +1,5 @@
 #include "../../interpreter/lamina_api/lamina.hpp"
+#include "../../interpreter/lamina_api/lu.hpp"
 // #include "latex.hpp"
 #include "../../interpreter/lamina_api/symbolic.hpp"
 #include "../../interpreter/lamina_api/value.hpp"
@@ -13,9 +14,12 @@
  * - 对于浮点数等其他类型，使用标准库函数计算近似值。
  * 
  * @param args 参数列表，要求包含一个数值类型的参数
- * @return Value 平方根的结果，可能为数值或符号表达式
+ * @return Value 平方根的结果，可能为数值、无理数或符号表达式
  */
 Value sqrt_(const std::vector<Value>& args) {
+    if (args[0].is_numarray()) {
+        return args[0].get<NumArray>().map([](double x) { return std::sqrt(x); });
+    }
     if (!args[0].is_numeric()) {
         std::cerr << "Error: sqrt() requires numeric argument" << std::endl;
         return Value();
@@ -29,7 +33,7 @@ Value sqrt_(const std::vector<Value>& args) {
 
     // Handle integer case - return symbolic result
     if (args[0].is_int()) {
-        int val = std::get<int>(args[0].data);
+        int val = args[0].get<int>();
         if (val == 0 || val == 1) {
             return Value(val);  // sqrt(0) = 0, sqrt(1) = 1
         }
@@ -40,15 +44,13 @@ Value sqrt_(const std::vector<Value>& args) {
             return Value(sqrt_val);
         }
 
-        // Return symbolic expression for non-perfect squares
-        auto symbolic_arg = SymbolicExpr::number(val);
-        auto symbolic_sqrt = SymbolicExpr::sqrt(symbolic_arg);
-        return Value(symbolic_sqrt->simplify());
+        // 非完全平方数返回精确的二次无理数
+        return Value(::Irrational::sqrt(val, ::Rational(1)));
     }
 
     // Handle BigInt case - return symbolic result
     if (args[0].is_bigint()) {
-        const auto& bi = std::get<::BigInt>(args[0].data);
+        const auto& bi = args[0].get<::BigInt>();
         if (bi.is_zero()) {
             return Value(0);
         }
@@ -66,7 +68,7 @@ Value sqrt_(const std::vector<Value>& args) {
 
     // Handle rational case
     if (args[0].is_rational()) {
-        const auto& rat = std::get<::Rational>(args[0].data);
+        const auto& rat = args[0].get<::Rational>();
         auto num = rat.get_numerator();
         auto den = rat.get_denominator();
 
@@ -115,6 +117,12 @@ Value e(const std::vector<Value>& /* args */) {
  * @return Value 绝对值结果
  */
 Value abs_(const std::vector<Value>& args) {
+    if (args[0].is_numarray()) {
+        // 整数数组保持 int64
+        const auto& arr = args[0].get<NumArray>();
+        auto res = arr.map([](double x) { return std::abs(x); });
+        return arr.is_integral() ? res.astype(NumArray::DType::Int64) : res;
+    }
     if (!args[0].is_numeric()) {
         std::cerr << "Error: abs() requires numeric argument" << std::endl;
         return Value();
@@ -122,7 +130,7 @@ Value abs_(const std::vector<Value>& args) {
 
     // Handle BigInt specifically
     if (args[0].is_bigint()) {
-        const auto& bigint_val = std::get<::BigInt>(args[0].data);
+        const auto& bigint_val = args[0].get<::BigInt>();
         return Value(bigint_val.abs());
     }
 
@@ -138,6 +146,9 @@ Value abs_(const std::vector<Value>& args) {
  * @return Value 正弦值结果
  */
 Value sin_(const std::vector<Value>& args) {
+    if (args[0].is_numarray()) {
+        return args[0].get<NumArray>().map([](double x) { return std::sin(x); });
+    }
     if (!args[0].is_numeric()) {
         std::cerr << "Error: sin() requires numeric argument" << std::endl;
         return Value();
@@ -152,6 +163,9 @@ Value sin_(const std::vector<Value>& args) {
  * @return Value 余弦值结果
  */
 Value cos_(const std::vector<Value>& args) {
+    if (args[0].is_numarray()) {
+        return args[0].get<NumArray>().map([](double x) { return std::cos(x); });
+    }
     if (!args[0].is_numeric()) {
         std::cerr << "Error: cos() requires numeric argument" << std::endl;
         return Value();
@@ -166,6 +180,9 @@ Value cos_(const std::vector<Value>& args) {
  * @return Value 正切值结果
  */
 Value tan_(const std::vector<Value>& args) {
+    if (args[0].is_numarray()) {
+        return args[0].get<NumArray>().map([](double x) { return std::tan(x); });
+    }
     if (!args[0].is_numeric()) {
         std::cerr << "Error: tan() requires numeric argument" << std::endl;
         return Value();
@@ -180,6 +197,9 @@ Value tan_(const std::vector<Value>& args) {
  * @return Value 自然对数值结果
  */
 Value log_(const std::vector<Value>& args) {
+    if (args[0].is_numarray()) {
+        return args[0].get<NumArray>().map([](double x) { return std::log(x); });
+    }
     if (!args[0].is_numeric()) {
         L_ERR("log() requires numeric argument");
     }
@@ -197,6 +217,9 @@ Value log_(const std::vector<Value>& args) {
  * @return Value 四舍五入后的整数结果
  */
 Value round_(const std::vector<Value>& args) {
+    if (args[0].is_numarray()) {
+        return args[0].get<NumArray>().map([](double x) { return std::round(x); }).astype(NumArray::DType::Int64);
+    }
     if (!args[0].is_numeric()) {
         L_ERR("round() requires numeric argument");
     }
@@ -210,6 +233,9 @@ Value round_(const std::vector<Value>& args) {
  * @return Value 向下取整后的整数结果
  */
 Value floor_(const std::vector<Value>& args) {
+    if (args[0].is_numarray()) {
+        return args[0].get<NumArray>().map([](double x) { return std::floor(x); }).astype(NumArray::DType::Int64);
+    }
     if (!args[0].is_numeric()) {
         L_ERR("floor() requires numeric argument");
     }
@@ -223,6 +249,9 @@ Value floor_(const std::vector<Value>& args) {
  * @return Value 向上取整后的整数结果
  */
 Value ceil_(const std::vector<Value>& args) {
+    if (args[0].is_numarray()) {
+        return args[0].get<NumArray>().map([](double x) { return std::ceil(x); }).astype(NumArray::DType::Int64);
+    }
     if (!args[0].is_numeric()) {
         L_ERR("ceil() requires numeric argument");
     }
@@ -230,12 +259,26 @@ Value ceil_(const std::vector<Value>& args) {
 }
 
 /**
- * @brief 计算两个向量的点积
+ * @brief 计算两个向量的点积；两个矩阵或二维类型化数组时做矩阵乘法
  * 
- * @param args 参数列表，要求包含两个向量类型的参数
- * @return Value 点积结果
+ * @param args 参数列表，要求包含两个向量、矩阵或类型化数组参数
+ * @return Value 点积或矩阵乘积
  */
 Value dot(const std::vector<Value>& args) {
+    if (args[0].is_numarray() && args[1].is_numarray()) {
+        const auto& a = args[0].get<NumArray>();
+        const auto& b = args[1].get<NumArray>();
+        try {
+            // 与 NumPy 一致：有二维的一方时做矩阵乘法
+            if (a.ndim() == 2 || b.ndim() == 2) return NumArray::matmul(a, b);
+            return Value(a.dot(b));
+        } catch (const std::invalid_argument& e) {
+            L_ERR(e.what());
+        }
+    }
+    if (args[0].is_matrix() && args[1].is_matrix()) {
+        return args[0].matrix_multiply(args[1]);
+    }
     return args[0].dot_product(args[1]);
 }
 
@@ -256,6 +299,10 @@ Value cross(const std::vector<Value>& args) {
  * @return Value 模长结果
  */
 Value norm(const std::vector<Value>& args) {
+    if (args[0].is_numarray()) {
+        const auto& arr = args[0].get<NumArray>();
+        return Value(std::sqrt(arr.dot(arr)));
+    }
     return args[0].magnitude();
 }
 
@@ -269,14 +316,236 @@ Value normalize(const std::vector<Value>& args) {
     return args[0].normalize();
 }
 
+namespace {
+
+// 线性代数的矩阵参数，按行优先展开
+// 元素全为整数 / 有理数的矩阵走精确路径；类型化数组总是按浮点计算，结果也用类型化数组
+struct MatrixArg {
+    size_t rows = 0, cols = 0;
+    bool exact = true;
+    bool numarray = false;
+    bool vector = false;// 一维参数，当作列向量
+    std::vector<double> values;
+    std::vector<std::vector<::Rational>> exacts;
+};
+
+void push_cell(MatrixArg& m, const Value& v, const std::string& func) {
+    if (!v.is_numeric()) L_ERR(func + "() requires numeric matrix elements");
+    if (v.is_int()) m.exacts.back().emplace_back(v.get<int>());
+    else if (v.is_bigint()) m.exacts.back().emplace_back(v.get<::BigInt>());
+    else if (v.is_rational()) m.exacts.back().push_back(v.get<::Rational>());
+    else m.exact = false;
+}
+
+MatrixArg matrix_arg(const Value& v, const std::string& func, bool allow_vector = false) {
+    MatrixArg m;
+    if (v.is_numarray()) {
+        const auto& arr = v.get<NumArray>();
+        if (arr.ndim() == 2) {
+            m.rows = arr.shape()[0];
+            m.cols = arr.shape()[1];
+        } else if (arr.ndim() == 1 && allow_vector) {
+            m.rows = arr.size();
+            m.cols = 1;
+            m.vector = true;
+        } else {
+            L_ERR(func + "() requires a 2-D array");
+        }
+        m.exact = false;
+        m.numarray = true;
+        m.values.resize(arr.size());
+        for (size_t i = 0; i < arr.size(); i++) m.values[i] = arr.number(i);
+        return m;
+    }
+    if (v.is_matrix()) {
+        const auto& mat = v.get<std::vector<std::vector<Value>>>();
+        m.rows = mat.size();
+        m.cols = mat.empty() ? 0 : mat[0].size();
+        for (const auto& row : mat) {
+            if (row.size() != m.cols) L_ERR(func + "() requires rows of the same length");
+            m.exacts.emplace_back();
+            for (const auto& cell : row) push_cell(m, cell, func);
+        }
+        if (!m.exact) {
+            for (const auto& row : mat) {
+                for (const auto& cell : row) m.values.push_back(cell.as_number());
+            }
+        }
+        return m;
+    }
+    if (v.is_array() && allow_vector) {
+        const auto& arr = v.get<std::vector<Value>>();
+        m.rows = arr.size();
+        m.cols = 1;
+        m.vector = true;
+        for (const auto& cell : arr) {
+            m.exacts.emplace_back();
+            push_cell(m, cell, func);
+        }
+        if (!m.exact) {
+            for (const auto& cell : arr) m.values.push_back(cell.as_number());
+        }
+        return m;
+    }
+    L_ERR(func + "() requires a matrix");
+    return m;
+}
+
+// 精确矩阵与浮点参数一起运算时，补上浮点值
+void ensure_values(MatrixArg& m) {
+    if (!m.exact || !m.values.empty()) return;
+    for (const auto& row : m.exacts) {
+        for (const auto& q : row) m.values.push_back(q.to_double());
+    }
+}
+
+// 每行乘以该行（连同右端项同一行）分母的最小公倍数化为整数，scales 记录各行的乘数
+void integer_rows(const MatrixArg& a, const MatrixArg* b, IntMatrix& ia, IntMatrix* ib, std::vector<::BigInt>* scales) {
+    ia.assign(a.rows, {});
+    if (ib) ib->assign(a.rows, {});
+    for (size_t i = 0; i < a.rows; i++) {
+        ::BigInt l(1);
+        for (const auto& q : a.exacts[i]) l = ::BigInt::lcm(l, q.get_denominator());
+        if (b) {
+            for (const auto& q : b->exacts[i]) l = ::BigInt::lcm(l, q.get_denominator());
+        }
+        for (const auto& q : a.exacts[i]) ia[i].push_back(q.get_numerator() * (l / q.get_denominator()));
+        if (b) {
+            for (const auto& q : b->exacts[i]) (*ib)[i].push_back(q.get_numerator() * (l / q.get_denominator()));
+        }
+        if (scales) scales->push_back(l);
+    }
+}
+
+// 计算结果按参数的形式返回：类型化数组、数组（列向量）或矩阵
+Value float_result(const std::vector<double>& x, size_t rows, size_t cols, bool numarray, bool vector) {
+    if (numarray) {
+        NumArray out(NumArray::DType::Float64, vector ? NumArray::Shape{rows} : NumArray::Shape{rows, cols});
+        for (size_t i = 0; i < x.size(); i++) out.set(i, x[i]);
+        return out;
+    }
+    if (vector) return std::vector<Value>(x.begin(), x.end());
+    std::vector<std::vector<Value>> mat(rows);
+    for (size_t i = 0; i < rows; i++) mat[i].assign(x.begin() + i * cols, x.begin() + (i + 1) * cols);
+    return mat;
+}
+
+Value exact_result(const std::vector<std::vector<::Rational>>& x, bool vector) {
+    if (vector) {
+        std::vector<Value> out;
+        out.reserve(x.size());
+        for (const auto& row : x) out.push_back(Value::from_rational(row[0]));
+        return out;
+    }
+    std::vector<std::vector<Value>> mat(x.size());
+    for (size_t i = 0; i < x.size(); i++) {
+        mat[i].reserve(x[i].size());
+        for (const auto& q : x[i]) mat[i].push_back(Value::from_rational(q));
+    }
+    return mat;
+}
+
+}// namespace
+
 /**
- * @brief 计算矩阵的行列式
+ * @brief 计算任意阶方阵的行列式
  * 
- * @param args 参数列表，要求包含一个矩阵类型的参数
+ * 元素全为整数 / 有理数时用 Bareiss 无分数消元得到精确结果，否则用带部分主元的 LU 分解
+ * 
+ * @param args 参数列表，要求包含一个方阵或二维类型化数组参数
  * @return Value 行列式结果
  */
 Value det(const std::vector<Value>& args) {
-    return args[0].determinant();
+    check_cpp_function_argv(args, 1);
+    const MatrixArg a = matrix_arg(args[0], "det");
+    if (a.rows != a.cols) L_ERR("det() requires a square matrix");
+    if (a.exact) {
+        IntMatrix ia;
+        std::vector<::BigInt> scales;
+        integer_rows(a, nullptr, ia, nullptr, &scales);
+        ::BigInt den(1);
+        for (const auto& l : scales) den = den * l;
+        return Value::from_rational(::Rational(bareiss_det(ia), den));
+    }
+    return Value(lu_det(lu_factor(a.rows, a.values)));
+}
+
+/**
+ * @brief 计算方阵的逆矩阵
+ * 
+ * @param args 参数列表，要求包含一个方阵或二维类型化数组参数
+ * @return Value 逆矩阵；奇异时报错
+ */
+Value inv(const std::vector<Value>& args) {
+    check_cpp_function_argv(args, 1);
+    const MatrixArg a = matrix_arg(args[0], "inv");
+    if (a.rows != a.cols) L_ERR("inv() requires a square matrix");
+    const size_t n = a.rows;
+    if (a.exact) {
+        // 行乘以 l_i 后，右端项的单位阵也相应变为 diag(l_i)
+        IntMatrix ia;
+        std::vector<::BigInt> scales;
+        integer_rows(a, nullptr, ia, nullptr, &scales);
+        IntMatrix ib(n, std::vector<::BigInt>(n));
+        for (size_t i = 0; i < n; i++) ib[i][i] = scales[i];
+        auto x = bareiss_solve(ia, ib);
+        if (!x) L_ERR("Matrix is singular");
+        return exact_result(*x, false);
+    }
+    const LUFactor f = lu_factor(n, a.values);
+    if (f.singular) L_ERR("Matrix is singular");
+    std::vector<double> x(n * n);
+    for (size_t i = 0; i < n; i++) x[i * n + i] = 1.0;
+    lu_solve(f, n, x.data());
+    return float_result(x, n, n, a.numarray, false);
+}
+
+/**
+ * @brief 求解线性方程组 A x = b
+ * 
+ * b 为向量时返回向量，为矩阵时逐列求解并返回矩阵
+ * 
+ * @param args 参数列表，要求包含系数方阵和右端项两个参数
+ * @return Value 方程组的解；系数矩阵奇异时报错
+ */
+Value solve(const std::vector<Value>& args) {
+    check_cpp_function_argv(args, 2);
+    MatrixArg a = matrix_arg(args[0], "solve");
+    MatrixArg b = matrix_arg(args[1], "solve", true);
+    if (a.rows != a.cols) L_ERR("solve() requires a square coefficient matrix");
+    if (b.rows != a.rows) L_ERR("solve() right-hand side length does not match the number of equations");
+    const size_t n = a.rows;
+    if (a.exact && b.exact) {
+        IntMatrix ia, ib;
+        integer_rows(a, &b, ia, &ib, nullptr);
+        auto x = bareiss_solve(ia, ib);
+        if (!x) L_ERR("Matrix is singular");
+        return exact_result(*x, b.vector);
+    }
+    ensure_values(a);
+    ensure_values(b);
+    const LUFactor f = lu_factor(n, a.values);
+    if (f.singular) L_ERR("Matrix is singular");
+    std::vector<double> x = b.values;
+    lu_solve(f, b.cols, x.data());
+    return float_result(x, n, b.cols, a.numarray || b.numarray, b.vector);
+}
+
+/**
+ * @brief 计算矩阵的秩
+ * 
+ * @param args 参数列表，要求包含一个矩阵或二维类型化数组参数
+ * @return Value 秩（整数）
+ */
+Value rank(const std::vector<Value>& args) {
+    check_cpp_function_argv(args, 1);
+    const MatrixArg a = matrix_arg(args[0], "rank");
+    if (a.exact) {
+        IntMatrix ia;
+        integer_rows(a, nullptr, ia, nullptr, nullptr);
+        return Value(static_cast<int>(bareiss_rank(ia)));
+    }
+    return Value(static_cast<int>(rank_float(a.rows, a.cols, a.values)));
 }
 
 /**
@@ -287,13 +556,16 @@ Value det(const std::vector<Value>& args) {
  */
 Value size(const std::vector<Value>& args) {
     if (args[0].is_array()) {
-        const auto& arr = std::get<std::vector<Value>>(args[0].data);
+        const auto& arr = args[0].get<std::vector<Value>>();
         return Value(static_cast<int>(arr.size()));
     } else if (args[0].is_matrix()) {
-        const auto& mat = std::get<std::vector<std::vector<Value>>>(args[0].data);
+        const auto& mat = args[0].get<std::vector<std::vector<Value>>>();
         return Value(static_cast<int>(mat.size()));
+    } else if (args[0].is_numarray()) {
+        // 与数组、矩阵一致，返回第一维的长度
+        return Value(static_cast<int>(args[0].get<NumArray>().shape()[0]));
     } else if (args[0].is_string()) {
-        const auto& str = std::get<std::string>(args[0].data);
+        const auto& str = args[0].get<std::string>();
         return Value(static_cast<int>(str.length()));
     }
     return Value(1);// Scalar values have size 1
@@ -348,15 +620,30 @@ Value fraction(const std::vector<Value>& args) {
 /**
  * @brief 将数值转换为小数形式
  * 
- * @param args 参数列表，要求包含一个数值类型的参数
- * @return Value 小数形式的结果
+ * @param args 参数列表，要求包含一个数值类型的参数；可选第二个参数为保留的小数位数
+ * @return Value 不指定位数时返回 double 近似值；指定位数时返回字符串，
+ *         因为 double 只有约 17 位有效数字，装不下任意位数的结果
  */
 Value decimal(const std::vector<Value>& args) {
-    if (!args[0].is_numeric()) {
+    if (args.empty() || !args[0].is_numeric()) {
         std::cerr << "Error: decimal() requires numeric argument" << std::endl;
         return Value();
     }
 
+    if (args.size() >= 2) {
+        if (!args[1].is_int() || args[1].get<int>() < 0) {
+            std::cerr << "Error: decimal() digits must be a non-negative integer" << std::endl;
+            return Value();
+        }
+        // 按符号表达式做任意精度求值
+        try {
+            return Value(args[0].as_symbolic()->to_decimal_string(args[1].get<int>()));
+        } catch (const std::exception& e) {
+            std::cerr << "Error: decimal(): " << e.what() << std::endl;
+            return Value();
+        }
+    }
+
     // Convert to double representation
     double val = args[0].as_number();
     return Value(val);
@@ -381,13 +668,13 @@ Value pow_(const std::vector<Value>& args) {
 
     // Handle BigInt base with integer exponent
     if (args[0].is_bigint() && (args[1].is_int() || args[1].is_bigint())) {
-        const auto& base = std::get<::BigInt>(args[0].data);
+        const auto& base = args[0].get<::BigInt>();
 
         ::BigInt exponent;
         if (args[1].is_int()) {
-            exponent = ::BigInt(std::get<int>(args[1].data));
+            exponent = ::BigInt(args[1].get<int>());
         } else {
-            exponent = std::get<::BigInt>(args[1].data);
+            exponent = args[1].get<::BigInt>();
         }
 
         try {
@@ -429,16 +716,16 @@ Value gcd(const std::vector<Value>& args) {
 
     // Handle BigInt case
     if (args[0].is_bigint() || args[1].is_bigint()) {
-        ::BigInt a = args[0].is_bigint() ? std::get<::BigInt>(args[0].data) : ::BigInt(std::get<int>(args[0].data));
-        ::BigInt b = args[1].is_bigint() ? std::get<::BigInt>(args[1].data) : ::BigInt(std::get<int>(args[1].data));
+        ::BigInt a = args[0].is_bigint() ? args[0].get<::BigInt>() : ::BigInt(args[0].get<int>());
+        ::BigInt b = args[1].is_bigint() ? args[1].get<::BigInt>() : ::BigInt(args[1].get<int>());
 
         return Value(::BigInt::gcd(a, b));
     }
 
     // Handle regular integer case
     if (args[0].is_int() && args[1].is_int()) {
-        int a = std::get<int>(args[0].data);
-        int b = std::get<int>(args[1].data);
+        int a = args[0].get<int>();
+        int b = args[1].get<int>();
 
         // Simple GCD algorithm for integers
         a = std::abs(a);
@@ -483,16 +770,16 @@ Value lcm(const std::vector<Value>& args) {
 
     // Handle BigInt case
     if (args[0].is_bigint() || args[1].is_bigint()) {
-        ::BigInt a = args[0].is_bigint() ? std::get<::BigInt>(args[0].data) : ::BigInt(std::get<int>(args[0].data));
-        ::BigInt b = args[1].is_bigint() ? std::get<::BigInt>(args[1].data) : ::BigInt(std::get<int>(args[1].data));
+        ::BigInt a = args[0].is_bigint() ? args[0].get<::BigInt>() : ::BigInt(args[0].get<int>());
+        ::BigInt b = args[1].is_bigint() ? args[1].get<::BigInt>() : ::BigInt(args[1].get<int>());
 
         return Value(::BigInt::lcm(a, b));
     }
 
     // Handle regular integer case
     if (args[0].is_int() && args[1].is_int()) {
-        int a = std::abs(std::get<int>(args[0].data));
-        int b = std::abs(std::get<int>(args[1].data));
+        int a = std::abs(args[0].get<int>());
+        int b = std::abs(args[1].get<int>());
 
         if (a == 0 || b == 0) {
             return Value(0);
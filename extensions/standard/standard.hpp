@@ -37,7 +37,7 @@ Value floor_(const std::vector<Value>& args);
 // 向上取整（天花板函数）：需1个数值参数，返回不小于该值的最小整数
 Value ceil_(const std::vector<Value>& args);
 
-// 点积：需2个同维度向量参数，返回标量结果
+// 点积：需2个同维度向量参数，返回标量结果；两个矩阵或二维类型化数组时做矩阵乘法
 Value dot(const std::vector<Value>& args);
 
 // 叉积：需2个3维向量参数，返回3维向量结果
@@ -49,9 +49,18 @@ Value norm(const std::vector<Value>& args);
 // 归一化：需1个向量参数，返回单位向量（各元素除以范数）
 Value normalize(const std::vector<Value>& args);
 
-// 行列式：需1个方阵参数（如2x2、3x3矩阵），返回标量结果
+// 行列式：需1个方阵参数（任意阶；整数 / 有理数矩阵给出精确结果），返回标量结果
 Value det(const std::vector<Value>& args);
 
+// 逆矩阵：需1个方阵参数，奇异时报错
+Value inv(const std::vector<Value>& args);
+
+// 解线性方程组 A x = b：需2个参数（系数方阵、右端向量或矩阵），返回解向量或矩阵
+Value solve(const std::vector<Value>& args);
+
+// 矩阵的秩：需1个矩阵参数，返回整数
+Value rank(const std::vector<Value>& args);
+
 // 大小/维度：需1个容器类参数（向量/矩阵），返回元素个数或维度信息（如{行,列}）
 Value size(const std::vector<Value>& args);
 
@@ -62,6 +71,7 @@ Value idiv(const std::vector<Value>& args);
 Value fraction(const std::vector<Value>& args);
 
 // 小数转整数（或提取整数部分）：需1个数值参数，返回整数部分（如5.7返回5，-3.2返回-3）
+// 可选第2个参数 n：对精确值（根式、π、e 等）求出 n 位准确小数，以字符串返回
 Value decimal(const std::vector<Value>& args);
 
 // 幂运算（base^exponent）：需2个参数（底数、指数），返回幂运算结果
@@ -96,6 +106,30 @@ Value get_format_date(const std::vector<Value>& args);
 // 生成数值范围：需2个或3个参数（start, end 生成[start,end)步长1的序列；start, end, step 生成指定步长序列）
 Value range(const std::vector<Value>& args);
 
+// 类型化数组：需1或2个参数（数值数组，可嵌套成多维；可选类型名 "int64"/"float64"/"float32"），元素连续存放，逐元素运算按形状广播
+Value numarray(const std::vector<Value>& args);
+
+// 全零类型化数组：需1或2个参数（长度或形状数组；可选类型名，默认 "float64"）
+Value zeros(const std::vector<Value>& args);
+
+// 类型化数组转回普通数组：需1个参数，多维时返回嵌套数组
+Value to_array(const std::vector<Value>& args);
+
+// 类型化数组的元素类型：需1个参数，返回 "int64"、"float64" 或 "float32"
+Value dtype(const std::vector<Value>& args);
+
+// 类型化数组的形状：需1个参数，返回各维长度组成的数组
+Value shape(const std::vector<Value>& args);
+
+// 改变形状：需2个参数（类型化数组、形状数组，其中一维可为-1），返回共享存储的视图
+Value reshape(const std::vector<Value>& args);
+
+// 转置：需1或2个参数（类型化数组；可选维的排列），默认反转所有维，返回共享存储的视图
+Value transpose(const std::vector<Value>& args);
+
+// 切片：需4或5个参数（类型化数组、维、起点、终点；可选步长），返回共享存储的视图
+Value slice(const std::vector<Value>& args);
+
 // 获取数组指定索引元素：需2个参数（数组、索引），返回该索引对应的元素
 Value arr_at(const std::vector<Value>& args);
 
@@ -208,6 +242,22 @@ Value cas_solve_linear(const std::vector<Value>& args);
 // CAS数值导数计算：需3个参数（CAS表达式、求导变量、计算点），返回该点的数值导数
 Value cas_numerical_derivative(const std::vector<Value>& args);
 
+// CAS批量求值：需3个参数（CAS表达式、变量名或变量名数组、对应的取值数组），返回逐点求值结果数组
+Value cas_evaluate_batch(const std::vector<Value>& args);
+
+// 线性方程组精确求解：需2个参数（系数矩阵、右端数组），返回精确解数组，无唯一解时返回提示字符串
+Value cas_solve_system(const std::vector<Value>& args);
+
+// 前向模式自动微分：需3或4个参数（CAS表达式、求导变量、点；多变量时为变量名数组和取值数组），
+// 或2、3个参数（匿名函数、可选的求导参数名、参数取值），返回该点导数
+Value cas_derivative_at(const std::vector<Value>& args);
+
+// 反向模式自动微分：需3个参数（CAS表达式、变量名数组、取值数组）或2个参数（匿名函数、参数取值数组），返回该点的梯度数组
+Value cas_gradient(const std::vector<Value>& args);
+
+// CAS解析缓存统计：无参数，返回包含命中数、未命中数、当前条目数和容量的结构体
+Value cas_cache_stats(const std::vector<Value>& args);
+
 // ====================== io ======================
 
 Value fast_read(const std::vector<Value>& args);
@@ -256,6 +306,9 @@ inline std::unordered_map<std::string, Value> register_builtins =
         LAMINA_FUNC("norm", norm),
         LAMINA_FUNC("normalize", normalize),
         LAMINA_FUNC("det", det),
+        LAMINA_FUNC("inv", inv),
+        LAMINA_FUNC("solve", solve),
+        LAMINA_FUNC("rank", rank),
         LAMINA_FUNC("size", size),
         LAMINA_FUNC("idiv", idiv),
         LAMINA_FUNC("fraction", fraction),
@@ -264,6 +317,14 @@ inline std::unordered_map<std::string, Value> register_builtins =
         LAMINA_FUNC("gcd", gcd),
         LAMINA_FUNC("lcm", lcm),
         LAMINA_FUNC("range", range),
+        LAMINA_FUNC("numarray", numarray),
+        LAMINA_FUNC("zeros", zeros),
+        LAMINA_FUNC("to_array", to_array),
+        LAMINA_FUNC("dtype", dtype),
+        LAMINA_FUNC("shape", shape),
+        LAMINA_FUNC("reshape", reshape),
+        LAMINA_FUNC("transpose", transpose),
+        LAMINA_FUNC("slice", slice),
 
         // 数组处理模块：封装数组元素访问、修改、查找功能
         LAMINA_MODULE("array", LAMINA_VERSION, {
@@ -309,7 +370,12 @@ inline std::unordered_map<std::string, Value> register_builtins =
             LAMINA_FUNC("cas_load", cas_load),
             LAMINA_FUNC("cas_evaluate_at", cas_evaluate_at),
             LAMINA_FUNC("cas_solve_linear", cas_solve_linear),
-            LAMINA_FUNC("cas_numerical_derivative", cas_numerical_derivative)
+            LAMINA_FUNC("cas_numerical_derivative", cas_numerical_derivative),
+            LAMINA_FUNC("cas_cache_stats", cas_cache_stats),
+            LAMINA_FUNC("cas_evaluate_batch", cas_evaluate_batch),
+            LAMINA_FUNC("cas_solve_system", cas_solve_system),
+            LAMINA_FUNC("cas_derivative_at", cas_derivative_at),
+            LAMINA_FUNC("cas_gradient", cas_gradient)
         })
     };
 
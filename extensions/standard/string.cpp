@@ -11,7 +11,7 @@ Value cat(const std::vector<Value>& args) {
             L_ERR("Args Must Be String");
             return LAMINA_NULL;
         }
-        const std::string arg_str = std::get<std::string>(arg.data);
+        const std::string arg_str = arg.get<std::string>();
         str += arg_str;
     }
 
@@ -31,8 +31,8 @@ Value char_at(const std::vector<Value>& args) {
         return LAMINA_NULL;
     }
 
-    const std::string str = std::get<std::string>(args[0].data);
-    const int index = std::get<int>(args[1].data);
+    const std::string str = args[0].get<std::string>();
+    const int index = args[1].get<int>();
 
     if (index < 0 || static_cast<size_t>(index) >= str.length()) {
         L_ERR("Char Index Out Of Range");
@@ -50,7 +50,7 @@ Value length(const std::vector<Value>& args) {
         return LAMINA_NULL;
     }
 
-    const std::string str = std::get<std::string>(args[0].data);
+    const std::string str = args[0].get<std::string>();
 
     return Value(static_cast<int>(str.length()));
 }
@@ -77,9 +77,9 @@ Value str_find(const std::vector<Value>& args) {
         return LAMINA_NULL;
     }
 
-    const std::string str = std::get<std::string>(args[0].data);
-    const int start_index = std::get<int>(args[1].data);
-    const std::string sub_str = std::get<std::string>(args[2].data);
+    const std::string str = args[0].get<std::string>();
+    const int start_index = args[1].get<int>();
+    const std::string sub_str = args[2].get<std::string>();
 
     if (start_index < 0 || static_cast<size_t>(start_index) >= str.length()) {
         L_ERR("Start Index Out Of Range");
@@ -113,9 +113,9 @@ Value sub_string(const std::vector<Value>& args) {
         return LAMINA_NULL;
     }
 
-    const std::string str = std::get<std::string>(args[0].data);
-    const int start_index = std::get<int>(args[1].data);
-    const int len = std::get<int>(args[2].data);
+    const std::string str = args[0].get<std::string>();
+    const int start_index = args[1].get<int>();
+    const int len = args[2].get<int>();
 
     if (start_index < 0 || static_cast<size_t>(start_index) >= str.length()) {
         L_ERR("Start Index Out Of Range");
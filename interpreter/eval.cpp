@@ -4,7 +4,6 @@
 #include "lamina_api/lamina.hpp"
 #include "lamina_api/symbolic.hpp"
 #include <iostream>
-#include <optional>
 
 enum VALUE_TYPE : int {
     VALUE_IS_STRING = 1,
@@ -23,21 +22,22 @@ static std::shared_ptr<SymbolicExpr> GET_SYMBOLICEXPR(const Value* val, enum VAL
 static int GET_VALUE_TYPE(const Value* val);
 static Value HANDLE_BINARYEXPR_ADD(Value* l, Value* r);
 static Value HANDLE_BINARYEXPR_STR_ADD_STR(Value* l, Value* r);
+static Value HANDLE_BINARYEXPR_CAS_ADD(Value* l, Value* r);
 
 std::shared_ptr<SymbolicExpr> GET_SYMBOLICEXPR(const Value* val, int type) {
     switch (type & (~int(VALUE_IS_NUMERIC))) {
         case VALUE_IS_SYMBOLIC:
-            return std::get<std::shared_ptr<SymbolicExpr>>(val->data);
+            return val->get<std::shared_ptr<SymbolicExpr>>();
         case VALUE_IS_IRRATIONAL:
-            return std::get<::Irrational>(val->data).to_symbolic();
+            return val->get<::Irrational>().to_symbolic();
         case VALUE_IS_RATIONAL:
-            return SymbolicExpr::number(std::get<::Rational>(val->data));
+            return SymbolicExpr::number(val->get<::Rational>());
         case VALUE_IS_BIGINT:
-            return SymbolicExpr::number(std::get<::BigInt>(val->data));
+            return SymbolicExpr::number(val->get<::BigInt>());
         case VALUE_IS_INT:
-            return SymbolicExpr::number(std::get<int>(val->data));
+            return SymbolicExpr::number(val->get<int>());
         case VALUE_IS_FLOAT:
-            return SymbolicExpr::number(::Rational::from_double(std::get<double>(val->data)));
+            return SymbolicExpr::number(::Rational::from_double(val->get<double>()));
         default:
             return SymbolicExpr::number(0);
     }
@@ -68,13 +68,14 @@ int GET_VALUE_TYPE(const Value* val) {
 Value HANDLE_BINARYEXPR_ADD(Value* l, Value* r) {
     auto ltype = GET_VALUE_TYPE(l);
     auto rtype = GET_VALUE_TYPE(r);
-    if (ltype & VALUE_IS_STRING && rtype & VALUE_IS_STRING) {
+    if (ltype & VALUE_IS_STRING || rtype & VALUE_IS_STRING) {
         return HANDLE_BINARYEXPR_STR_ADD_STR(l, r);
-    } else if (ltype & VALUE_IS_STRING || rtype & VALUE_IS_STRING) {
-        return Value(l->to_string() + r->to_string());
+    } else if ((l->is_cas_expr() && (r->is_cas_expr() || r->is_int() || r->is_float())) ||
+               (r->is_cas_expr() && (l->is_int() || l->is_float()))) {
+        return HANDLE_BINARYEXPR_CAS_ADD(l, r);
     } else if (ltype & VALUE_IS_ARRAY && rtype & VALUE_IS_ARRAY) {
         // Vector addition
-        return l->vector_add(r);
+        return l->vector_add(*r);
         // 只要有一方是 Irrational 或 Symbolic，优先生成符号表达式
     } else if (((ltype & VALUE_IS_IRRATIONAL) || (ltype & VALUE_IS_SYMBOLIC) || (rtype & VALUE_IS_IRRATIONAL) || (rtype & VALUE_IS_SYMBOLIC)) && (ltype & VALUE_IS_NUMERIC) && (rtype & VALUE_IS_NUMERIC)) {
         std::shared_ptr<SymbolicExpr> leftExpr = GET_SYMBOLICEXPR(l, ltype);
@@ -83,8 +84,8 @@ Value HANDLE_BINARYEXPR_ADD(Value* l, Value* r) {
     } else if (ltype & VALUE_IS_NUMERIC && rtype & VALUE_IS_NUMERIC) {
         // BigInt 优先：如果任一为 BigInt，结果为 BigInt
         if (l->is_bigint() || r->is_bigint()) {
-            ::BigInt lb = l->is_bigint() ? std::get<::BigInt>(l->data) : ::BigInt(l->as_number());
-            ::BigInt rb = r->is_bigint() ? std::get<::BigInt>(r->data) : ::BigInt(r->as_number());
+            ::BigInt lb = l->is_bigint() ? l->get<::BigInt>() : ::BigInt(l->as_number());
+            ::BigInt rb = r->is_bigint() ? r->get<::BigInt>() : ::BigInt(r->as_number());
             return Value(lb + rb);
         }
         // If either operand is rational, use rational arithmetic
@@ -109,154 +110,33 @@ Value HANDLE_BINARYEXPR_ADD(Value* l, Value* r) {
 }
 
 Value HANDLE_BINARYEXPR_STR_ADD_STR(Value* l, Value* r) {
-    std::string ls = l->to_string();
-    std::string rs = r->to_string();
-    try {
-        // Try to parse both strings as CAS expressions and combine them symbolically
-        LaminaCAS::Parser pl(ls);
-        auto e1 = pl.parse();
-        LaminaCAS::Parser pr(rs);
-        auto e2 = pr.parse();
-        // attempt structural merge: if e1 and e2 are Multiply(Number, Variable) or vice versa,
-        // then combine coefficients
-        auto try_extract_coeff_var = [](const LaminaCAS::Expr* ex) -> std::optional<std::pair<double, std::string>> {
-            // Multiply(Number, Variable)
-            if (auto mul = dynamic_cast<const LaminaCAS::Multiply*>(ex)) {
-                const LaminaCAS::Expr* left = mul->clone().release();
-                const LaminaCAS::Expr* right = nullptr;// will be set below
-                                                       // We can't easily access internals (unique_ptr ownership), so inspect via toString heuristic
-                std::string s = mul->toString();
-                // fallback to string parsing
-                // very simple: look for pattern like "<num> * <var>"
-                size_t star = s.find('*');
-                if (star != std::string::npos) {
-                    std::string a = s.substr(0, star);
-                    std::string b = s.substr(star + 1);
-                    auto trim = [](std::string& str) {
-                        while (!str.empty() && std::isspace((unsigned char) str.front())) str.erase(str.begin());
-                        while (!str.empty() && std::isspace((unsigned char) str.back())) str.pop_back();
-                    };
-                    trim(a);
-                    trim(b);
-                    try {
-                        double va = std::stod(a);
-                        // b is var
-                        return std::make_pair(va, b);
-                    } catch (...) {}
-                    try {
-                        double vb = std::stod(b);
-                        return std::make_pair(vb, a);
-                    } catch (...) {}
-                }
-            }
-            // Number alone
-            if (auto num = dynamic_cast<const LaminaCAS::Number*>(ex)) {
-                return std::make_pair(num->getValue(), std::string());
-            }
-            // Variable alone
-            if (auto var = dynamic_cast<const LaminaCAS::Variable*>(ex)) {
-                return std::make_pair(1.0, var->toString());
-            }
-            return std::nullopt;
-        };
-
-        auto e1ptr = e1.get();
-        auto e2ptr = e2.get();
-        auto p1 = try_extract_coeff_var(e1ptr);
-        auto p2 = try_extract_coeff_var(e2ptr);
-        if (p1 && p2 && !p1->second.empty() && p1->second == p2->second) {
-            double sum = p1->first + p2->first;
-            std::string coeff = (std::floor(sum) == sum) ? std::to_string((int) sum) : std::to_string(sum);
-            return Value(std::string("(" + coeff + " * " + p1->second + ")"));
-        }
+    // 普通字符串拼接，不做符号化处理；符号加法请使用 CAS 表达式值
+    std::string out;
+    if (l->is_string() && r->is_string()) {
+        const auto& ls = l->get<std::string>();
+        const auto& rs = r->get<std::string>();
+        out.reserve(ls.size() + rs.size());
+        out += ls;
+        out += rs;
+    } else {
+        l->write_to(out);
+        r->write_to(out);
+    }
+    return Value(std::move(out));
+}
 
-        auto combined = std::make_unique<LaminaCAS::Add>(std::move(e1), std::move(e2));
-        auto simplified = combined->simplify();
-
-        // Attempt a lightweight combine for simple like-terms of form a*x
-        auto try_parse_coeff_var = [](const std::string& s) -> std::optional<std::pair<double, std::string>> {
-            std::string t = s;
-            // trim
-            auto trim = [](std::string& str) {
-                while (!str.empty() && std::isspace((unsigned char) str.front())) str.erase(str.begin());
-                while (!str.empty() && std::isspace((unsigned char) str.back())) str.pop_back();
-            };
-            trim(t);
-            // remove surrounding parentheses
-            if (!t.empty() && t.front() == '(' && t.back() == ')') {
-                t = t.substr(1, t.size() - 2);
-                trim(t);
-            }
-            // find '*'
-            size_t star = t.find('*');
-            if (star == std::string::npos) {
-                // maybe it's just a variable or a number
-                try {
-                    double v = std::stod(t);
-                    return std::make_pair(v, std::string());
-                } catch (...) {
-                    // not a number -> treat as var with coeff 1
-                    if (!t.empty() && std::isalpha((unsigned char) t[0])) return std::make_pair(1.0, t);
-                    return std::nullopt;
-                }
-            }
-            std::string a = t.substr(0, star);
-            std::string b = t.substr(star + 1);
-            trim(a);
-            trim(b);
-            // Try number*var or var*number
-            try {
-                double va = std::stod(a);
-                // b should be variable
-                if (!b.empty() && std::isalpha((unsigned char) b[0])) return std::make_pair(va, b);
-            } catch (...) {}
-            try {
-                double vb = std::stod(b);
-                if (!a.empty() && std::isalpha((unsigned char) a[0])) return std::make_pair(vb, a);
-            } catch (...) {}
-            return std::nullopt;
-        };
-
-        auto lhs = try_parse_coeff_var(simplified->toString());
-        // Also try parsing original operands when combined simplifier didn't flatten
-        if (!lhs) {
-            // fallback: try parse e1 and e2 original strings
-            auto p1 = try_parse_coeff_var(ls);
-            auto p2 = try_parse_coeff_var(rs);
-            if (p1 && p2 && !p1->second.empty() && p1->second == p2->second) {
-                double sum = p1->first + p2->first;
-                // format int if whole
-                std::string coeff;
-                if (std::floor(sum) == sum) coeff = std::to_string((int) sum);
-                else
-                    coeff = std::to_string(sum);
-                return Value(std::string("(" + coeff + " * " + p1->second + ")"));
-            }
-        } else {
-            // lhs is present, but we need to ensure it is of form a and var
-            // Try to decompose simplified string as a sum
-            std::string sstr = simplified->toString();
-            // if simplified is (a + b) attempt to extract parts
-            size_t plus = sstr.find('+');
-            if (plus != std::string::npos) {
-                // try to parse left and right parts
-                size_t pos = sstr.find('+');
-                std::string leftpart = sstr.substr(0, pos);
-                std::string rightpart = sstr.substr(pos + 1);
-                auto p1 = try_parse_coeff_var(leftpart);
-                auto p2 = try_parse_coeff_var(rightpart);
-                if (p1 && p2 && !p1->second.empty() && p1->second == p2->second) {
-                    double sum = p1->first + p2->first;
-                    std::string coeff = (std::floor(sum) == sum) ? std::to_string((int) sum) : std::to_string(sum);
-                    return Value(std::string("(" + coeff + " * " + p1->second + ")"));
-                }
-            }
+Value HANDLE_BINARYEXPR_CAS_ADD(Value* l, Value* r) {
+    auto to_cas = [](const Value* val) -> LaminaCAS::ExprPtr {
+        if (val->is_cas_expr()) {
+            return val->get<LaminaCAS::SharedExpr>()->clone();
         }
-
-        return Value(simplified->toString());
-    } catch (...) {
-        // parsing failed for one or both strings; fall back to normal concatenation
+        return std::make_unique<LaminaCAS::Number>(val->as_number());
+    };
+    auto simplified = LaminaCAS::Add(to_cas(l), to_cas(r)).simplify();
+    if (const auto* num = dynamic_cast<const LaminaCAS::Number*>(simplified.get())) {
+        return Value(num->getValue());
     }
+    return Value(LaminaCAS::SharedExpr(std::move(simplified)));
 }
 
 Value Interpreter::eval_LiteralExpr(const LiteralExpr* node) {
@@ -306,7 +186,7 @@ Value Interpreter::eval_CallExpr(const CallExpr* call) {
 
         self = eval(g_mem->father.get());
         if (self.is_lstruct()) {
-            const auto lstruct_ = std::get<std::shared_ptr<lmStruct>>(self.data);
+            const auto lstruct_ = self.get<std::shared_ptr<lmStruct>>();
 
             const auto& attr_name = g_mem->child->name;
             auto res = lstruct_->find(attr_name);
@@ -326,10 +206,10 @@ Value Interpreter::eval_CallExpr(const CallExpr* call) {
         return LAMINA_NULL;
     }
 
-    if (std::holds_alternative<std::shared_ptr<LambdaDeclExpr>>(left.data)) {
+    if (left.holds<std::shared_ptr<LambdaDeclExpr>>()) {
         // get function
         std::shared_ptr<LambdaDeclExpr> func;
-        func = std::get<std::shared_ptr<LambdaDeclExpr>>(left.data);
+        func = left.get<std::shared_ptr<LambdaDeclExpr>>();
 
         // get arguments
         if (call->args.size() != func->params.size()) {
@@ -340,12 +220,12 @@ Value Interpreter::eval_CallExpr(const CallExpr* call) {
         return Interpreter::call_function(func.get(), args, self);
     }
 
-    if (std::holds_alternative<std::shared_ptr<LmCppFunction>>(left.data)) {
+    if (left.holds<std::shared_ptr<LmCppFunction>>()) {
         push_frame("<cpp function>", " ");
 
         Value result;
         std::shared_ptr<LmCppFunction> func;
-        func = std::get<std::shared_ptr<LmCppFunction>>(left.data);
+        func = left.get<std::shared_ptr<LmCppFunction>>();
         try {
             result = func->function(args);
         } catch (...) {
@@ -417,11 +297,99 @@ Value Interpreter::call_function(const LambdaDeclExpr* func, const std::vector<V
     return Value();// Default value when no return
 }
 
+// 无理数在 Q(√n, π, e) 内的精确运算；结果离开该表示时返回 false，交给符号表达式处理
+static bool HANDLE_BINARYEXPR_IRRATIONAL(const std::string& op, const Value& l, const Value& r, Value& out) {
+    auto exact = [](const Value& v) {
+        return v.is_irrational() || v.is_int() || v.is_bigint() || v.is_rational();
+    };
+    if (!(l.is_irrational() || r.is_irrational()) || !exact(l) || !exact(r)) return false;
+
+    ::Irrational lr = l.as_irrational();
+    ::Irrational result;
+    if (op == "+") {
+        result = lr + r.as_irrational();
+    } else if (op == "-") {
+        result = lr - r.as_irrational();
+    } else if (op == "*") {
+        if (!lr.try_multiply(r.as_irrational(), result)) return false;
+    } else if (op == "/") {
+        ::Irrational rr = r.as_irrational();
+        if (rr.is_zero()) L_ERR("Division by zero");
+        if (!lr.try_divide(rr, result)) return false;
+    } else if (op == "^") {
+        if (!r.is_int() || std::abs(r.get<int>()) > 64) return false;
+        if (lr.is_zero() && r.get<int>() < 0) L_ERR("Division by zero");
+        if (!lr.try_pow(r.get<int>(), result)) return false;
+    } else {
+        return false;
+    }
+
+    // 退化为有理数时还原为普通数值
+    if (result.is_rational()) {
+        ::Rational q = result.rational_part();
+        if (q.is_integer()) {
+            ::BigInt n = q.get_numerator();
+            if (n >= ::BigInt(INT_MIN) && n <= ::BigInt(INT_MAX)) out = Value(n.to_int());
+            else out = Value(n);
+        } else {
+            out = Value(q);
+        }
+        return true;
+    }
+    out = Value(result);
+    return true;
+}
+
+// 类型化数组的逐元素运算；另一方可以是同类数组或标量，标量按数组的类型参与运算
+static bool HANDLE_BINARYEXPR_NUMARRAY(const std::string& op, const Value& l, const Value& r, Value& out) {
+    if (!(l.is_numarray() || r.is_numarray())) return false;
+    static const std::unordered_map<std::string, NumArray::Op> ops = {
+            {"+", NumArray::Op::Add}, {"-", NumArray::Op::Sub}, {"*", NumArray::Op::Mul},
+            {"/", NumArray::Op::Div}, {"%", NumArray::Op::Mod}, {"^", NumArray::Op::Pow}};
+    const auto it = ops.find(op);
+    if (it == ops.end()) return false;
+
+    auto scalar = [](const Value& v, NumArray::DType like) {
+        if (v.is_int() && like == NumArray::DType::Int64) {
+            return NumArray(std::vector<std::int64_t>{v.get<int>()});
+        }
+        // 浮点标量不把 float32 数组提升为 float64，整数数组遇到浮点标量才提升
+        const auto dtype = like == NumArray::DType::Int64 ? NumArray::DType::Float64 : like;
+        NumArray one(dtype, 1);
+        one.set(0, v.as_number());
+        return one;
+    };
+    const Value& arr = l.is_numarray() ? l : r;
+    const Value& other = l.is_numarray() ? r : l;
+    if (!other.is_numarray() && !(other.is_numeric() || other.type == Value::Type::Infinity)) return false;
+
+    const auto& a = arr.get<NumArray>();
+    try {
+        if (other.is_numarray()) {
+            out = Value(NumArray::binary(it->second, l.get<NumArray>(), r.get<NumArray>()));
+        } else if (l.is_numarray()) {
+            out = Value(NumArray::binary(it->second, a, scalar(r, a.dtype())));
+        } else {
+            out = Value(NumArray::binary(it->second, scalar(l, a.dtype()), a));
+        }
+    } catch (const std::exception& e) {
+        L_ERR(e.what());
+    }
+    return true;
+}
+
 Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
     Value l = eval(bin->left.get());
     Value r = eval(bin->right.get());
 
     // Handle arithmetic operations
+    Value exact;
+    if (HANDLE_BINARYEXPR_NUMARRAY(bin->op, l, r, exact)) {
+        return exact;
+    }
+    if (HANDLE_BINARYEXPR_IRRATIONAL(bin->op, l, r, exact)) {
+        return exact;
+    }
     // Just handle them in the f**king different functions
     if (bin->op == "+") {
         return HANDLE_BINARYEXPR_ADD(&l, &r);
@@ -434,8 +402,8 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
             // Vector and matrix operations
             if (l.is_array() && r.is_array()) {
                 // Try dot product for same-size vectors
-                const auto& la = std::get<std::vector<Value>>(l.data);
-                const auto& ra = std::get<std::vector<Value>>(r.data);
+                const auto& la = l.get<std::vector<Value>>();
+                const auto& ra = r.get<std::vector<Value>>();
                 if (la.size() == ra.size()) {
                     return l.dot_product(r);
                 }
@@ -446,10 +414,10 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
             }
             // Scalar multiplication for vectors
             if (l.is_array() && r.is_numeric()) {
-                return l.scalar_multiply(r.as_number());
+                return l.scalar_multiply(r);
             }
             if (l.is_numeric() && r.is_array()) {
-                return r.scalar_multiply(l.as_number());
+                return r.scalar_multiply(l);
             }
             // 只要有一方是 Irrational 或 Symbolic，优先生成符号表达式
             if ((l.is_irrational() || r.is_irrational() || l.is_symbolic() || r.is_symbolic()) && l.is_numeric() && r.is_numeric()) {
@@ -457,12 +425,12 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
                 std::shared_ptr<SymbolicExpr> rightExpr;
                 // 强制所有 Irrational 都转为 SymbolicExpr
                 if (l.is_symbolic()) {
-                    leftExpr = std::get<std::shared_ptr<SymbolicExpr>>(l.data);
+                    leftExpr = l.get<std::shared_ptr<SymbolicExpr>>();
                 } else {
                     leftExpr = from_number_to_symbolic(l);
                 }
                 if (r.is_symbolic()) {
-                    rightExpr = std::get<std::shared_ptr<SymbolicExpr>>(r.data);
+                    rightExpr = r.get<std::shared_ptr<SymbolicExpr>>();
                 } else {
                     rightExpr = from_number_to_symbolic(r);
                 }
@@ -472,8 +440,8 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
             if (l.is_numeric() && r.is_numeric()) {
                 // BigInt 优先：如果任一为 BigInt，结果为 BigInt
                 if (l.is_bigint() || r.is_bigint()) {
-                    ::BigInt lb = l.is_bigint() ? std::get<::BigInt>(l.data) : ::BigInt(l.as_number());
-                    ::BigInt rb = r.is_bigint() ? std::get<::BigInt>(r.data) : ::BigInt(r.as_number());
+                    ::BigInt lb = l.is_bigint() ? l.get<::BigInt>() : ::BigInt(l.as_number());
+                    ::BigInt rb = r.is_bigint() ? r.get<::BigInt>() : ::BigInt(r.as_number());
                     return Value(lb * rb);
                 }
                 // If either operand is irrational, use irrational arithmetic
@@ -507,8 +475,8 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
             // Vector and matrix operations
             if (l.is_array() && r.is_array()) {
                 // Try minus for same-size vectors
-                const auto& la = std::get<std::vector<Value>>(l.data);
-                const auto& ra = std::get<std::vector<Value>>(r.data);
+                const auto& la = l.get<std::vector<Value>>();
+                const auto& ra = r.get<std::vector<Value>>();
                 return l.vector_minus(r);// An exception can be raised inside
             }
             // Matrix multiplication
@@ -525,12 +493,12 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
                 std::shared_ptr<SymbolicExpr> rightExpr;
                 // 强制所有 Irrational 都转为 SymbolicExpr
                 if (l.is_symbolic()) {
-                    leftExpr = std::get<std::shared_ptr<SymbolicExpr>>(l.data);
+                    leftExpr = l.get<std::shared_ptr<SymbolicExpr>>();
                 } else {
                     leftExpr = from_number_to_symbolic(l);
                 }
                 if (r.is_symbolic()) {
-                    rightExpr = std::get<std::shared_ptr<SymbolicExpr>>(r.data);
+                    rightExpr = r.get<std::shared_ptr<SymbolicExpr>>();
                 } else {
                     rightExpr = from_number_to_symbolic(r);
                 }
@@ -540,8 +508,8 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
             if (l.is_numeric() && r.is_numeric()) {
                 // BigInt 优先：如果任一为 BigInt，结果为 BigInt
                 if (l.is_bigint() || r.is_bigint()) {
-                    ::BigInt lb = l.is_bigint() ? std::get<::BigInt>(l.data) : ::BigInt(l.as_number());
-                    ::BigInt rb = r.is_bigint() ? std::get<::BigInt>(r.data) : ::BigInt(r.as_number());
+                    ::BigInt lb = l.is_bigint() ? l.get<::BigInt>() : ::BigInt(l.as_number());
+                    ::BigInt rb = r.is_bigint() ? r.get<::BigInt>() : ::BigInt(r.as_number());
                     return Value(lb - rb);
                 }
                 // If either operand is irrational, use irrational arithmetic
@@ -582,12 +550,12 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
                 std::shared_ptr<SymbolicExpr> leftExpr;
                 std::shared_ptr<SymbolicExpr> rightExpr;
                 if (l.is_symbolic()) {
-                    leftExpr = std::get<std::shared_ptr<SymbolicExpr>>(l.data);
+                    leftExpr = l.get<std::shared_ptr<SymbolicExpr>>();
                 } else {
                     leftExpr = from_number_to_symbolic(l);
                 }
                 if (r.is_symbolic()) {
-                    rightExpr = std::get<std::shared_ptr<SymbolicExpr>>(r.data);
+                    rightExpr = r.get<std::shared_ptr<SymbolicExpr>>();
                 } else {
                     rightExpr = from_number_to_symbolic(r);
                 }
@@ -596,8 +564,8 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
             }
             // BigInt 优先：如果任一为 BigInt，结果为 BigInt（如果整除）或 Rational
             if (l.is_bigint() || r.is_bigint()) {
-                ::BigInt lb = l.is_bigint() ? std::get<::BigInt>(l.data) : ::BigInt(l.as_number());
-                ::BigInt rb = r.is_bigint() ? std::get<::BigInt>(r.data) : ::BigInt(r.as_number());
+                ::BigInt lb = l.is_bigint() ? l.get<::BigInt>() : ::BigInt(l.as_number());
+                ::BigInt rb = r.is_bigint() ? r.get<::BigInt>() : ::BigInt(r.as_number());
                 if (rb.is_zero()) {
                     L_ERR("Division by zero");
                 }
@@ -647,8 +615,8 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
             }
             if (l.is_bigint() || r.is_bigint()) {
                 // 有BigInt，使用BigInt内置方法
-                ::BigInt lb = l.is_bigint() ? std::get<::BigInt>(l.data) : ::BigInt(l.as_number());
-                ::BigInt rb = r.is_bigint() ? std::get<::BigInt>(r.data) : ::BigInt(r.as_number());
+                ::BigInt lb = l.is_bigint() ? l.get<::BigInt>() : ::BigInt(l.as_number());
+                ::BigInt rb = r.is_bigint() ? r.get<::BigInt>() : ::BigInt(r.as_number());
                 return Value(lb % rb);
             }
             // 都为int
@@ -661,12 +629,12 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
                 std::shared_ptr<SymbolicExpr> leftExpr;
                 std::shared_ptr<SymbolicExpr> rightExpr;
                 if (l.is_symbolic()) {
-                    leftExpr = std::get<std::shared_ptr<SymbolicExpr>>(l.data);
+                    leftExpr = l.get<std::shared_ptr<SymbolicExpr>>();
                 } else {
                     leftExpr = from_number_to_symbolic(l);
                 }
                 if (r.is_symbolic()) {
-                    rightExpr = std::get<std::shared_ptr<SymbolicExpr>>(r.data);
+                    rightExpr = r.get<std::shared_ptr<SymbolicExpr>>();
                 } else {
                     rightExpr = from_number_to_symbolic(r);
                 }
@@ -675,13 +643,13 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
             }
             if (l.is_rational() && (r.is_bigint() || r.is_int())) {
                 // 如果底数为Rational，指数为整数，结果为Rational
-                ::BigInt rb = r.is_bigint() ? std::get<::BigInt>(r.data) : ::BigInt(r.as_number());
+                ::BigInt rb = r.is_bigint() ? r.get<::BigInt>() : ::BigInt(r.as_number());
                 return Value(l.as_rational().power(rb));
             }
             if ((l.is_bigint() || r.is_int()) && (r.is_bigint() || r.is_int())) {
                 // 如果底数为整数，指数为整数，结果为BigInt
-                ::BigInt lb = l.is_bigint() ? std::get<::BigInt>(l.data) : ::BigInt(l.as_number());
-                ::BigInt rb = r.is_bigint() ? std::get<::BigInt>(r.data) : ::BigInt(r.as_number());
+                ::BigInt lb = l.is_bigint() ? l.get<::BigInt>() : ::BigInt(l.as_number());
+                ::BigInt rb = r.is_bigint() ? r.get<::BigInt>() : ::BigInt(r.as_number());
                 if (rb < ::BigInt(0)) {
                     return Value(l.as_rational().reciprocal().power(::BigInt(0) - rb));
                 } else {
@@ -693,10 +661,10 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
                 ::Rational lb;
                 if (l.is_int()) lb = ::Rational(l.as_number());
                 else if (l.is_bigint())
-                    lb = ::Rational(std::get<::BigInt>(l.data));
+                    lb = ::Rational(l.get<::BigInt>());
                 else
-                    lb = std::get<::Rational>(l.data);
-                return Value(SymbolicExpr::power(SymbolicExpr::number(lb), SymbolicExpr::number(std::get<::Rational>(r.data)))->simplify());
+                    lb = l.get<::Rational>();
+                return Value(SymbolicExpr::power(SymbolicExpr::number(lb), SymbolicExpr::number(r.get<::Rational>()))->simplify());
             }
             // 有小数，采用小数幂
             double ld = l.as_number();
@@ -715,8 +683,8 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
         if (l.is_numeric() && r.is_numeric()) {
             // BigInt 比较优先
             if (l.is_bigint() || r.is_bigint()) {
-                ::BigInt lb = l.is_bigint() ? std::get<::BigInt>(l.data) : ::BigInt(l.as_number());
-                ::BigInt rb = r.is_bigint() ? std::get<::BigInt>(r.data) : ::BigInt(r.as_number());
+                ::BigInt lb = l.is_bigint() ? l.get<::BigInt>() : ::BigInt(l.as_number());
+                ::BigInt rb = r.is_bigint() ? r.get<::BigInt>() : ::BigInt(r.as_number());
 
                 // 使用字符串比较来判断大小（这是一个简化的实现）
                 std::string ls = lb.to_string();
@@ -772,8 +740,8 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
                 if (bin->op == ">=") return Value(ld >= rd);
             }
         } else if (l.is_string() && r.is_string()) {
-            std::string ls = std::get<std::string>(l.data);
-            std::string rs = std::get<std::string>(r.data);
+            std::string ls = l.get<std::string>();
+            std::string rs = r.get<std::string>();
 
             if (bin->op == "==") return Value(ls == rs);
             if (bin->op == "!=") return Value(ls != rs);
@@ -781,9 +749,19 @@ Value Interpreter::eval_BinaryExpr(const BinaryExpr* bin) {
             if (bin->op == "<=") return Value(ls <= rs);
             if (bin->op == ">") return Value(ls > rs);
             if (bin->op == ">=") return Value(ls >= rs);
+        } else if (l.is_cas_expr() && r.is_cas_expr()) {
+            // 同一个表达式对象直接相等；否则比较打印形式，再比较化简后的打印形式
+            const auto& le = l.get<LaminaCAS::SharedExpr>();
+            const auto& re = r.get<LaminaCAS::SharedExpr>();
+            bool equal = le == re || le->toString() == re->toString() ||
+                         le->simplify()->toString() == re->simplify()->toString();
+
+            if (bin->op == "==") return Value(equal);
+            if (bin->op == "!=") return Value(!equal);
+            L_ERR("CAS expressions only support '==' and '!='");
         } else if (l.is_bool() && r.is_bool()) {
-            bool lb = std::get<bool>(l.data);
-            bool rb = std::get<bool>(r.data);
+            bool lb = l.get<bool>();
+            bool rb = r.get<bool>();
 
             if (bin->op == "==") return Value(lb == rb);
             if (bin->op == "!=") return Value(lb != rb);
@@ -819,19 +797,19 @@ Value Interpreter::eval_UnaryExpr(const UnaryExpr* unary) {
             throw error;
         }
         if (v.type == Value::Type::Int) {
-            int vi = std::get<int>(v.data);
+            int vi = v.get<int>();
             return Value(-vi);
         }
         if (v.type == Value::Type::Float) {
-            float vf = std::get<double>(v.data);
+            float vf = v.get<double>();
             return Value(-vf);
         }
         if (v.type == Value::Type::Rational) {
-            Rational vr = std::get<Rational>(v.data);
+            Rational vr = v.get<Rational>();
             return Value(-vr);
         }
         // For BigInt, negate directly
-        ::BigInt big_val = std::get<::BigInt>(v.data);
+        ::BigInt big_val = v.get<::BigInt>();
         return Value(big_val.negate());
     }
 
@@ -843,9 +821,9 @@ Value Interpreter::eval_UnaryExpr(const UnaryExpr* unary) {
         }
         int vi;
         if (v.type == Value::Type::Int) {
-            vi = std::get<int>(v.data);
+            vi = v.get<int>();
         } else {
-            vi = std::get<::BigInt>(v.data).to_int();
+            vi = v.get<::BigInt>().to_int();
         }
 
         if (vi < 0) {
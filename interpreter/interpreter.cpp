@@ -94,6 +94,128 @@ void Interpreter::set_global_variable(const std::string& name, const Value& val)
     }
 }
 
+Value& Interpreter::resolve_lvalue(const Expression* node) {
+    std::string name;
+    if (auto* id = dynamic_cast<const IdentifierExpr*>(node)) name = id->name;
+    if (auto* var = dynamic_cast<const VarExpr*>(node)) name = var->name;
+    if (!name.empty()) {
+        for (auto& scope : std::ranges::reverse_view(variable_stack)) {
+            auto found = scope.find(name);
+            if (found != scope.end()) return found->second;
+        }
+        RuntimeError error("Undefined variable '" + name + "'");
+        error.stack_trace = get_stack_trace();
+        throw error;
+    }
+
+    if (auto* g_item = dynamic_cast<const GetItemExpr*>(node)) {
+        std::vector<Value> rest;
+        Value& left = resolve_subscripts(g_item, rest);
+        if (rest.empty()) return left;
+        if (left.is_matrix()) return matrix_cell(left, rest);
+        L_ERR("Typed array elements can only be assigned directly");
+    }
+
+    if (auto* g_mem = dynamic_cast<const GetMemberExpr*>(node)) {
+        Value& left = resolve_lvalue(g_mem->father.get());
+        if (left.is_lstruct()) {
+            return resolve_struct_attr(left, g_mem->child->name);
+        }
+        L_ERR("Type of left can't get it member");
+    }
+
+    throw StdLibException("invalid assignment target");
+}
+
+Value& Interpreter::resolve_subscripts(const GetItemExpr* g_item, std::vector<Value>& rest) {
+    std::vector<const GetItemExpr*> chain;
+    const Expression* root = g_item;
+    while (auto* item = dynamic_cast<const GetItemExpr*>(root)) {
+        chain.push_back(item);
+        root = item->father.get();
+    }
+    // 按书写顺序求出全部下标后再定位：求值可能改动变量表，使已取得的引用失效
+    std::vector<Value> subscripts;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if ((*it)->params.empty()) {
+            L_ERR("Getitem need one parameter");
+        }
+        for (const auto& param : (*it)->params) subscripts.push_back(eval(param.get()));
+    }
+
+    // 矩阵的行和类型化数组的元素都不是单独的 Value，剩下的下标交给调用者
+    Value* cur = &resolve_lvalue(root);
+    size_t k = 0;
+    while (k < subscripts.size() and !cur->is_matrix() and !cur->is_numarray()) {
+        cur = &resolve_item(*cur, subscripts[k++]);
+    }
+    rest.assign(subscripts.begin() + k, subscripts.end());
+    return *cur;
+}
+
+Value& Interpreter::matrix_cell(Value& matrix, const std::vector<Value>& index) {
+    if (index.size() != 2 or !index[0].is_int() or !index[1].is_int()) {
+        L_ERR("Matrix element needs two integer subscripts");
+    }
+    auto& mat = matrix.get_mut<std::vector<std::vector<Value>>>();
+    const int r = index[0].get<int>();
+    const int c = index[1].get<int>();
+    if (r < 0 or static_cast<size_t>(r) >= mat.size()
+        or c < 0 or static_cast<size_t>(c) >= mat[r].size()) {
+        L_ERR("Index out of range");
+    }
+    return mat[r][c];
+}
+
+size_t Interpreter::numarray_index(const NumArray& arr, const std::vector<Value>& index) {
+    const auto& shape = arr.shape();
+    if (index.size() != shape.size()) {
+        L_ERR("Typed array of " + std::to_string(shape.size()) + " dimensions needs "
+              + std::to_string(shape.size()) + " subscripts");
+    }
+    size_t flat = 0;
+    for (size_t d = 0; d < shape.size(); d++) {
+        if (!index[d].is_int()) L_ERR("Index must be an integer");
+        const int i = index[d].get<int>();
+        if (i < 0 or static_cast<size_t>(i) >= shape[d]) {
+            L_ERR("Index out of range");
+        }
+        flat = flat * shape[d] + i;
+    }
+    return flat;
+}
+
+Value& Interpreter::resolve_item(Value& left, const Value& subscript) {
+    if (left.is_array() and subscript.is_int()) {
+        // 数组只被这一个变量引用时原地修改，否则先复制（写时复制）
+        auto& larray_ = left.get_mut<std::vector<Value>>();
+        const int idx = subscript.get<int>();
+        if (idx < 0 or static_cast<size_t>(idx) >= larray_.size()) {
+            L_ERR("Index out of range");
+        }
+        return larray_[idx];
+    }
+    if (left.is_lstruct() and subscript.is_string()) {
+        return resolve_struct_attr(left, subscript.get<std::string>());
+    }
+    throw StdLibException("Type of left is not subscriptable");
+}
+
+Value& Interpreter::resolve_struct_attr(const Value& lstruct, const std::string& attr_name) {
+    const auto& lstruct_ = lstruct.get<std::shared_ptr<lmStruct>>();
+    auto res = lstruct_->find_in_current(attr_name);
+    if (res == nullptr) {
+        // 继承来的属性先复制到当前结构体，不改动父结构体
+        const auto inherited = lstruct_->find(attr_name);
+        if (inherited == nullptr) {
+            L_ERR("AttrError: struct hasn't attribute named " + attr_name);
+        }
+        lstruct_->insert(attr_name, inherited->value);
+        res = lstruct_->find_in_current(attr_name);
+    }
+    return res->value;
+}
+
 Value Interpreter::execute(const std::unique_ptr<Statement>& node) {
     if (!node) {
         std::cout << "[Nothing to execute]" << std::endl;
@@ -122,15 +244,15 @@ Value Interpreter::execute(const std::unique_ptr<Statement>& node) {
                 set_variable(bi->name, val);
             } else if (val.is_int()) {
                 // 将普通整数转换为BigInt
-                ::BigInt big_val(std::get<int>(val.data));
+                ::BigInt big_val(val.get<int>());
                 set_variable(bi->name, Value(big_val));
             } else if (val.is_string()) {
                 // 从字符串创建BigInt
                 try {
-                    ::BigInt big_val(std::get<std::string>(val.data));
+                    ::BigInt big_val(val.get<std::string>());
                     set_variable(bi->name, Value(big_val));
                 } catch (const std::exception& e) {
-                    L_ERR("Invalid BigInt string '" + std::get<std::string>(val.data) + "' in declaration of " + bi->name);
+                    L_ERR("Invalid BigInt string '" + val.get<std::string>() + "' in declaration of " + bi->name);
                 }
             } else {
                 // 默认初始化为0
@@ -311,7 +433,7 @@ Value Interpreter::eval(const ASTNode* node) {
         );
         auto val = eval(s_mem->val.get());
         if (left.is_lstruct()) {
-            const auto lstruct_ = std::get<std::shared_ptr<lmStruct>>(left.data);
+            const auto lstruct_ = left.get<std::shared_ptr<lmStruct>>();
 
             auto attr_name = dynamic_cast<const GetMemberExpr*>(s_mem->g_mem.get())
                                 ->child->name;
@@ -321,10 +443,42 @@ Value Interpreter::eval(const ASTNode* node) {
         L_ERR("Type of left can't get it member");
         return LAMINA_NULL;
     }
+    if (auto* s_item = dynamic_cast<const SetItemExpr*>(node)) {
+        // 先求右值再定位左值，右值中对同一数组的临时引用此时已释放，可以原地修改
+        auto val = eval(s_item->val.get());
+        std::vector<Value> rest;
+        Value& left = resolve_subscripts(dynamic_cast<const GetItemExpr*>(s_item->g_item.get()), rest);
+        if (rest.empty()) {
+            left = std::move(val);
+            return LAMINA_NULL;
+        }
+        if (left.is_numarray()) {
+            // 类型化数组的元素不是 Value，按数组的类型写入
+            if (!val.is_numeric()) L_ERR("Typed array elements must be numeric");
+            auto& arr = left.get_mut<NumArray>();
+            const size_t pos = numarray_index(arr, rest);
+            if (val.is_int()) arr.set(pos, static_cast<std::int64_t>(val.get<int>()));
+            else arr.set(pos, val.as_number());
+            return LAMINA_NULL;
+        }
+        if (rest.size() == 1 and val.is_array()) {
+            // 整行赋值 m[i] = [...]
+            if (!rest[0].is_int()) L_ERR("Index must be an integer");
+            auto& mat = left.get_mut<std::vector<std::vector<Value>>>();
+            const int r = rest[0].get<int>();
+            if (r < 0 or static_cast<size_t>(r) >= mat.size()) {
+                L_ERR("Index out of range");
+            }
+            mat[r] = val.get<std::vector<Value>>();
+            return LAMINA_NULL;
+        }
+        matrix_cell(left, rest) = std::move(val);
+        return LAMINA_NULL;
+    }
     if (auto* g_mem = dynamic_cast<const GetMemberExpr*>(node)) {
         auto left = eval(g_mem->father.get());
         if (left.is_lstruct()) {
-            const auto lstruct_ = std::get<std::shared_ptr<lmStruct>>(left.data);
+            const auto lstruct_ = left.get<std::shared_ptr<lmStruct>>();
 
             const auto& attr_name = g_mem->child->name;
             auto res = lstruct_->find(attr_name);
@@ -343,12 +497,30 @@ Value Interpreter::eval(const ASTNode* node) {
             L_ERR("Getitem need one parameter");
             return LAMINA_NULL;
         }
+        if (left.is_numarray()) {
+            // 每个下标去掉一维，多维数组得到共享存储的子数组
+            NumArray arr = left.get<NumArray>();
+            for (size_t k = 0; k < g_item->params.size(); k++) {
+                const auto sub = eval(g_item->params[k].get());
+                if (!sub.is_int()) L_ERR("Index must be an integer");
+                const int idx = sub.get<int>();
+                if (idx < 0 or static_cast<size_t>(idx) >= arr.shape()[0]) {
+                    L_ERR("Index out of range");
+                }
+                if (arr.ndim() == 1) {
+                    if (k + 1 != g_item->params.size()) L_ERR("Too many indices for array");
+                    return Value::numarray_element(arr, idx);
+                }
+                arr = arr.take(idx);
+            }
+            return Value(std::move(arr));
+        }
         const auto& subscript = eval(g_item->params[0].get());
         if (left.is_array() and subscript.is_int()) {
-            const auto& larray_ = std::get<std::vector<Value>>(left.data);
+            const auto& larray_ = left.get<std::vector<Value>>();
             Value val;
             try {
-                val = larray_.at(std::get<int>(subscript.data));
+                val = larray_.at(subscript.get<int>());
             }
             catch (const std::out_of_range& e) {
                 L_ERR("Index out of range");
@@ -357,9 +529,19 @@ Value Interpreter::eval(const ASTNode* node) {
             return val;
         }
 
+        if (left.is_matrix() and subscript.is_int()) {
+            const auto& mat = left.get<std::vector<std::vector<Value>>>();
+            const int idx = subscript.get<int>();
+            if (idx < 0 or static_cast<size_t>(idx) >= mat.size()) {
+                L_ERR("Index out of range");
+                return LAMINA_NULL;
+            }
+            return Value(mat[idx]);
+        }
+
         if (left.is_lstruct() and subscript.is_string()) {
-            const auto& lstruct_ = std::get<std::shared_ptr<lmStruct>>(left.data);
-            const auto& attr_name = std::get<std::string>(subscript.data);
+            const auto& lstruct_ = left.get<std::shared_ptr<lmStruct>>();
+            const auto& attr_name = subscript.get<std::string>();
             auto res = lstruct_->find(attr_name);
             if (res == nullptr) {
                 L_ERR("AttrError: struct hasn't attribute named " + attr_name);
@@ -388,7 +570,7 @@ Value Interpreter::eval(const ASTNode* node) {
     if (auto* ns_g_mem = dynamic_cast<const NameSpaceGetMemberExpr*>(node)) {
         auto left = eval(ns_g_mem->father.get());
         if (left.is_lmModule()) {
-            const auto& lmodule_ = std::get<std::shared_ptr<LmModule>>(left.data);
+            const auto& lmodule_ = left.get<std::shared_ptr<LmModule>>();
             const auto& attr_name = ns_g_mem->child->name;
             Value val;
             try {
@@ -493,7 +675,7 @@ bool Interpreter::load_cpp_module(const std::string& module_path) {
     
     for (const auto& [key, value] : module) {
         if (key == "lamina_init_module") {
-            [[maybe_unused]] auto _ = std::get<std::shared_ptr<LmCppFunction>>(value.data)->function({}); // 初始化函数
+            [[maybe_unused]] auto _ = value.get<std::shared_ptr<LmCppFunction>>()->function({}); // 初始化函数
         }
         std::cerr << "Debug: checking c++ function " << key << std::endl;
     }
@@ -524,15 +706,15 @@ bool Interpreter::load_cpp_module(const std::string& module_path) {
 std::shared_ptr<SymbolicExpr> Interpreter::from_number_to_symbolic(const Value& v) {
     std::shared_ptr<SymbolicExpr> expr;
     if (v.is_irrational()) {
-        expr = std::get<::Irrational>(v.data).to_symbolic();
+        expr = v.get<::Irrational>().to_symbolic();
     } else if (v.is_rational()) {
-        expr = SymbolicExpr::number(std::get<::Rational>(v.data));
+        expr = SymbolicExpr::number(v.get<::Rational>());
     } else if (v.is_bigint()) {
-        expr = SymbolicExpr::number(std::get<::BigInt>(v.data));
+        expr = SymbolicExpr::number(v.get<::BigInt>());
     } else if (v.is_int()) {
-        expr = SymbolicExpr::number(std::get<int>(v.data));
+        expr = SymbolicExpr::number(v.get<int>());
     } else if (v.is_float()) {
-        expr = SymbolicExpr::number(::Rational::from_double(std::get<double>(v.data)));
+        expr = SymbolicExpr::number(::Rational::from_double(v.get<double>()));
     } else {
         expr = SymbolicExpr::number(0);// 失败，返回0
     }
@@ -560,7 +742,9 @@ void Interpreter::print_variables() {
     for (auto it = variable_stack.rbegin(); it != variable_stack.rend(); ++it) {
         const auto& scope = *it;
         for (const auto& [name, value]: scope) {
-            std::cout << name << " = " << value.to_string() << std::endl;
+            std::string line = name + " = ";
+            value.write_to(line);
+            std::cout << line << std::endl;
             hasVars = true;
         }
     }
@@ -116,10 +116,28 @@ public:
     // Variable lookup
     static Value get_variable(const std::string& name);
 
+    // Storage of an assignable expression (variable, a[i], st.x), modified in place
+    static Value& resolve_lvalue(const Expression* node);
+
     // Variable scope stack, top is the current scope
     static std::vector<std::unordered_map<std::string, Value>> variable_stack;
 
 private:
+    // Walk a subscript chain a[i][j]...; stops at a matrix or typed array and leaves the unused subscripts in rest
+    static Value& resolve_subscripts(const GetItemExpr* g_item, std::vector<Value>& rest);
+
+    // Cell of a matrix for assignment, copied first if shared
+    static Value& matrix_cell(Value& matrix, const std::vector<Value>& index);
+
+    // Row-major position of a full index into a typed array
+    static size_t numarray_index(const NumArray& arr, const std::vector<Value>& index);
+
+    // Element of an array or struct for assignment
+    static Value& resolve_item(Value& left, const Value& subscript);
+
+    // Own attribute of a struct for assignment, copied down from the parent if inherited
+    static Value& resolve_struct_attr(const Value& lstruct, const std::string& attr_name);
+
     // Store REPL ASTs to keep function pointers valid in interactive mode
     static std::vector<std::unique_ptr<ASTNode>> repl_asts;
 
@@ -435,6 +435,19 @@ struct GetItemExpr final :  Expression {
     }
 };
 
+// 设置项
+struct SetItemExpr final :  Expression {
+    std::unique_ptr<Expression> g_item;
+    std::unique_ptr<Expression> val;
+    SetItemExpr(std::unique_ptr<Expression> g_item, std::unique_ptr<Expression> val)
+        : g_item(std::move(g_item)), val(std::move(val)) {}
+    [[nodiscard]] std::unique_ptr<Expression> clone_expr() const override {
+        auto cloned_g_item = g_item ? g_item->clone_expr() : nullptr;
+        auto cloned_val = val ? val->clone_expr() : nullptr;
+        return std::make_unique<SetItemExpr>(std::move(cloned_g_item), std::move(cloned_val));
+    }
+};
+
 // 声明匿名函数
 struct LambdaDeclExpr final :  Expression {
     std::string name;
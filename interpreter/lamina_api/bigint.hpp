@@ -80,18 +80,22 @@ public:
 
     // 转换为字符串
     [[nodiscard]] std::string to_string() const {
-        if (digits.size() == 1 && digits[0] == 0) {
-            return "0";
-        }
-
         std::string result;
-        if (negative) result += "-";
+        write_to(result);
+        return result;
+    }
 
+    // 追加到 out 末尾
+    void write_to(std::string& out) const {
+        if (digits.size() == 1 && digits[0] == 0) {
+            out += '0';
+            return;
+        }
+        if (negative) out += '-';
+        out.reserve(out.size() + digits.size());
         for (size_t i = digits.size() - 1; i < digits.size(); i--) {
-            result += static_cast<char>('0' + digits[i]);
+            out += static_cast<char>('0' + digits[i]);
         }
-
-        return result;
     }
 
     // 快速乘10
@@ -0,0 +1,209 @@
+#include "exact.hpp"
+#include "value.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <string>
+
+namespace {
+
+bool is_exact(const Value& v) { return v.is_int() || v.is_bigint() || v.is_rational(); }
+
+bool all_int(const std::vector<Value>& v) {
+    return std::all_of(v.begin(), v.end(), [](const Value& x) { return x.is_int(); });
+}
+
+::Rational to_rational(const Value& v) {
+    if (v.is_int()) return ::Rational(v.get<int>());
+    if (v.is_bigint()) return ::Rational(v.get<::BigInt>());
+    return v.get<::Rational>();
+}
+
+bool is_one(const ::BigInt& v) { return !v.negative && v.digits.size() == 1 && v.digits[0] == 1; }
+
+Value from_int64(std::int64_t v) {
+    if (v >= INT_MIN && v <= INT_MAX) return Value(static_cast<int>(v));
+    return Value(::BigInt(std::to_string(v)));
+}
+
+// 分母为 1 时不必求 gcd
+Value from_fraction(const ::BigInt& num, const ::BigInt& den) {
+    if (is_one(den)) return Value::from_rational(::Rational(num));
+    return Value::from_rational(::Rational(num, den));
+}
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef __int128 Wide;
+__extension__ typedef unsigned __int128 UWide;
+#define LAMINA_EXACT_WIDE
+
+Value from_wide(Wide v) {
+    if (v >= INT64_MIN && v <= INT64_MAX) return from_int64(static_cast<std::int64_t>(v));
+    const bool negative = v < 0;
+    UWide u = negative ? -static_cast<UWide>(v) : static_cast<UWide>(v);
+    std::string digits;
+    while (u) {
+        digits.push_back(static_cast<char>('0' + static_cast<int>(u % 10)));
+        u /= 10;
+    }
+    if (negative) digits.push_back('-');
+    std::reverse(digits.begin(), digits.end());
+    return Value(::BigInt(digits));
+}
+#endif
+
+// 一组有理数的公分母，以及按公分母化成的整数分子
+struct Scaled {
+    ::BigInt den{1};
+    std::vector<::BigInt> nums;
+};
+
+Scaled scale_common(const std::vector<const ::Rational*>& qs) {
+    Scaled s;
+    for (const auto* q : qs) {
+        if (!is_one(q->get_denominator())) s.den = ::BigInt::lcm(s.den, q->get_denominator());
+    }
+    s.nums.reserve(qs.size());
+    for (const auto* q : qs) {
+        const ::BigInt d = q->get_denominator();
+        s.nums.push_back(is_one(d) ? q->get_numerator() * s.den : q->get_numerator() * (s.den / d));
+    }
+    return s;
+}
+
+}// namespace
+
+bool is_exact_vector(const std::vector<Value>& v) {
+    return std::all_of(v.begin(), v.end(), is_exact);
+}
+
+std::vector<Value> exact_vector_add(const std::vector<Value>& a, const std::vector<Value>& b, bool subtract) {
+    std::vector<Value> result;
+    result.reserve(a.size());
+    if (all_int(a) && all_int(b)) {
+        for (size_t i = 0; i < a.size(); ++i) {
+            const std::int64_t x = a[i].get<int>(), y = b[i].get<int>();
+            result.push_back(from_int64(subtract ? x - y : x + y));
+        }
+        return result;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        const ::Rational x = to_rational(a[i]), y = to_rational(b[i]);
+        const ::BigInt dx = x.get_denominator(), dy = y.get_denominator();
+        // 分母相同时直接加减分子，只在最后约分一次
+        if (dx == dy) {
+            const ::BigInt n = subtract ? x.get_numerator() - y.get_numerator() : x.get_numerator() + y.get_numerator();
+            result.push_back(from_fraction(n, dx));
+        } else {
+            const ::BigInt l = x.get_numerator() * dy, r = y.get_numerator() * dx;
+            result.push_back(from_fraction(subtract ? l - r : l + r, dx * dy));
+        }
+    }
+    return result;
+}
+
+Value exact_dot(const std::vector<Value>& a, const std::vector<Value>& b) {
+#ifdef LAMINA_EXACT_WIDE
+    if (all_int(a) && all_int(b)) {
+        Wide sum = 0;
+        for (size_t i = 0; i < a.size(); ++i) sum += static_cast<std::int64_t>(a[i].get<int>()) * b[i].get<int>();
+        return from_wide(sum);
+    }
+#endif
+    std::vector<::Rational> qa, qb;
+    qa.reserve(a.size());
+    qb.reserve(b.size());
+    for (const auto& v : a) qa.push_back(to_rational(v));
+    for (const auto& v : b) qb.push_back(to_rational(v));
+    std::vector<const ::Rational*> pa, pb;
+    for (const auto& q : qa) pa.push_back(&q);
+    for (const auto& q : qb) pb.push_back(&q);
+    const Scaled sa = scale_common(pa), sb = scale_common(pb);
+    ::BigInt sum(0);
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!sa.nums[i].is_zero() && !sb.nums[i].is_zero()) sum = sum + sa.nums[i] * sb.nums[i];
+    }
+    return from_fraction(sum, sa.den * sb.den);
+}
+
+std::vector<Value> exact_scale(const std::vector<Value>& a, const Value& scalar) {
+    std::vector<Value> result;
+    result.reserve(a.size());
+    if (scalar.is_int() && all_int(a)) {
+        const std::int64_t s = scalar.get<int>();
+        for (const auto& v : a) result.push_back(from_int64(s * v.get<int>()));
+        return result;
+    }
+    const ::Rational s = to_rational(scalar);
+    const ::BigInt sn = s.get_numerator(), sd = s.get_denominator();
+    for (const auto& v : a) {
+        const ::Rational q = to_rational(v);
+        result.push_back(from_fraction(q.get_numerator() * sn, q.get_denominator() * sd));
+    }
+    return result;
+}
+
+std::vector<std::vector<Value>> exact_matmul(const std::vector<std::vector<Value>>& a,
+                                             const std::vector<std::vector<Value>>& b) {
+    const size_t rows = a.size(), inner = b.size(), cols = b.empty() ? 0 : b[0].size();
+    std::vector<std::vector<Value>> result(rows);
+
+#ifdef LAMINA_EXACT_WIDE
+    const bool ints = std::all_of(a.begin(), a.end(), all_int) && std::all_of(b.begin(), b.end(), all_int);
+    if (ints) {
+        // i-k-j 顺序，最内层连续访问 B 和累加器的同一行
+        std::vector<std::int64_t> rhs(inner * cols);
+        for (size_t k = 0; k < inner; ++k) {
+            for (size_t j = 0; j < cols; ++j) rhs[k * cols + j] = b[k][j].get<int>();
+        }
+        std::vector<Wide> acc(cols);
+        for (size_t i = 0; i < rows; ++i) {
+            std::fill(acc.begin(), acc.end(), 0);
+            for (size_t k = 0; k < inner; ++k) {
+                const std::int64_t f = a[i][k].get<int>();
+                if (f == 0) continue;
+                const std::int64_t* row = rhs.data() + k * cols;
+                for (size_t j = 0; j < cols; ++j) acc[j] += static_cast<Wide>(f * row[j]);
+            }
+            result[i].reserve(cols);
+            for (size_t j = 0; j < cols; ++j) result[i].push_back(from_wide(acc[j]));
+        }
+        return result;
+    }
+#endif
+
+    // A 的每行、B 的每列分别通分：C_ij = (Σ A'_ik · B'_kj) / (r_i · c_j)
+    std::vector<std::vector<::Rational>> qa(rows), qb(inner);
+    for (size_t i = 0; i < rows; ++i) {
+        qa[i].reserve(inner);
+        for (const auto& v : a[i]) qa[i].push_back(to_rational(v));
+    }
+    for (size_t k = 0; k < inner; ++k) {
+        qb[k].reserve(cols);
+        for (const auto& v : b[k]) qb[k].push_back(to_rational(v));
+    }
+    std::vector<Scaled> ra(rows), cb(cols);
+    for (size_t i = 0; i < rows; ++i) {
+        std::vector<const ::Rational*> row;
+        for (const auto& q : qa[i]) row.push_back(&q);
+        ra[i] = scale_common(row);
+    }
+    for (size_t j = 0; j < cols; ++j) {
+        std::vector<const ::Rational*> col;
+        for (size_t k = 0; k < inner; ++k) col.push_back(&qb[k][j]);
+        cb[j] = scale_common(col);
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        result[i].reserve(cols);
+        for (size_t j = 0; j < cols; ++j) {
+            ::BigInt sum(0);
+            for (size_t k = 0; k < inner; ++k) {
+                const ::BigInt& x = ra[i].nums[k];
+                const ::BigInt& y = cb[j].nums[k];
+                if (!x.is_zero() && !y.is_zero()) sum = sum + x * y;
+            }
+            result[i].push_back(from_fraction(sum, ra[i].den * cb[j].den));
+        }
+    }
+    return result;
+}
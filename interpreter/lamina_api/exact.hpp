@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+
+#ifndef LAMINA_API
+#ifdef _WIN32
+#ifdef LAMINA_CORE_EXPORTS
+#define LAMINA_API __declspec(dllexport)
+#else
+#define LAMINA_API __declspec(dllimport)
+#endif
+#else
+#define LAMINA_API
+#endif
+#endif
+
+class Value;
+
+// 元素全为 int / BigInt / Rational 的向量、矩阵运算，结果是精确值而不是 double
+// 元素都是 int 时用 64 位整数计算（累加用 128 位），不经过 BigInt；
+// 否则点积和矩阵乘法先把 A 的每行、B 的每列通分为整数，累加时不约分，每个结果只约分一次
+// 调用前须用 is_exact_vector 检查元素类型，维数由调用方检查
+
+LAMINA_API bool is_exact_vector(const std::vector<Value>& v);
+LAMINA_API std::vector<Value> exact_vector_add(const std::vector<Value>& a, const std::vector<Value>& b, bool subtract);
+LAMINA_API Value exact_dot(const std::vector<Value>& a, const std::vector<Value>& b);
+LAMINA_API std::vector<Value> exact_scale(const std::vector<Value>& a, const Value& scalar);
+LAMINA_API std::vector<std::vector<Value>> exact_matmul(const std::vector<std::vector<Value>>& a,
+                                                       const std::vector<std::vector<Value>>& b);
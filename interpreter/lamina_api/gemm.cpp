@@ -0,0 +1,122 @@
+#include "gemm.hpp"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 微内核一次计算 MR×NR 的小块；KC×NR 的 B 条留在 L1，MC×KC 的 A 块留在 L2
+constexpr std::size_t MR = 4;
+constexpr std::size_t NR = 8;
+constexpr std::size_t KC = 256;
+constexpr std::size_t MC = 128;
+constexpr std::size_t NC = 2048;
+
+// 乘加次数低于此值时不开线程
+constexpr double PARALLEL_THRESHOLD = 1 << 21;
+
+// A 的 mc×kc 块按 MR 行一条打包，条内逐列存放，不足 MR 行的部分补 0
+void pack_a(const double* a, std::size_t lda, std::size_t mc, std::size_t kc, double* out) {
+    for (std::size_t i = 0; i < mc; i += MR) {
+        const std::size_t rows = std::min(MR, mc - i);
+        for (std::size_t p = 0; p < kc; p++) {
+            for (std::size_t r = 0; r < MR; r++) *out++ = r < rows ? a[(i + r) * lda + p] : 0.0;
+        }
+    }
+}
+
+// B 的 kc×nc 块按 NR 列一条打包，条内逐行存放，不足 NR 列的部分补 0
+void pack_b(const double* b, std::size_t ldb, std::size_t kc, std::size_t nc, double* out) {
+    for (std::size_t j = 0; j < nc; j += NR) {
+        const std::size_t cols = std::min(NR, nc - j);
+        for (std::size_t p = 0; p < kc; p++) {
+            const double* row = b + p * ldb + j;
+            for (std::size_t s = 0; s < NR; s++) *out++ = s < cols ? row[s] : 0.0;
+        }
+    }
+}
+
+// C 左上 rows×cols 的部分 += A 条 · B 条；累加器固定为 MR×NR，编译器会把它放进向量寄存器
+inline void kernel_body(std::size_t kc, const double* a, const double* b,
+                        double* c, std::size_t ldc, std::size_t rows, std::size_t cols) {
+    double acc[MR][NR] = {};
+    for (std::size_t p = 0; p < kc; p++) {
+        for (std::size_t i = 0; i < MR; i++) {
+            const double ai = a[p * MR + i];
+            for (std::size_t j = 0; j < NR; j++) acc[i][j] += ai * b[p * NR + j];
+        }
+    }
+    for (std::size_t i = 0; i < rows; i++) {
+        for (std::size_t j = 0; j < cols; j++) c[i * ldc + j] += acc[i][j];
+    }
+}
+
+using Kernel = void (*)(std::size_t, const double*, const double*, double*, std::size_t, std::size_t, std::size_t);
+
+void kernel_generic(std::size_t kc, const double* a, const double* b,
+                    double* c, std::size_t ldc, std::size_t rows, std::size_t cols) {
+    kernel_body(kc, a, b, c, ldc, rows, cols);
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && !defined(_WIN32)
+#define LAMINA_GEMM_AVX2
+__attribute__((target("avx2,fma"), flatten)) void kernel_avx2(std::size_t kc, const double* a, const double* b,
+                                                              double* c, std::size_t ldc, std::size_t rows, std::size_t cols) {
+    kernel_body(kc, a, b, c, ldc, rows, cols);
+}
+#endif
+
+Kernel select_kernel() {
+#ifdef LAMINA_GEMM_AVX2
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return kernel_avx2;
+#endif
+    return kernel_generic;
+}
+
+// 计算 C 的第 [r0, r1) 行
+void gemm_rows(std::size_t r0, std::size_t r1, std::size_t n, std::size_t k,
+               const double* a, const double* b, double* c, Kernel kernel) {
+    std::vector<double> pa(MC * KC);
+    std::vector<double> pb(KC * ((std::min(NC, n) + NR - 1) / NR * NR));
+    for (std::size_t jc = 0; jc < n; jc += NC) {
+        const std::size_t nc = std::min(NC, n - jc);
+        for (std::size_t pc = 0; pc < k; pc += KC) {
+            const std::size_t kc = std::min(KC, k - pc);
+            pack_b(b + pc * n + jc, n, kc, nc, pb.data());
+            for (std::size_t ic = r0; ic < r1; ic += MC) {
+                const std::size_t mc = std::min(MC, r1 - ic);
+                pack_a(a + ic * k + pc, k, mc, kc, pa.data());
+                for (std::size_t jr = 0; jr < nc; jr += NR) {
+                    for (std::size_t ir = 0; ir < mc; ir += MR) {
+                        kernel(kc, pa.data() + ir * kc, pb.data() + jr * kc,
+                               c + (ic + ir) * n + jc + jr, n,
+                               std::min(MR, mc - ir), std::min(NR, nc - jr));
+                    }
+                }
+            }
+        }
+    }
+}
+
+}// namespace
+
+void gemm(std::size_t m, std::size_t n, std::size_t k, const double* a, const double* b, double* c) {
+    std::fill(c, c + m * n, 0.0);
+    if (m == 0 || n == 0 || k == 0) return;
+    static const Kernel kernel = select_kernel();
+
+    // 每个线程至少分到 MC 行；各线程写 C 的不同行，互不干扰
+    std::size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min(workers, (m + MC - 1) / MC);
+    if (static_cast<double>(m) * n * k < PARALLEL_THRESHOLD) workers = 1;
+    if (workers <= 1) {
+        gemm_rows(0, m, n, k, a, b, c, kernel);
+        return;
+    }
+    const std::size_t chunk = (m + workers - 1) / workers;
+    std::vector<std::thread> threads;
+    for (std::size_t r0 = 0; r0 < m; r0 += chunk) {
+        threads.emplace_back(gemm_rows, r0, std::min(m, r0 + chunk), n, k, a, b, c, kernel);
+    }
+    for (auto& t : threads) t.join();
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+
+#ifndef LAMINA_API
+#ifdef _WIN32
+#ifdef LAMINA_CORE_EXPORTS
+#define LAMINA_API __declspec(dllexport)
+#else
+#define LAMINA_API __declspec(dllimport)
+#endif
+#else
+#define LAMINA_API
+#endif
+#endif
+
+// 稠密 double 矩阵乘法 C = A · B，三者均按行优先连续存放
+// A 为 m×k，B 为 k×n，C 为 m×n，C 的原有内容被覆盖
+//
+// 按缓存分块：B 的 KC×NC 块、A 的 MC×KC 块先打包成微内核顺序读取的窄条，
+// 微内核在寄存器里累加 MR×NR 的小块，内层循环可以向量化；
+// x86-64 上 CPU 支持 AVX2 + FMA 时改用对应指令编译的微内核
+// 矩阵较大时按行分成若干段，由多个线程分别计算
+LAMINA_API void gemm(std::size_t m, std::size_t n, std::size_t k,
+                     const double* a, const double* b, double* c);
@@ -1,12 +1,16 @@
 #pragma once
 #define _USE_MATH_DEFINES
+#include "squarefree.hpp"
 #include "symbolic.hpp"
+#include <algorithm>
+#include <climits>
 #include <cmath>
 #include <iomanip>
 #include <iostream>
-#include <map>
 #include <memory>
+#include <numeric>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -19,256 +23,291 @@
 #endif
 
 // 无理数类，支持常见无理数的精确表示
+// 值为若干项之和：有理数 × {1, √n, π, e}，n 无平方因子
+// 系数均为精确的有理数，项按 (基, n) 排序存放在一个小数组中
+// 加减法总能在此表示内完成；乘除法离开该表示时（如 π·π）由调用方改用 SymbolicExpr，这里不做近似
 class Irrational {
 public:
-    // 转为符号表达式
-
-    std::shared_ptr<SymbolicExpr> to_symbolic() const {
-        switch (type) {
-            case Type::SQRT: {
-                // 只要系数不为0，始终输出表达式
-                auto sqrtExpr = SymbolicExpr::sqrt(SymbolicExpr::number(static_cast<int>(radicand)));
-                if (std::abs(coefficient) < 1e-15) {
-                    return SymbolicExpr::number(0);
-                } else if (std::abs(coefficient - 1.0) < 1e-15) {
-                    return sqrtExpr;
-                } else {
-                    return SymbolicExpr::multiply(SymbolicExpr::number(::Rational(coefficient)), sqrtExpr);
-                }
-            }
-            case Type::PI:
-                // π 的所有情况都返回符号表达式
-                if (std::abs(coefficient) < 1e-15) {
-                    return SymbolicExpr::variable("π");
-                } else if (std::abs(coefficient - 1.0) < 1e-15) {
-                    return SymbolicExpr::variable("π");
-                } else {
-                    return SymbolicExpr::multiply(SymbolicExpr::number(::Rational(coefficient)), SymbolicExpr::variable("π"));
-                }
-            case Type::E:
-                if (std::abs(coefficient) < 1e-15) {
-                    return SymbolicExpr::number(0);
-                } else if (std::abs(coefficient - 1.0) < 1e-15) {
-                    return SymbolicExpr::variable("e");
-                } else {
-                    return SymbolicExpr::multiply(SymbolicExpr::number(::Rational(coefficient)), SymbolicExpr::variable("e"));
-                }
-            case Type::LOG:
-                // log(n) 仅支持变量形式
-                if (std::abs(coefficient) < 1e-15) {
-                    return SymbolicExpr::number(0);
-                } else {
-                    return SymbolicExpr::multiply(SymbolicExpr::number(::Rational(coefficient)), SymbolicExpr::variable("log(" + std::to_string(radicand) + ")"));
-                }
-            case Type::COMPLEX:
-                // 复杂形式暂不支持符号化，返回常数
-                return SymbolicExpr::number(::Rational(constant_term));
-            default:
-                return SymbolicExpr::number(0);
-        }
-    }
     enum class Type {
         SQRT,  // √n 形式
         PI,    // π 的倍数
         E,     // e 的倍数
-        LOG,   // log(n) 形式
-        COMPLEX// 复合形式 (a*√b + c*π + d*e + ...)（暂时不适用，用 SymbolicExpr 代替）
+        LOG,   // log(n) 形式（保留，当前不会产生）
+        COMPLEX// 复合形式 (a + b*√n + c*π + d*e + ...)
     };
 
-private:
-    Type type;
+    // 项的基
+    enum class Basis : unsigned char {
+        One,
+        Sqrt,
+        Pi,
+        E
+    };
 
-    // 对于 √n 形式：coefficient * √radicand
-    double coefficient;// 系数
-    long long radicand;// 根号内的数
+    struct Term {
+        Basis basis;
+        long long radicand;// 仅 Sqrt 使用，其余为 1
+        ::Rational coeff;
+    };
 
-    // 对于复合形式：系数映射
-    std::map<std::string, double> coefficients;
-    double constant_term;// 常数项
+private:
+    std::vector<Term> terms;
 
-    // 简化根号
+    // 简化根号：返回 {平方部分的根, 无平方因子部分}
     static std::pair<long long, long long> simplify_sqrt(long long n) {
-        long long perfect_square = 1;
-        long long remainder = n;
+        auto [outside, inside] = square_free_decompose(static_cast<std::uint64_t>(n));
+        return {static_cast<long long>(outside), static_cast<long long>(inside)};
+    }
 
-        for (long long i = 2; i * i <= n; ++i) {
-            while (remainder % (i * i) == 0) {
-                perfect_square *= i;
-                remainder /= (i * i);
-            }
+    static ::Rational rational_of(double value) {
+        return ::Rational::from_double(value);
+    }
+
+    static std::shared_ptr<SymbolicExpr> integer_expr(long long n) {
+        if (n >= INT_MIN && n <= INT_MAX) return SymbolicExpr::number(static_cast<int>(n));
+        return SymbolicExpr::number(::BigInt(std::to_string(n)));
+    }
+
+    static double basis_value(const Term& t) {
+        switch (t.basis) {
+            case Basis::One: return 1.0;
+            case Basis::Sqrt: return std::sqrt(static_cast<double>(t.radicand));
+            case Basis::Pi: return M_PI;
+            case Basis::E: return M_E;
         }
-        return {perfect_square, remainder};
+        return 0.0;
+    }
+
+    // 合并一项，保持有序并去掉系数为 0 的项
+    void add_term(Basis basis, long long radicand, const ::Rational& coeff) {
+        if (coeff.is_zero()) return;
+        auto it = std::lower_bound(terms.begin(), terms.end(), std::make_pair(basis, radicand),
+            [](const Term& t, const std::pair<Basis, long long>& key) {
+                return t.basis < key.first || (t.basis == key.first && t.radicand < key.second);
+            });
+        if (it != terms.end() && it->basis == basis && it->radicand == radicand) {
+            it->coeff = it->coeff + coeff;
+            if (it->coeff.is_zero()) terms.erase(it);
+            return;
+        }
+        terms.insert(it, Term{basis, radicand, coeff});
+    }
+
+    // 两项相乘，结果不在表示内时返回 false
+    static bool multiply_term(const Term& a, const Term& b, Irrational& out) {
+        if (a.basis == Basis::One) {
+            out.add_term(b.basis, b.radicand, a.coeff * b.coeff);
+            return true;
+        }
+        if (b.basis == Basis::One) {
+            out.add_term(a.basis, a.radicand, a.coeff * b.coeff);
+            return true;
+        }
+        if (a.basis == Basis::Sqrt && b.basis == Basis::Sqrt) {
+            // √a·√b = g·√((a/g)(b/g))，a、b 无平方因子时结果同样无平方因子
+            // 根号下的数都是正数，先用除法判断乘积会不会溢出
+            long long g = std::gcd(a.radicand, b.radicand);
+            if (a.radicand / g > LLONG_MAX / (b.radicand / g)) return false;
+            long long r = (a.radicand / g) * (b.radicand / g);
+            ::Rational c = a.coeff * b.coeff * ::Rational(::BigInt(std::to_string(g)));
+            if (r == 1) out.add_term(Basis::One, 1, c);
+            else out.add_term(Basis::Sqrt, r, c);
+            return true;
+        }
+        return false;
     }
 
 public:
+    // 转为符号表达式
+    std::shared_ptr<SymbolicExpr> to_symbolic() const {
+        std::vector<std::shared_ptr<SymbolicExpr>> parts;
+        parts.reserve(terms.size());
+        for (const auto& t : terms) {
+            std::shared_ptr<SymbolicExpr> base;
+            switch (t.basis) {
+                case Basis::One:
+                    parts.push_back(SymbolicExpr::number(t.coeff));
+                    continue;
+                case Basis::Sqrt: base = SymbolicExpr::sqrt(integer_expr(t.radicand)); break;
+                case Basis::Pi: base = SymbolicExpr::variable("π"); break;
+                case Basis::E: base = SymbolicExpr::variable("e"); break;
+            }
+            if (t.coeff == ::Rational(1)) parts.push_back(base);
+            else parts.push_back(SymbolicExpr::multiply(SymbolicExpr::number(t.coeff), base));
+        }
+        return SymbolicExpr::add(parts);
+    }
+
     // 构造函数
-    Irrational() : type(Type::COMPLEX), coefficient(0), radicand(1), constant_term(0) {}
+    Irrational() = default;
 
     // 创建 √n 形式的无理数
-    static Irrational sqrt(long long n, double coeff = 1.0) {
+    static Irrational sqrt(long long n, const ::Rational& coeff) {
+        if (n < 0) throw std::runtime_error("Square root of negative number");
         Irrational result;
-        result.type = Type::SQRT;
-
         auto [perfect, remainder] = simplify_sqrt(n);
-        result.coefficient = coeff * perfect;
-        result.radicand = remainder;
-        result.constant_term = 0;
-
+        ::Rational c = coeff * ::Rational(::BigInt(std::to_string(perfect)));
+        if (remainder == 1 || n == 0) result.add_term(Basis::One, 1, n == 0 ? ::Rational(0) : c);
+        else result.add_term(Basis::Sqrt, remainder, c);
         return result;
     }
+    static Irrational sqrt(long long n, double coeff = 1.0) {
+        return sqrt(n, rational_of(coeff));
+    }
 
     // 创建 π 的倍数
-    static Irrational pi(double coeff = 1.0) {
+    static Irrational pi(const ::Rational& coeff) {
         Irrational result;
-        result.type = Type::PI;
-        result.coefficient = coeff;
-        result.radicand = 1;
-        result.constant_term = 0;
+        result.add_term(Basis::Pi, 1, coeff);
         return result;
     }
+    static Irrational pi(double coeff = 1.0) {
+        return pi(rational_of(coeff));
+    }
 
     // 创建 e 的倍数
-    static Irrational e(double coeff = 1.0) {
+    static Irrational e(const ::Rational& coeff) {
         Irrational result;
-        result.type = Type::E;
-        result.coefficient = coeff;
-        result.radicand = 1;
-        result.constant_term = 0;
+        result.add_term(Basis::E, 1, coeff);
         return result;
     }
+    static Irrational e(double coeff = 1.0) {
+        return e(rational_of(coeff));
+    }
 
     // 创建常数（可以退化为有理数）
-    static Irrational constant(double value) {
+    static Irrational constant(const ::Rational& value) {
         Irrational result;
-        result.type = Type::COMPLEX;
-        result.coefficient = 0;
-        result.radicand = 1;
-        result.constant_term = value;
+        result.add_term(Basis::One, 1, value);
         return result;
     }
-
-    // 转换为复合形式
-    void to_complex() {
-        if (type == Type::COMPLEX) return;
-
-        coefficients.clear();
-        constant_term = 0;
-
-        switch (type) {
-            case Type::SQRT:
-                if (radicand == 1) {
-                    constant_term = coefficient;
-                } else {
-                    coefficients["sqrt" + std::to_string(radicand)] = coefficient;
-                }
-                break;
-            case Type::PI:
-                coefficients["pi"] = coefficient;
-                break;
-            case Type::E:
-                coefficients["e"] = coefficient;
-                break;
-            default:
-                break;
-        }
-        type = Type::COMPLEX;
+    static Irrational constant(double value) {
+        return constant(rational_of(value));
     }
 
+    const std::vector<Term>& get_terms() const { return terms; }
+
     // 加法
     Irrational operator+(const Irrational& other) const {
         Irrational result = *this;
-        Irrational other_copy = other;
-
-        result.to_complex();
-        other_copy.to_complex();
-
-        result.constant_term += other_copy.constant_term;
-
-        for (const auto& [key, coeff]: other_copy.coefficients) {
-            result.coefficients[key] += coeff;
-        }
-
+        for (const auto& t : other.terms) result.add_term(t.basis, t.radicand, t.coeff);
         return result;
     }
 
     // 减法
     Irrational operator-(const Irrational& other) const {
         Irrational result = *this;
-        Irrational other_copy = other;
-
-        result.to_complex();
-        other_copy.to_complex();
-
-        result.constant_term -= other_copy.constant_term;
-
-        for (const auto& [key, coeff]: other_copy.coefficients) {
-            result.coefficients[key] -= coeff;
-        }
+        for (const auto& t : other.terms) result.add_term(t.basis, t.radicand, -t.coeff);
+        return result;
+    }
 
+    // 有理数乘法
+    Irrational operator*(const ::Rational& scalar) const {
+        if (scalar.is_zero()) return Irrational();
+        Irrational result = *this;
+        for (auto& t : result.terms) t.coeff = t.coeff * scalar;
         return result;
     }
 
     // 标量乘法
     Irrational operator*(double scalar) const {
-        Irrational result = *this;
+        return *this * rational_of(scalar);
+    }
 
-        if (type == Type::COMPLEX) {
-            result.constant_term *= scalar;
-            for (auto& [key, coeff]: result.coefficients) {
-                coeff *= scalar;
+    // 精确乘法，结果不在表示内（含 π、e 的非有理数乘积，或根号下溢出）时返回 false
+    bool try_multiply(const Irrational& other, Irrational& out) const {
+        Irrational result;
+        for (const auto& a : terms) {
+            for (const auto& b : other.terms) {
+                if (!multiply_term(a, b, result)) return false;
             }
-        } else {
-            result.coefficient *= scalar;
         }
-
-        return result;
+        out = std::move(result);
+        return true;
     }
 
-    // 乘法（简化版本，主要处理常见情况）
-    Irrational operator*(const Irrational& other) const {
-        // 如果其中一个是常数
-        if (type == Type::COMPLEX && coefficients.empty()) {
-            return other * constant_term;
+    // 精确除法：除数为有理数、单个根式或 a + b√n 时可行
+    bool try_divide(const Irrational& other, Irrational& out) const {
+        if (other.is_zero()) throw std::runtime_error("Irrational: division by zero");
+        if (other.terms.size() == 1) {
+            const auto& d = other.terms[0];
+            if (d.basis == Basis::One) {
+                out = *this * d.coeff.reciprocal();
+                return true;
+            }
+            if (d.basis == Basis::Sqrt) {
+                // x / (c√n) = x·√n / (c·n)
+                ::Rational scale = (d.coeff * ::Rational(::BigInt(std::to_string(d.radicand)))).reciprocal();
+                return try_multiply(Irrational::sqrt(d.radicand, scale), out);
+            }
+            return false;
         }
-        if (other.type == Type::COMPLEX && other.coefficients.empty()) {
-            return *this * other.constant_term;
+        if (other.terms.size() == 2 && other.terms[0].basis == Basis::One && other.terms[1].basis == Basis::Sqrt) {
+            // 分母有理化：(a + b√n)(a - b√n) = a² - b²n
+            const auto& a = other.terms[0].coeff;
+            const auto& b = other.terms[1].coeff;
+            long long n = other.terms[1].radicand;
+            ::Rational norm = a * a - b * b * ::Rational(::BigInt(std::to_string(n)));
+            Irrational conj = constant(a) - Irrational::sqrt(n, b);
+            Irrational numer;
+            if (!try_multiply(conj, numer)) return false;
+            out = numer * norm.reciprocal();
+            return true;
         }
+        return false;
+    }
 
-        // √a * √b = √(ab)
-        if (type == Type::SQRT && other.type == Type::SQRT) {
-            return Irrational::sqrt(radicand * other.radicand,
-                                    coefficient * other.coefficient);
+    // 精确整数幂
+    bool try_pow(long long exponent, Irrational& out) const {
+        if (exponent < 0) {
+            Irrational positive;
+            if (!try_pow(-exponent, positive)) return false;
+            return constant(::Rational(1)).try_divide(positive, out);
+        }
+        Irrational result = constant(::Rational(1)), base = *this;
+        while (exponent) {
+            if (exponent & 1) {
+                if (!result.try_multiply(base, result)) return false;
+            }
+            exponent >>= 1;
+            if (exponent && !base.try_multiply(base, base)) return false;
         }
+        out = std::move(result);
+        return true;
+    }
 
-        // 其他情况转为近似值处理
-        return Irrational::constant(to_double() * other.to_double());
+    // 乘法；离开表示时抛出 std::domain_error，不退化为近似值
+    // 解释器先调用 try_multiply，失败时改用 SymbolicExpr
+    Irrational operator*(const Irrational& other) const {
+        Irrational result;
+        if (try_multiply(other, result)) return result;
+        throw std::domain_error("Irrational: product of " + to_string() + " and " + other.to_string() + " is not representable");
     }
 
-    // 除法（简化版本）
+    // 除法；离开表示时抛出 std::domain_error
     Irrational operator/(const Irrational& other) const {
-        // 如果除数是常数
-        if (other.type == Type::COMPLEX && other.coefficients.empty() && other.constant_term != 0) {
-            return *this * (1.0 / other.constant_term);
-        }
-
-        // 其他情况转为近似值处理
-        double other_val = other.to_double();
-        if (std::abs(other_val) < 1e-15) {
-            throw std::runtime_error("Irrational: division by zero");
-        }
-        return Irrational::constant(to_double() / other_val);
+        Irrational result;
+        if (try_divide(other, result)) return result;
+        throw std::domain_error("Irrational: quotient of " + to_string() + " and " + other.to_string() + " is not representable");
     }
 
     // 负号
     Irrational operator-() const {
-        return *this * (-1.0);
+        return *this * ::Rational(-1);
     }
 
-    // 比较运算（基于近似值）
+    // 相等比较是精确的（表示唯一）
     bool operator==(const Irrational& other) const {
-        return std::abs(to_double() - other.to_double()) < 1e-12;
+        if (terms.size() != other.terms.size()) return false;
+        for (size_t i = 0; i < terms.size(); i++) {
+            const auto& a = terms[i];
+            const auto& b = other.terms[i];
+            if (a.basis != b.basis || a.radicand != b.radicand || a.coeff != b.coeff) return false;
+        }
+        return true;
     }
 
+    // 大小比较（基于近似值）
     bool operator<(const Irrational& other) const {
         return to_double() < other.to_double();
     }
@@ -287,231 +326,46 @@ public:
 
     // 转换为 double（近似值）
     double to_double() const {
-        switch (type) {
-            case Type::SQRT:
-                if (radicand == 1) {
-                    return coefficient;
-                }
-                return coefficient * std::sqrt(radicand);
-            case Type::PI:
-                return coefficient * M_PI;
-            case Type::E:
-                return coefficient * M_E;
-            case Type::LOG:
-                return coefficient * std::log(radicand);
-            case Type::COMPLEX: {
-                double result = constant_term;
-                for (const auto& [key, coeff]: coefficients) {
-                    if (key == "pi") {
-                        result += coeff * M_PI;
-                    } else if (key == "e") {
-                        result += coeff * M_E;
-                    } else if (key.substr(0, 4) == "sqrt") {
-                        long long n = std::stoll(key.substr(4));
-                        result += coeff * std::sqrt(n);
-                    }
-                }
-                return result;
-            }
-            default:
-                return 0.0;
-        }
+        double result = 0.0;
+        for (const auto& t : terms) result += t.coeff.to_double() * basis_value(t);
+        return result;
     }
 
-    // 转换为字符串（精确表示）
+    // 转换为字符串（精确表示，与符号表达式的输出一致）
     std::string to_string() const {
-        switch (type) {
-            case Type::SQRT:
-                if (radicand == 1) {
-                    // 处理整数系数的格式化
-                    if (coefficient == static_cast<int>(coefficient)) {
-                        return std::to_string(static_cast<int>(coefficient));
-                    }
-                    return std::to_string(coefficient);
-                }
-                if (coefficient == 1.0) {
-                    return "√" + std::to_string(radicand);
-                }
-                if (coefficient == -1.0) {
-                    return "-√" + std::to_string(radicand);
-                }
-                // 处理系数格式化
-                if (std::abs(coefficient - std::round(coefficient)) < 1e-15) {
-                    return std::to_string(static_cast<int>(std::round(coefficient))) + "√" + std::to_string(radicand);
-                } else {
-                    // 格式化小数，去掉末尾的0
-                    std::ostringstream oss;
-                    oss << std::fixed << std::setprecision(6) << coefficient;
-                    std::string temp = oss.str();
-                    temp.erase(temp.find_last_not_of('0') + 1);
-                    if (temp.back() == '.') temp.pop_back();
-                    return temp + "√" + std::to_string(radicand);
-                }
-
-            case Type::PI:
-                if (coefficient == 1.0) {
-                    return "π";
-                }
-                if (coefficient == -1.0) {
-                    return "-π";
-                }
-                // 处理系数格式化
-                if (std::abs(coefficient - std::round(coefficient)) < 1e-15) {
-                    return std::to_string(static_cast<int>(std::round(coefficient))) + "π";
-                } else {
-                    // 格式化小数，去掉末尾的0
-                    std::ostringstream oss;
-                    oss << std::fixed << std::setprecision(6) << coefficient;
-                    std::string temp = oss.str();
-                    temp.erase(temp.find_last_not_of('0') + 1);
-                    if (temp.back() == '.') temp.pop_back();
-                    return temp + "π";
-                }
-
-            case Type::E:
-                if (coefficient == 1.0) {
-                    return "e";
-                }
-                if (coefficient == -1.0) {
-                    return "-e";
-                }
-                // 处理系数格式化
-                if (std::abs(coefficient - std::round(coefficient)) < 1e-15) {
-                    return std::to_string(static_cast<int>(std::round(coefficient))) + "e";
-                } else {
-                    // 格式化小数，去掉末尾的0
-                    std::ostringstream oss;
-                    oss << std::fixed << std::setprecision(6) << coefficient;
-                    std::string temp = oss.str();
-                    temp.erase(temp.find_last_not_of('0') + 1);
-                    if (temp.back() == '.') temp.pop_back();
-                    return temp + "e";
-                }
-
-            case Type::LOG:
-                if (coefficient == 1.0) {
-                    return "log(" + std::to_string(radicand) + ")";
-                }
-                if (coefficient == -1.0) {
-                    return "-log(" + std::to_string(radicand) + ")";
-                }
-                // 处理系数格式化
-                if (std::abs(coefficient - std::round(coefficient)) < 1e-15) {
-                    return std::to_string(static_cast<int>(std::round(coefficient))) + "log(" + std::to_string(radicand) + ")";
-                } else {
-                    // 格式化小数，去掉末尾的0
-                    std::ostringstream oss;
-                    oss << std::fixed << std::setprecision(6) << coefficient;
-                    std::string temp = oss.str();
-                    temp.erase(temp.find_last_not_of('0') + 1);
-                    if (temp.back() == '.') temp.pop_back();
-                    return temp + "log(" + std::to_string(radicand) + ")";
-                }
-
-            case Type::COMPLEX: {
-                std::string result;
-                bool first = true;
-
-                // 常数项
-                if (std::abs(constant_term) > 1e-15) {
-                    if (std::abs(constant_term - std::round(constant_term)) < 1e-15) {
-                        // 是整数或非常接近整数
-                        result += std::to_string(static_cast<int>(std::round(constant_term)));
-                    } else {
-                        // 是真正的小数，格式化为最多6位小数但去掉末尾的0
-                        std::ostringstream oss;
-                        oss << std::fixed << std::setprecision(6) << constant_term;
-                        std::string temp = oss.str();
-                        // 去掉末尾的0和小数点
-                        temp.erase(temp.find_last_not_of('0') + 1);
-                        if (temp.back() == '.') temp.pop_back();
-                        result += temp;
-                    }
-                    first = false;
-                }
-
-                // 其他项
-                for (const auto& [key, coeff]: coefficients) {
-                    if (std::abs(coeff) < 1e-15) continue;
-
-                    if (!first && coeff > 0) result += " + ";
-                    else if (!first && coeff < 0)
-                        result += " - ";
-
-                    double abs_coeff = std::abs(coeff);
-                    std::string term;
-
-                    if (key == "pi") {
-                        if (abs_coeff == 1.0) {
-                            term = "π";
-                        } else if (abs_coeff == static_cast<int>(abs_coeff)) {
-                            term = std::to_string(static_cast<int>(abs_coeff)) + "π";
-                        } else {
-                            term = std::to_string(abs_coeff) + "π";
-                        }
-                    } else if (key == "e") {
-                        if (abs_coeff == 1.0) {
-                            term = "e";
-                        } else if (abs_coeff == static_cast<int>(abs_coeff)) {
-                            term = std::to_string(static_cast<int>(abs_coeff)) + "e";
-                        } else {
-                            term = std::to_string(abs_coeff) + "e";
-                        }
-                    } else if (key.substr(0, 4) == "sqrt") {
-                        long long n = std::stoll(key.substr(4));
-                        if (abs_coeff == 1.0) {
-                            term = "√" + std::to_string(n);
-                        } else if (abs_coeff == static_cast<int>(abs_coeff)) {
-                            term = std::to_string(static_cast<int>(abs_coeff)) + "√" + std::to_string(n);
-                        } else {
-                            term = std::to_string(abs_coeff) + "√" + std::to_string(n);
-                        }
-                    }
-
-                    if (first && coeff < 0) result += "-";
-                    result += term;
-                    first = false;
-                }
-
-                return result.empty() ? "0" : result;
-            }
-            default:
-                return "0";
+        std::string result;
+        write_to(result);
+        return result;
+    }
+
+    // 追加到 out 末尾
+    void write_to(std::string& out) const {
+        if (terms.empty()) {
+            out += '0';
+            return;
         }
+        to_symbolic()->simplify()->write_to(out);
     }
 
     // 判断是否为零
     bool is_zero() const {
-        return std::abs(to_double()) < 1e-15;
+        return terms.empty();
     }
 
     // 判断是否为有理数（即可以精确表示为分数）
     bool is_rational() const {
-        if (type == Type::COMPLEX) {
-            return coefficients.empty();
-        }
-        return false;
+        return terms.empty() || (terms.size() == 1 && terms[0].basis == Basis::One);
     }
 
-    // 简化表示（去除系数为0的项）
-    void simplify() {
-        if (type == Type::COMPLEX) {
-            auto it = coefficients.begin();
-            while (it != coefficients.end()) {
-                if (std::abs(it->second) < 1e-15) {
-                    it = coefficients.erase(it);
-                } else {
-                    ++it;
-                }
-            }
-
-            // 如果所有无理数项都被删除，只保留常数项
-            if (coefficients.empty() && std::abs(constant_term) < 1e-15) {
-                constant_term = 0.0;
-            }
-        }
+    // 有理数部分（is_rational() 为真时即为其值）
+    ::Rational rational_part() const {
+        if (!terms.empty() && terms[0].basis == Basis::One) return terms[0].coeff;
+        return ::Rational(0);
     }
 
+    // 简化表示（项在运算中已保持最简，保留此接口）
+    void simplify() {}
+
     // 判断是否为正数
     bool is_positive() const {
         return to_double() > 1e-15;
@@ -530,21 +384,11 @@ public:
         return *this;
     }
 
-    // 幂运算（仅支持整数幂）
+    // 幂运算（仅支持整数幂）；离开表示时抛出 std::domain_error
     Irrational pow(int exponent) const {
-        if (exponent == 0) {
-            return Irrational::constant(1.0);
-        }
-        if (exponent == 1) {
-            return *this;
-        }
-        if (exponent == 2 && type == Type::SQRT) {
-            // (a√b)² = a²b
-            return Irrational::constant(coefficient * coefficient * radicand);
-        }
-
-        // 其他情况使用近似值
-        return Irrational::constant(std::pow(to_double(), exponent));
+        Irrational result;
+        if (try_pow(exponent, result)) return result;
+        throw std::domain_error("Irrational: " + to_string() + " ^ " + std::to_string(exponent) + " is not representable");
     }
 
     // 输出流重载
@@ -554,5 +398,15 @@ public:
     }
 
     // 获取类型
-    Type get_type() const { return type; }
+    Type get_type() const {
+        if (terms.size() == 1) {
+            switch (terms[0].basis) {
+                case Basis::Sqrt: return Type::SQRT;
+                case Basis::Pi: return Type::PI;
+                case Basis::E: return Type::E;
+                default: break;
+            }
+        }
+        return Type::COMPLEX;
+    }
 };
@@ -0,0 +1,307 @@
+#include "linsolve.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+
+using u64 = std::uint64_t;
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 Wide;
+constexpr u64 PRIME_START = (u64(1) << 62) - 1;
+#else
+using Wide = std::uint64_t;
+constexpr u64 PRIME_START = (u64(1) << 31) - 1;
+#endif
+
+u64 mul_mod(u64 a, u64 b, u64 m) {
+    return static_cast<u64>(static_cast<Wide>(a) * b % m);
+}
+
+u64 sub_mod(u64 a, u64 b, u64 m) {
+    return a >= b ? a - b : a + (m - b);
+}
+
+u64 pow_mod(u64 a, u64 e, u64 m) {
+    u64 result = 1;
+    a %= m;
+    while (e) {
+        if (e & 1) result = mul_mod(result, a, m);
+        a = mul_mod(a, a, m);
+        e >>= 1;
+    }
+    return result;
+}
+
+// m 为素数
+u64 inv_mod(u64 a, u64 m) {
+    return pow_mod(a, m - 2, m);
+}
+
+// 64 位以内确定性的 Miller-Rabin
+bool is_prime(u64 n) {
+    if (n < 2) return false;
+    static const u64 bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    for (u64 p : bases) {
+        if (n % p == 0) return n == p;
+    }
+    u64 d = n - 1;
+    int s = 0;
+    while ((d & 1) == 0) {
+        d >>= 1;
+        s++;
+    }
+    for (u64 a : bases) {
+        u64 x = pow_mod(a, d, n);
+        if (x == 1 || x == n - 1) continue;
+        bool composite = true;
+        for (int i = 1; i < s && composite; i++) {
+            x = mul_mod(x, x, n);
+            if (x == n - 1) composite = false;
+        }
+        if (composite) return false;
+    }
+    return true;
+}
+
+// 从 PRIME_START 往下的第 i 个素数，按需生成
+u64 nth_prime(size_t i) {
+    static std::mutex mutex;
+    static std::vector<u64> primes;
+    std::lock_guard<std::mutex> lock(mutex);
+    while (primes.size() <= i) {
+        u64 c = primes.empty() ? PRIME_START : primes.back() - 2;
+        while (!is_prime(c)) c -= 2;
+        primes.push_back(c);
+    }
+    return primes[i];
+}
+
+// 十进制整数（可带负号）对 m 取余，每次处理 9 位
+u64 reduce(const std::string& digits, u64 m) {
+    const bool negative = !digits.empty() && digits[0] == '-';
+    u64 r = 0;
+    size_t i = negative ? 1 : 0;
+    while (i < digits.size()) {
+        size_t len = std::min<size_t>(9, digits.size() - i);
+        u64 chunk = 0, scale = 1;
+        for (size_t k = 0; k < len; k++) {
+            chunk = chunk * 10 + (digits[i + k] - '0');
+            scale *= 10;
+        }
+        r = (mul_mod(r, scale % m, m) + chunk % m) % m;
+        i += len;
+    }
+    return negative ? sub_mod(0, r, m) : r;
+}
+
+// 模 p 下的整数增广矩阵 [A | B]
+struct ModSystem {
+    size_t n;
+    size_t m;// 右端项的列数
+    std::vector<std::vector<std::string>> rows;// 十进制表示，n 行 n + m 列
+};
+
+// 在模 p 下求 det(A) 以及 Y = det(A) · X，按 det、Y 的行优先顺序写入 out；A 模 p 奇异时返回 false
+bool solve_mod(const ModSystem& sys, u64 p, std::vector<u64>& out) {
+    const size_t n = sys.n;
+    const size_t m = sys.m;
+    const size_t w = n + m;
+    std::vector<u64> a(n * w);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < w; j++) a[i * w + j] = reduce(sys.rows[i][j], p);
+    }
+
+    u64 det = 1;
+    std::vector<size_t> nonzero;// 主元行中非零列，稀疏时只更新这些列
+    for (size_t k = 0; k < n; k++) {
+        size_t r = k;
+        while (r < n && a[r * w + k] == 0) r++;
+        if (r == n) return false;
+        if (r != k) {
+            std::swap_ranges(a.begin() + r * w, a.begin() + (r + 1) * w, a.begin() + k * w);
+            det = sub_mod(0, det, p);
+        }
+        u64* pivot = &a[k * w];
+        det = mul_mod(det, pivot[k], p);
+
+        // 主元行归一化
+        const u64 inv = inv_mod(pivot[k], p);
+        nonzero.clear();
+        for (size_t j = k + 1; j < w; j++) {
+            if (pivot[j] == 0) continue;
+            pivot[j] = mul_mod(pivot[j], inv, p);
+            nonzero.push_back(j);
+        }
+        pivot[k] = 1;
+
+        for (size_t i = k + 1; i < n; i++) {
+            u64* row = &a[i * w];
+            const u64 f = row[k];
+            if (f == 0) continue;
+            for (size_t j : nonzero) row[j] = sub_mod(row[j], mul_mod(f, pivot[j], p), p);
+            row[k] = 0;
+        }
+    }
+
+    // 对每个右端项回代
+    std::vector<u64> x(n);
+    out.resize(n * m + 1);
+    out[0] = det;
+    for (size_t c = 0; c < m; c++) {
+        for (size_t i = n; i-- > 0;) {
+            const u64* row = &a[i * w];
+            u64 s = row[n + c];
+            for (size_t j = i + 1; j < n; j++) {
+                if (row[j] != 0) s = sub_mod(s, mul_mod(row[j], x[j], p), p);
+            }
+            x[i] = s;
+        }
+        for (size_t i = 0; i < n; i++) out[i * m + c + 1] = mul_mod(det, x[i], p);
+    }
+    return true;
+}
+
+::BigInt to_bigint(u64 v) {
+    return ::BigInt(std::to_string(v));
+}
+
+}// namespace
+
+std::optional<std::vector<::Rational>> solve_linear_exact(
+        const std::vector<std::vector<::Rational>>& a, const std::vector<::Rational>& b) {
+    if (b.size() != a.size()) {
+        throw std::invalid_argument("Right-hand side length does not match the number of equations");
+    }
+    std::vector<std::vector<::Rational>> rhs;
+    rhs.reserve(b.size());
+    for (const auto& q : b) rhs.push_back({q});
+    auto x = solve_linear_exact(a, rhs);
+    if (!x) return std::nullopt;
+    std::vector<::Rational> result;
+    result.reserve(x->size());
+    for (auto& row : *x) result.push_back(std::move(row[0]));
+    return result;
+}
+
+std::optional<std::vector<std::vector<::Rational>>> solve_linear_exact(
+        const std::vector<std::vector<::Rational>>& a, const std::vector<std::vector<::Rational>>& b) {
+    const size_t n = a.size();
+    if (b.size() != n) {
+        throw std::invalid_argument("Right-hand side length does not match the number of equations");
+    }
+    for (const auto& row : a) {
+        if (row.size() != n) {
+            throw std::invalid_argument("Coefficient matrix must be square");
+        }
+    }
+    const size_t m = n == 0 ? 0 : b[0].size();
+    for (const auto& row : b) {
+        if (row.size() != m) {
+            throw std::invalid_argument("Right-hand side rows must have the same length");
+        }
+    }
+    if (n == 0) return std::vector<std::vector<::Rational>>{};
+
+    // 每行乘以分母的最小公倍数，同时估计 Hadamard 界（以二进制位计）
+    // |det(A)| 和 |det(A_i)| 都不超过各行范数之积，每行范数 ≤ sqrt(n + m) · 10^(最大位数)
+    ModSystem sys{n, m, std::vector<std::vector<std::string>>(n, std::vector<std::string>(n + m))};
+    double bound_bits = 1;
+    for (size_t i = 0; i < n; i++) {
+        ::BigInt l(1);
+        for (size_t j = 0; j < n + m; j++) {
+            const ::Rational& q = j < n ? a[i][j] : b[i][j - n];
+            l = ::BigInt::lcm(l, q.get_denominator());
+        }
+        size_t max_digits = 1;
+        for (size_t j = 0; j < n + m; j++) {
+            const ::Rational& q = j < n ? a[i][j] : b[i][j - n];
+            std::string s = (q.get_numerator() * (l / q.get_denominator())).to_string();
+            max_digits = std::max(max_digits, s.size() - (s[0] == '-' ? 1 : 0));
+            sys.rows[i][j] = std::move(s);
+        }
+        bound_bits += 0.5 * std::log2(static_cast<double>(n + m)) + max_digits * std::log2(10.0);
+    }
+
+    // 按批取素数并行求解，直到可用素数之积超过 2H
+    // det(A) = 0 时每个素数都奇异，奇异素数之积超过 H 即可断定无唯一解
+    std::vector<u64> primes;
+    std::vector<std::vector<u64>> residues;
+    double good_bits = 0, bad_bits = 0;
+    size_t next = 0;
+    const size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    const double bits_per_prime = std::log2(static_cast<double>(PRIME_START)) - 1;
+    while (good_bits <= bound_bits) {
+        if (bad_bits > bound_bits) return std::nullopt;
+
+        const size_t batch = static_cast<size_t>(std::ceil((bound_bits - good_bits) / bits_per_prime)) + 1;
+        std::vector<u64> batch_primes(batch);
+        for (size_t i = 0; i < batch; i++) batch_primes[i] = nth_prime(next + i);
+        next += batch;
+
+        std::vector<std::vector<u64>> batch_out(batch);
+        std::vector<char> ok(batch);
+        std::atomic<size_t> cursor{0};
+        auto work = [&] {
+            size_t i;
+            while ((i = cursor++) < batch) ok[i] = solve_mod(sys, batch_primes[i], batch_out[i]);
+        };
+        const size_t threads_needed = std::min(workers, batch);
+        if (threads_needed <= 1 || n < 16) {
+            work();
+        } else {
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < threads_needed; t++) threads.emplace_back(work);
+            for (auto& t : threads) t.join();
+        }
+
+        for (size_t i = 0; i < batch; i++) {
+            const double bits = std::log2(static_cast<double>(batch_primes[i]));
+            if (ok[i]) {
+                primes.push_back(batch_primes[i]);
+                residues.push_back(std::move(batch_out[i]));
+                good_bits += bits;
+            } else {
+                bad_bits += bits;
+            }
+        }
+    }
+
+    // Garner 算法还原，取对称剩余系
+    const size_t k = primes.size();
+    std::vector<std::vector<u64>> inv(k);
+    for (size_t i = 0; i < k; i++) {
+        inv[i].resize(i);
+        for (size_t j = 0; j < i; j++) inv[i][j] = inv_mod(primes[j] % primes[i], primes[i]);
+    }
+    ::BigInt modulus(1);
+    for (u64 p : primes) modulus = modulus * to_bigint(p);
+    const ::BigInt half = modulus / ::BigInt(2);
+
+    auto reconstruct = [&](size_t idx) {
+        std::vector<u64> c(k);
+        for (size_t i = 0; i < k; i++) {
+            u64 t = residues[i][idx];
+            for (size_t j = 0; j < i; j++) t = mul_mod(sub_mod(t, c[j] % primes[i], primes[i]), inv[i][j], primes[i]);
+            c[i] = t;
+        }
+        ::BigInt value = to_bigint(c[k - 1]);
+        for (size_t i = k - 1; i-- > 0;) value = value * to_bigint(primes[i]) + to_bigint(c[i]);
+        if (value > half) value = value - modulus;
+        return value;
+    };
+
+    const ::BigInt det = reconstruct(0);
+    std::vector<std::vector<::Rational>> x(n);
+    for (size_t i = 0; i < n; i++) {
+        x[i].reserve(m);
+        for (size_t c = 0; c < m; c++) x[i].emplace_back(reconstruct(i * m + c + 1), det);
+    }
+    return x;
+}
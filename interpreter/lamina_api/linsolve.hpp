@@ -0,0 +1,30 @@
+#pragma once
+#include "rational.hpp"
+#include <optional>
+#include <vector>
+
+#ifndef LAMINA_API
+#ifdef _WIN32
+#ifdef LAMINA_CORE_EXPORTS
+#define LAMINA_API __declspec(dllexport)
+#else
+#define LAMINA_API __declspec(dllimport)
+#endif
+#else
+#define LAMINA_API
+#endif
+#endif
+
+// 精确求解线性方程组 A x = b
+// 每行乘以分母的最小公倍数化为整数方程组，然后在若干个大素数下分别做模消元，
+// 用中国剩余定理还原 det(A) 和 Cramer 分子 det(A_i)，x_i = det(A_i) / det(A)
+// 素数个数由 Hadamard 界决定，结果是精确的；中间量都是机器字，系数不会膨胀
+// 稀疏方程组在消元时跳过为零的项
+
+// A 须为 n×n，b 长度为 n；没有唯一解（det(A) = 0）时返回 std::nullopt
+// 维数不匹配时抛出 std::invalid_argument
+LAMINA_API std::optional<std::vector<::Rational>> solve_linear_exact(
+        const std::vector<std::vector<::Rational>>& a, const std::vector<::Rational>& b);
+// 多个右端项：B 为 n×m，返回 n×m 的 X
+LAMINA_API std::optional<std::vector<std::vector<::Rational>>> solve_linear_exact(
+        const std::vector<std::vector<::Rational>>& a, const std::vector<std::vector<::Rational>>& b);
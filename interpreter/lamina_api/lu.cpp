@@ -0,0 +1,320 @@
+#include "lu.hpp"
+#include "gemm.hpp"
+#include "linsolve.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+// 分块 LU 的块宽，以及开始分块的阶数
+constexpr std::size_t LU_BLOCK = 64;
+constexpr std::size_t LU_BLOCK_MIN = 192;
+
+template<class T>
+using Rows = std::vector<std::vector<T>>;
+
+bool is_zero(std::int64_t v) { return v == 0; }
+bool is_zero(const ::BigInt& v) { return v.is_zero(); }
+
+bool is_one(const ::BigInt& v) { return !v.negative && v.digits.size() == 1 && v.digits[0] == 1; }
+
+// Bareiss 的一步：(p·x - l·u) / prev，结果是原矩阵的子式，必定整除
+::BigInt fused(const ::BigInt& p, const ::BigInt& x, const ::BigInt& l, const ::BigInt& u, const ::BigInt& prev) {
+    ::BigInt t = is_zero(l) ? p * x : p * x - l * u;
+    return is_one(prev) ? t : t / prev;
+}
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef __int128 Wide;
+#define LAMINA_LU_WORD
+
+::BigInt to_bigint(std::int64_t v) { return ::BigInt(std::to_string(v)); }
+
+// 子式不超过 2^62 时，两个乘积之差不超过 2^125，放得进 128 位
+std::int64_t fused(std::int64_t p, std::int64_t x, std::int64_t l, std::int64_t u, std::int64_t prev) {
+    return static_cast<std::int64_t>((static_cast<Wide>(p) * x - static_cast<Wide>(l) * u) / prev);
+}
+
+// 所有子式的 Hadamard 界（以二进制位计）是否小于 62
+bool fits_word(const IntMatrix& a) {
+    double bits = 0;
+    for (const auto& row : a) {
+        double sq = 0;
+        for (const auto& v : row) sq += v.to_double() * v.to_double();
+        bits += 0.5 * std::log2(std::max(sq, 1.0));
+    }
+    return bits < 62;
+}
+
+Rows<std::int64_t> to_words(const IntMatrix& a) {
+    Rows<std::int64_t> out(a.size());
+    for (std::size_t i = 0; i < a.size(); i++) {
+        out[i].reserve(a[i].size());
+        for (const auto& v : a[i]) out[i].push_back(std::stoll(v.to_string()));
+    }
+    return out;
+}
+#endif
+
+template<class T>
+T det_impl(Rows<T> a) {
+    const std::size_t n = a.size();
+    if (n == 0) return T(1);
+    T prev(1);
+    bool negate = false;
+    for (std::size_t k = 0; k < n; k++) {
+        if (is_zero(a[k][k])) {
+            std::size_t p = k + 1;
+            while (p < n && is_zero(a[p][k])) p++;
+            if (p == n) return T(0);
+            std::swap(a[k], a[p]);
+            negate = !negate;
+        }
+        for (std::size_t i = k + 1; i < n; i++) {
+            for (std::size_t j = k + 1; j < n; j++) a[i][j] = fused(a[k][k], a[i][j], a[i][k], a[k][j], prev);
+        }
+        prev = a[k][k];
+    }
+    return negate ? T(0) - a[n - 1][n - 1] : a[n - 1][n - 1];
+}
+
+// a 为增广矩阵 [A | B]；消元后每个对角元都等于 ±det(A)，右侧为 ±det(A)·X
+template<class T>
+std::optional<std::vector<std::vector<::Rational>>> solve_impl(Rows<T> a, std::size_t n) {
+    const std::size_t w = a.empty() ? 0 : a[0].size();
+    T prev(1);
+    for (std::size_t k = 0; k < n; k++) {
+        if (is_zero(a[k][k])) {
+            std::size_t p = k + 1;
+            while (p < n && is_zero(a[p][k])) p++;
+            if (p == n) return std::nullopt;
+            std::swap(a[k], a[p]);
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            if (i == k) continue;
+            for (std::size_t j = k + 1; j < w; j++) a[i][j] = fused(a[k][k], a[i][j], a[i][k], a[k][j], prev);
+            a[i][k] = T(0);
+        }
+        prev = a[k][k];
+    }
+    const ::BigInt d = to_bigint(prev);
+    std::vector<std::vector<::Rational>> x(n);
+    for (std::size_t i = 0; i < n; i++) {
+        x[i].reserve(w - n);
+        for (std::size_t j = n; j < w; j++) x[i].emplace_back(to_bigint(a[i][j]), d);
+    }
+    return x;
+}
+
+template<class T>
+std::size_t rank_impl(Rows<T> a) {
+    const std::size_t m = a.size();
+    const std::size_t cols = m == 0 ? 0 : a[0].size();
+    std::size_t r = 0;
+    T prev(1);
+    for (std::size_t c = 0; c < cols && r < m; c++) {
+        std::size_t p = r;
+        while (p < m && is_zero(a[p][c])) p++;
+        if (p == m) continue;
+        std::swap(a[r], a[p]);
+        for (std::size_t i = r + 1; i < m; i++) {
+            for (std::size_t j = c + 1; j < cols; j++) a[i][j] = fused(a[r][c], a[i][j], a[i][c], a[r][j], prev);
+            a[i][c] = T(0);
+        }
+        prev = a[r][c];
+        r++;
+    }
+    return r;
+}
+
+}// namespace
+
+LUFactor lu_factor(std::size_t n, std::vector<double> a) {
+    LUFactor f;
+    f.n = n;
+    f.lu = std::move(a);
+    f.perm.resize(n);
+    std::iota(f.perm.begin(), f.perm.end(), 0);
+    double* lu = f.lu.data();
+
+    // 小矩阵整体作为一块，即普通的逐列消元
+    const std::size_t block = n < LU_BLOCK_MIN ? std::max<std::size_t>(n, 1) : LU_BLOCK;
+    std::vector<double> l21, u12, update;
+    for (std::size_t k0 = 0; k0 < n; k0 += block) {
+        const std::size_t k1 = std::min(n, k0 + block);
+
+        // 当前块的列：选主元、交换整行、更新块内各列
+        for (std::size_t k = k0; k < k1; k++) {
+            std::size_t p = k;
+            for (std::size_t i = k + 1; i < n; i++) {
+                if (std::fabs(lu[i * n + k]) > std::fabs(lu[p * n + k])) p = i;
+            }
+            if (lu[p * n + k] == 0.0) {
+                f.singular = true;
+                continue;
+            }
+            if (p != k) {
+                std::swap_ranges(lu + p * n, lu + (p + 1) * n, lu + k * n);
+                std::swap(f.perm[p], f.perm[k]);
+                f.sign = -f.sign;
+            }
+            const double* pivot = lu + k * n;
+            for (std::size_t i = k + 1; i < n; i++) {
+                double* row = lu + i * n;
+                const double l = row[k] /= pivot[k];
+                if (l == 0.0) continue;
+                for (std::size_t j = k + 1; j < k1; j++) row[j] -= l * pivot[j];
+            }
+        }
+        if (k1 == n) break;
+
+        // U12 = L11⁻¹ · A12
+        const std::size_t rest = n - k1, width = k1 - k0;
+        for (std::size_t k = k0; k < k1; k++) {
+            for (std::size_t i = k + 1; i < k1; i++) {
+                const double l = lu[i * n + k];
+                if (l == 0.0) continue;
+                for (std::size_t j = k1; j < n; j++) lu[i * n + j] -= l * lu[k * n + j];
+            }
+        }
+
+        // A22 -= L21 · U12
+        l21.resize(rest * width);
+        u12.resize(width * rest);
+        update.resize(rest * rest);
+        for (std::size_t i = 0; i < rest; i++) {
+            std::copy_n(lu + (k1 + i) * n + k0, width, l21.data() + i * width);
+        }
+        for (std::size_t i = 0; i < width; i++) {
+            std::copy_n(lu + (k0 + i) * n + k1, rest, u12.data() + i * rest);
+        }
+        gemm(rest, rest, width, l21.data(), u12.data(), update.data());
+        for (std::size_t i = 0; i < rest; i++) {
+            double* row = lu + (k1 + i) * n + k1;
+            const double* d = update.data() + i * rest;
+            for (std::size_t j = 0; j < rest; j++) row[j] -= d[j];
+        }
+    }
+    return f;
+}
+
+double lu_det(const LUFactor& f) {
+    if (f.singular) return 0.0;
+    double det = f.sign;
+    for (std::size_t i = 0; i < f.n; i++) det *= f.lu[i * f.n + i];
+    return det;
+}
+
+void lu_solve(const LUFactor& f, std::size_t nrhs, double* b) {
+    const std::size_t n = f.n;
+    const double* lu = f.lu.data();
+    std::vector<double> x(n * nrhs);
+    for (std::size_t i = 0; i < n; i++) std::copy_n(b + f.perm[i] * nrhs, nrhs, x.data() + i * nrhs);
+
+    // L y = P b，逐行减去前面各行，最内层在右端项的各列上连续
+    for (std::size_t i = 0; i < n; i++) {
+        double* row = x.data() + i * nrhs;
+        for (std::size_t k = 0; k < i; k++) {
+            const double l = lu[i * n + k];
+            if (l == 0.0) continue;
+            const double* src = x.data() + k * nrhs;
+            for (std::size_t j = 0; j < nrhs; j++) row[j] -= l * src[j];
+        }
+    }
+    // U x = y
+    for (std::size_t i = n; i-- > 0;) {
+        double* row = x.data() + i * nrhs;
+        for (std::size_t k = i + 1; k < n; k++) {
+            const double u = lu[i * n + k];
+            if (u == 0.0) continue;
+            const double* src = x.data() + k * nrhs;
+            for (std::size_t j = 0; j < nrhs; j++) row[j] -= u * src[j];
+        }
+        const double d = lu[i * n + i];
+        for (std::size_t j = 0; j < nrhs; j++) row[j] /= d;
+    }
+    std::copy(x.begin(), x.end(), b);
+}
+
+std::size_t rank_float(std::size_t m, std::size_t n, std::vector<double> a) {
+    double largest = 0;
+    for (double v : a) largest = std::max(largest, std::fabs(v));
+    const double tol = static_cast<double>(std::max(m, n)) * std::numeric_limits<double>::epsilon() * largest;
+
+    std::size_t r = 0;
+    for (std::size_t c = 0; c < n && r < m; c++) {
+        std::size_t p = r;
+        for (std::size_t i = r + 1; i < m; i++) {
+            if (std::fabs(a[i * n + c]) > std::fabs(a[p * n + c])) p = i;
+        }
+        if (std::fabs(a[p * n + c]) <= tol) continue;
+        if (p != r) std::swap_ranges(a.begin() + p * n, a.begin() + (p + 1) * n, a.begin() + r * n);
+        const double* pivot = a.data() + r * n;
+        for (std::size_t i = r + 1; i < m; i++) {
+            double* row = a.data() + i * n;
+            const double l = row[c] / pivot[c];
+            if (l == 0.0) continue;
+            for (std::size_t j = c + 1; j < n; j++) row[j] -= l * pivot[j];
+        }
+        r++;
+    }
+    return r;
+}
+
+::BigInt bareiss_det(const IntMatrix& a) {
+    for (const auto& row : a) {
+        if (row.size() != a.size()) throw std::invalid_argument("Determinant requires a square matrix");
+    }
+#ifdef LAMINA_LU_WORD
+    if (fits_word(a)) return to_bigint(det_impl(to_words(a)));
+#endif
+    return det_impl(a);
+}
+
+std::optional<std::vector<std::vector<::Rational>>> bareiss_solve(const IntMatrix& a, const IntMatrix& b) {
+    const std::size_t n = a.size();
+    if (b.size() != n) {
+        throw std::invalid_argument("Right-hand side length does not match the number of equations");
+    }
+    for (const auto& row : a) {
+        if (row.size() != n) throw std::invalid_argument("Coefficient matrix must be square");
+    }
+    const std::size_t m = n == 0 ? 0 : b[0].size();
+    for (const auto& row : b) {
+        if (row.size() != m) throw std::invalid_argument("Right-hand side rows must have the same length");
+    }
+    if (n == 0) return std::vector<std::vector<::Rational>>{};
+
+    IntMatrix aug(n);
+    for (std::size_t i = 0; i < n; i++) {
+        aug[i].reserve(n + m);
+        aug[i].insert(aug[i].end(), a[i].begin(), a[i].end());
+        aug[i].insert(aug[i].end(), b[i].begin(), b[i].end());
+    }
+#ifdef LAMINA_LU_WORD
+    if (fits_word(aug)) return solve_impl(to_words(aug), n);
+#endif
+    // 系数较大时 BigInt 的除法太慢，改用多模消元
+    std::vector<std::vector<::Rational>> qa(n), qb(n);
+    for (std::size_t i = 0; i < n; i++) {
+        qa[i].assign(a[i].begin(), a[i].end());
+        qb[i].assign(b[i].begin(), b[i].end());
+    }
+    return solve_linear_exact(qa, qb);
+}
+
+std::size_t bareiss_rank(const IntMatrix& a) {
+    for (const auto& row : a) {
+        if (row.size() != a[0].size()) throw std::invalid_argument("Matrix rows must have the same length");
+    }
+#ifdef LAMINA_LU_WORD
+    if (fits_word(a)) return rank_impl(to_words(a));
+#endif
+    return rank_impl(a);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "bigint.hpp"
+#include "rational.hpp"
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#ifndef LAMINA_API
+#ifdef _WIN32
+#ifdef LAMINA_CORE_EXPORTS
+#define LAMINA_API __declspec(dllexport)
+#else
+#define LAMINA_API __declspec(dllimport)
+#endif
+#else
+#define LAMINA_API
+#endif
+#endif
+
+// 浮点矩阵：带部分主元的 LU 分解 P·A = L·U
+// 结果原地存放：严格下三角为 L（对角线为 1），上三角为 U；第 i 行来自原矩阵的第 perm[i] 行
+// n 较大时按列分块，每块消元后剩余部分的更新交给 gemm
+struct LUFactor {
+    std::size_t n = 0;
+    std::vector<double> lu;// n×n，行优先
+    std::vector<std::size_t> perm;
+    int sign = 1;// det(P)
+    bool singular = false;// 出现了为 0 的主元
+};
+
+LAMINA_API LUFactor lu_factor(std::size_t n, std::vector<double> a);
+LAMINA_API double lu_det(const LUFactor& f);
+// 求解 A X = B，B 为 n×nrhs 行优先，原地改写为 X；f 须非奇异
+LAMINA_API void lu_solve(const LUFactor& f, std::size_t nrhs, double* b);
+// 数值秩：部分主元消元，绝对值不超过 max(m, n)·eps·max|a_ij| 的主元视为 0
+LAMINA_API std::size_t rank_float(std::size_t m, std::size_t n, std::vector<double> a);
+
+// 整数矩阵：Bareiss 无分数消元，每步的除法都能整除，中间量都是原矩阵的子式，不会膨胀
+// 由 Hadamard 界判断子式能否放进 64 位整数，能放下时用机器字和 128 位乘积计算，否则用 BigInt
+// 有理数矩阵先把每行乘以分母的最小公倍数再调用
+using IntMatrix = std::vector<std::vector<::BigInt>>;
+
+LAMINA_API ::BigInt bareiss_det(const IntMatrix& a);
+// 无分数 Gauss-Jordan 消元求 A X = B，A 为 n×n，B 为 n×m；A 奇异时返回 std::nullopt
+// 子式放不进 64 位整数时改用 solve_linear_exact 的多模算法
+LAMINA_API std::optional<std::vector<std::vector<::Rational>>> bareiss_solve(const IntMatrix& a, const IntMatrix& b);
+LAMINA_API std::size_t bareiss_rank(const IntMatrix& a);
@@ -0,0 +1,446 @@
+#include "numarray.hpp"
+#include "gemm.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+// 长度一致时逐项运算，否则长度为 1 的一方当作常数；三种情况分开写成简单循环，便于向量化
+template<class T, class F>
+void zip(const T* a, std::size_t na, const T* b, std::size_t nb, T* out, std::size_t n, F f) {
+    if (na == nb) {
+        for (std::size_t i = 0; i < n; i++) out[i] = f(a[i], b[i]);
+    } else if (na == 1) {
+        const T x = a[0];
+        for (std::size_t i = 0; i < n; i++) out[i] = f(x, b[i]);
+    } else {
+        const T y = b[0];
+        for (std::size_t i = 0; i < n; i++) out[i] = f(a[i], y);
+    }
+}
+
+// int64 溢出按补码回绕，避免有符号溢出的未定义行为
+template<class T>
+void apply(NumArray::Op op, const T* a, std::size_t na, const T* b, std::size_t nb, T* out, std::size_t n) {
+    using Op = NumArray::Op;
+    if constexpr (std::is_integral_v<T>) {
+        using U = std::make_unsigned_t<T>;
+        switch (op) {
+            case Op::Add:
+                return zip(a, na, b, nb, out, n, [](T x, T y) { return static_cast<T>(U(x) + U(y)); });
+            case Op::Sub:
+                return zip(a, na, b, nb, out, n, [](T x, T y) { return static_cast<T>(U(x) - U(y)); });
+            case Op::Mul:
+                return zip(a, na, b, nb, out, n, [](T x, T y) { return static_cast<T>(U(x) * U(y)); });
+            case Op::Mod:
+                if (std::find(b, b + nb, T(0)) != b + nb) throw std::domain_error("Modulo by zero");
+                return zip(a, na, b, nb, out, n, [](T x, T y) { return y == -1 ? T(0) : T(x % y); });
+            default:
+                throw std::logic_error("integer division and power are computed in float64");
+        }
+    } else {
+        switch (op) {
+            case Op::Add:
+                return zip(a, na, b, nb, out, n, [](T x, T y) { return x + y; });
+            case Op::Sub:
+                return zip(a, na, b, nb, out, n, [](T x, T y) { return x - y; });
+            case Op::Mul:
+                return zip(a, na, b, nb, out, n, [](T x, T y) { return x * y; });
+            case Op::Div:
+                return zip(a, na, b, nb, out, n, [](T x, T y) { return x / y; });
+            case Op::Mod:
+                // 与标量取模一致，结果与除数同号
+                return zip(a, na, b, nb, out, n, [](T x, T y) { return x - y * std::floor(x / y); });
+            case Op::Pow:
+                return zip(a, na, b, nb, out, n, [](T x, T y) { return static_cast<T>(std::pow(x, y)); });
+        }
+    }
+}
+
+std::size_t product(const NumArray::Shape& shape) {
+    return std::accumulate(shape.begin(), shape.end(), std::size_t(1), std::multiplies<>());
+}
+
+}// namespace
+
+NumArray::NumArray(Storage data)
+    : buf_(std::make_shared<Storage>(std::move(data))) {
+    shape_ = {std::visit([](const auto& v) { return v.size(); }, *buf_)};
+    strides_ = {1};
+}
+
+NumArray::NumArray(DType dtype, Shape shape)
+    : shape_(std::move(shape)), strides_(row_major(shape_)) {
+    const std::size_t n = product(shape_);
+    switch (dtype) {
+        case DType::Int64: buf_ = std::make_shared<Storage>(std::vector<std::int64_t>(n)); break;
+        case DType::Float64: buf_ = std::make_shared<Storage>(std::vector<double>(n)); break;
+        case DType::Float32: buf_ = std::make_shared<Storage>(std::vector<float>(n)); break;
+    }
+}
+
+std::vector<std::ptrdiff_t> NumArray::row_major(const Shape& shape) {
+    std::vector<std::ptrdiff_t> strides(shape.size());
+    std::ptrdiff_t step = 1;
+    for (std::size_t d = shape.size(); d-- > 0;) {
+        strides[d] = step;
+        step *= static_cast<std::ptrdiff_t>(shape[d]);
+    }
+    return strides;
+}
+
+std::size_t NumArray::size() const {
+    return product(shape_);
+}
+
+bool NumArray::is_contiguous() const {
+    std::ptrdiff_t expected = 1;
+    for (std::size_t d = shape_.size(); d-- > 0;) {
+        if (shape_[d] != 1 && strides_[d] != expected) return false;
+        expected *= static_cast<std::ptrdiff_t>(shape_[d]);
+    }
+    return true;
+}
+
+std::ptrdiff_t NumArray::locate(std::size_t i) const {
+    if (shape_.size() == 1) return offset_ + static_cast<std::ptrdiff_t>(i) * strides_[0];
+    std::ptrdiff_t pos = offset_;
+    for (std::size_t d = shape_.size(); d-- > 0;) {
+        pos += static_cast<std::ptrdiff_t>(i % shape_[d]) * strides_[d];
+        i /= shape_[d];
+    }
+    return pos;
+}
+
+void NumArray::detach() {
+    if (buf_.use_count() != 1) *this = astype(dtype());
+}
+
+double NumArray::number(std::size_t i) const {
+    const auto pos = locate(i);
+    return std::visit([pos](const auto& v) { return static_cast<double>(v[pos]); }, *buf_);
+}
+
+std::int64_t NumArray::integer(std::size_t i) const {
+    const auto pos = locate(i);
+    return std::visit([pos](const auto& v) { return static_cast<std::int64_t>(v[pos]); }, *buf_);
+}
+
+void NumArray::set(std::size_t i, double v) {
+    detach();
+    const auto pos = locate(i);
+    std::visit([pos, v](auto& vec) { vec[pos] = static_cast<typename std::decay_t<decltype(vec)>::value_type>(v); }, *buf_);
+}
+
+void NumArray::set(std::size_t i, std::int64_t v) {
+    detach();
+    const auto pos = locate(i);
+    std::visit([pos, v](auto& vec) { vec[pos] = static_cast<typename std::decay_t<decltype(vec)>::value_type>(v); }, *buf_);
+}
+
+NumArray NumArray::astype(DType dtype) const {
+    NumArray out(dtype, shape_);
+    const bool dense = is_contiguous();
+    std::visit([&](auto& dst) {
+        using T = typename std::decay_t<decltype(dst)>::value_type;
+        std::visit([&](const auto& src) {
+            if (dense) {
+                const auto* p = src.data() + offset_;
+                std::transform(p, p + dst.size(), dst.begin(), [](auto x) { return static_cast<T>(x); });
+            } else {
+                for (std::size_t i = 0; i < dst.size(); i++) dst[i] = static_cast<T>(src[locate(i)]);
+            }
+        }, *buf_);
+    }, *out.buf_);
+    return out;
+}
+
+NumArray NumArray::contiguous() const {
+    return is_contiguous() ? *this : astype(dtype());
+}
+
+NumArray NumArray::reshape(Shape shape) const {
+    if (shape.empty()) throw std::invalid_argument("Shape must have at least one dimension");
+    const auto unknown = std::count(shape.begin(), shape.end(), SIZE_MAX);
+    if (unknown > 1) throw std::invalid_argument("Only one dimension can be inferred");
+    if (unknown == 1) {
+        std::size_t known = 1;
+        for (auto d : shape) {
+            if (d != SIZE_MAX) known *= d;
+        }
+        if (known == 0 || size() % known != 0) {
+            throw std::invalid_argument("Cannot reshape array of size " + std::to_string(size()));
+        }
+        *std::find(shape.begin(), shape.end(), SIZE_MAX) = size() / known;
+    }
+    if (product(shape) != size()) {
+        throw std::invalid_argument("Cannot reshape array of size " + std::to_string(size()) + " into shape " + shape_string(shape));
+    }
+    NumArray view = contiguous();
+    view.strides_ = row_major(shape);
+    view.shape_ = std::move(shape);
+    return view;
+}
+
+NumArray NumArray::transpose() const {
+    std::vector<std::size_t> axes(ndim());
+    std::iota(axes.rbegin(), axes.rend(), std::size_t(0));
+    return transpose(axes);
+}
+
+NumArray NumArray::transpose(const std::vector<std::size_t>& axes) const {
+    if (axes.size() != ndim()) throw std::invalid_argument("Axes do not match array dimensions");
+    std::vector<char> seen(ndim());
+    NumArray view = *this;
+    for (std::size_t k = 0; k < axes.size(); k++) {
+        if (axes[k] >= ndim() || seen[axes[k]]) throw std::invalid_argument("Axes must be a permutation of the dimensions");
+        seen[axes[k]] = 1;
+        view.shape_[k] = shape_[axes[k]];
+        view.strides_[k] = strides_[axes[k]];
+    }
+    return view;
+}
+
+NumArray NumArray::slice(std::size_t axis, std::ptrdiff_t start, std::ptrdiff_t stop, std::ptrdiff_t step) const {
+    if (axis >= ndim()) throw std::invalid_argument("Axis out of range");
+    if (step <= 0) throw std::invalid_argument("Slice step must be positive");
+    const auto len = static_cast<std::ptrdiff_t>(shape_[axis]);
+    // 负数下标从末尾数起，越界时截到边界
+    auto clamp = [len](std::ptrdiff_t i) { return std::clamp(i < 0 ? i + len : i, std::ptrdiff_t(0), len); };
+    start = clamp(start);
+    stop = clamp(stop);
+    NumArray view = *this;
+    view.offset_ += start * strides_[axis];
+    view.shape_[axis] = stop > start ? static_cast<std::size_t>((stop - start + step - 1) / step) : 0;
+    view.strides_[axis] *= step;
+    return view;
+}
+
+NumArray NumArray::take(std::size_t i) const {
+    if (ndim() < 2) throw std::invalid_argument("take() needs at least two dimensions");
+    if (i >= shape_[0]) throw std::invalid_argument("Index out of range");
+    NumArray view = *this;
+    view.offset_ += static_cast<std::ptrdiff_t>(i) * strides_[0];
+    view.shape_.erase(view.shape_.begin());
+    view.strides_.erase(view.strides_.begin());
+    return view;
+}
+
+NumArray NumArray::binary(Op op, const NumArray& a, const NumArray& b) {
+    // 广播后的形状
+    const std::size_t nd = std::max(a.ndim(), b.ndim());
+    Shape shape(nd);
+    for (std::size_t k = 0; k < nd; k++) {
+        const std::size_t da = k + a.ndim() >= nd ? a.shape_[k + a.ndim() - nd] : 1;
+        const std::size_t db = k + b.ndim() >= nd ? b.shape_[k + b.ndim() - nd] : 1;
+        if (da != db && da != 1 && db != 1) {
+            throw std::invalid_argument("Shapes " + shape_string(a.shape_) + " and " + shape_string(b.shape_) + " cannot be broadcast");
+        }
+        shape[k] = da == 1 ? db : da;
+    }
+
+    DType result = promote(a.dtype(), b.dtype());
+    if (result == DType::Int64 && (op == Op::Div || op == Op::Pow)) result = DType::Float64;
+
+    // 类型不同的一方先整体转换，内层循环只处理同一种类型
+    NumArray ca, cb;
+    const NumArray* pa = &a;
+    const NumArray* pb = &b;
+    if (a.dtype() != result) pa = &(ca = a.astype(result));
+    if (b.dtype() != result) pb = &(cb = b.astype(result));
+
+    NumArray out(result, shape);
+    const std::size_t n = out.size();
+    if (n == 0) return out;
+
+    std::visit([&](auto& dst) {
+        using Vec = std::decay_t<decltype(dst)>;
+        using T = typename Vec::value_type;
+        const T* xa = std::get<Vec>(*pa->buf_).data();
+        const T* xb = std::get<Vec>(*pb->buf_).data();
+
+        // 紧密排列且形状相同，或只有一个元素：整体一个循环
+        auto flat = [&](const NumArray* p) -> std::size_t {
+            if (p->size() == 1) return 1;
+            return p->shape_ == shape && p->is_contiguous() ? n : 0;
+        };
+        const std::size_t na = flat(pa), nb = flat(pb);
+        if (na && nb) {
+            apply(op, xa + pa->offset_, na, xb + pb->offset_, nb, dst.data(), n);
+            return;
+        }
+
+        // 一般情况：外层按多维下标推进，最后一维是内层循环；被广播的维步长为 0
+        auto aligned = [&](const NumArray* p) {
+            std::vector<std::ptrdiff_t> s(nd, 0);
+            for (std::size_t j = 0; j < p->ndim(); j++) {
+                if (p->shape_[j] != 1) s[nd - p->ndim() + j] = p->strides_[j];
+            }
+            return s;
+        };
+        const auto sa = aligned(pa), sb = aligned(pb);
+        const std::size_t len = shape[nd - 1];
+        std::vector<T> ta, tb;
+        // 内层步长为 1 或 0 时直接使用原数组，否则先收集到临时数组
+        auto row = [len](const T* base, std::ptrdiff_t stride, std::vector<T>& tmp, std::size_t& count) -> const T* {
+            if (stride == 1) {
+                count = len;
+                return base;
+            }
+            if (stride == 0) {
+                count = 1;
+                return base;
+            }
+            tmp.resize(len);
+            for (std::size_t i = 0; i < len; i++) tmp[i] = base[static_cast<std::ptrdiff_t>(i) * stride];
+            count = len;
+            return tmp.data();
+        };
+
+        std::vector<std::size_t> idx(nd, 0);
+        std::ptrdiff_t oa = pa->offset_, ob = pb->offset_;
+        for (std::size_t o = 0; o < n; o += len) {
+            std::size_t la, lb;
+            const T* ra = row(xa + oa, sa[nd - 1], ta, la);
+            const T* rb = row(xb + ob, sb[nd - 1], tb, lb);
+            if (la == 1 && lb == 1 && len != 1) {
+                tb.assign(len, rb[0]);
+                rb = tb.data();
+                lb = len;
+            }
+            apply(op, ra, la, rb, lb, dst.data() + o, len);
+            for (std::size_t d = nd - 1; d-- > 0;) {
+                oa += sa[d];
+                ob += sb[d];
+                if (++idx[d] < shape[d]) break;
+                oa -= sa[d] * static_cast<std::ptrdiff_t>(shape[d]);
+                ob -= sb[d] * static_cast<std::ptrdiff_t>(shape[d]);
+                idx[d] = 0;
+            }
+        }
+    }, *out.buf_);
+    return out;
+}
+
+NumArray NumArray::map(double (*f)(double)) const {
+    const NumArray src = contiguous();
+    const std::size_t n = size();
+    NumArray out(dtype() == DType::Float32 ? DType::Float32 : DType::Float64, shape_);
+    std::visit([&](auto& dst) {
+        using T = typename std::decay_t<decltype(dst)>::value_type;
+        std::visit([&](const auto& v) {
+            const auto* p = v.data() + src.offset_;
+            for (std::size_t i = 0; i < n; i++) dst[i] = static_cast<T>(f(static_cast<double>(p[i])));
+        }, *src.buf_);
+    }, *out.buf_);
+    return out;
+}
+
+double NumArray::sum() const {
+    const NumArray src = contiguous();
+    const std::size_t n = size();
+    return std::visit([&](const auto& v) {
+        const auto* p = v.data() + src.offset_;
+        // 四路部分和，减少循环依赖
+        double s[4] = {0, 0, 0, 0};
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            for (int k = 0; k < 4; k++) s[k] += static_cast<double>(p[i + k]);
+        }
+        for (; i < n; i++) s[0] += static_cast<double>(p[i]);
+        return (s[0] + s[1]) + (s[2] + s[3]);
+    }, *src.buf_);
+}
+
+double NumArray::dot(const NumArray& other) const {
+    if (shape_ != other.shape_) {
+        throw std::invalid_argument("Dot product requires same dimensions");
+    }
+    const NumArray x = contiguous(), y = other.contiguous();
+    const std::size_t n = size();
+    return std::visit([&](const auto& u, const auto& v) {
+        const auto* p = u.data() + x.offset_;
+        const auto* q = v.data() + y.offset_;
+        double s[4] = {0, 0, 0, 0};
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            for (int k = 0; k < 4; k++) s[k] += static_cast<double>(p[i + k]) * static_cast<double>(q[i + k]);
+        }
+        for (; i < n; i++) s[0] += static_cast<double>(p[i]) * static_cast<double>(q[i]);
+        return (s[0] + s[1]) + (s[2] + s[3]);
+    }, *x.buf_, *y.buf_);
+}
+
+NumArray NumArray::matmul(const NumArray& a, const NumArray& b) {
+    if (a.ndim() == 0 || a.ndim() > 2 || b.ndim() == 0 || b.ndim() > 2 || (a.ndim() == 1 && b.ndim() == 1)) {
+        throw std::invalid_argument("Matrix multiplication requires 2-D arrays");
+    }
+    const std::size_t m = a.ndim() == 2 ? a.shape_[0] : 1;
+    const std::size_t k = a.shape_.back();
+    const std::size_t n = b.ndim() == 2 ? b.shape_[1] : 1;
+    if (b.shape_[0] != k) {
+        throw std::invalid_argument("Shapes " + shape_string(a.shape_) + " and " + shape_string(b.shape_) + " are not aligned");
+    }
+    Shape shape;
+    if (a.ndim() == 2) shape.push_back(m);
+    if (b.ndim() == 2) shape.push_back(n);
+
+    if (a.is_integral() && b.is_integral()) {
+        const NumArray x = a.contiguous(), y = b.contiguous();
+        NumArray out(DType::Int64, std::move(shape));
+        const auto* p = std::get<std::vector<std::int64_t>>(*x.buf_).data() + x.offset_;
+        const auto* q = std::get<std::vector<std::int64_t>>(*y.buf_).data() + y.offset_;
+        auto* r = std::get<std::vector<std::int64_t>>(*out.buf_).data();
+        // i-p-j 顺序，最内层连续访问 B 和 C 的同一行
+        for (std::size_t i = 0; i < m; i++) {
+            for (std::size_t t = 0; t < k; t++) {
+                const std::int64_t f = p[i * k + t];
+                for (std::size_t j = 0; j < n; j++) r[i * n + j] += f * q[t * n + j];
+            }
+        }
+        return out;
+    }
+
+    const NumArray x = a.dtype() == DType::Float64 ? a.contiguous() : a.astype(DType::Float64);
+    const NumArray y = b.dtype() == DType::Float64 ? b.contiguous() : b.astype(DType::Float64);
+    NumArray out(DType::Float64, std::move(shape));
+    gemm(m, n, k, std::get<std::vector<double>>(*x.buf_).data() + x.offset_,
+         std::get<std::vector<double>>(*y.buf_).data() + y.offset_,
+         std::get<std::vector<double>>(*out.buf_).data());
+    return promote(a.dtype(), b.dtype()) == DType::Float32 ? out.astype(DType::Float32) : out;
+}
+
+const char* NumArray::dtype_name(DType dtype) {
+    switch (dtype) {
+        case DType::Int64: return "int64";
+        case DType::Float64: return "float64";
+        case DType::Float32: return "float32";
+    }
+    return "unknown";
+}
+
+bool NumArray::parse_dtype(const std::string& name, DType& out) {
+    for (DType d : {DType::Int64, DType::Float64, DType::Float32}) {
+        if (name == dtype_name(d)) {
+            out = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+NumArray::DType NumArray::promote(DType a, DType b) {
+    return a == b ? a : DType::Float64;
+}
+
+std::string NumArray::shape_string(const Shape& shape) {
+    std::string out = "(";
+    for (std::size_t i = 0; i < shape.size(); i++) {
+        if (i) out += ", ";
+        out += std::to_string(shape[i]);
+    }
+    return out + (shape.size() == 1 ? ",)" : ")");
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+#ifndef LAMINA_API
+#ifdef _WIN32
+#ifdef LAMINA_CORE_EXPORTS
+#define LAMINA_API __declspec(dllexport)
+#else
+#define LAMINA_API __declspec(dllimport)
+#endif
+#else
+#define LAMINA_API
+#endif
+#endif
+
+// 同类型数值数组：元素连续存放在 int64 / float64 / float32 数组里，不是 Value
+// 逐元素运算直接在原始数组上循环，不做类型分派，编译器可以自动向量化
+//
+// 多维数组由 shape / strides / offset 描述如何在一块存储上取元素，
+// reshape、transpose、slice、按第一维取子数组都只生成新的描述，与原数组共享存储；
+// 写入前若存储被共享则先复制（写时复制），所以视图之间互不影响
+class LAMINA_API NumArray {
+public:
+    // 顺序与 Storage 中的备选类型一致
+    enum class DType : unsigned char { Int64, Float64, Float32 };
+    using Storage = std::variant<std::vector<std::int64_t>, std::vector<double>, std::vector<float>>;
+    using Shape = std::vector<std::size_t>;
+
+    enum class Op : unsigned char { Add, Sub, Mul, Div, Mod, Pow };
+
+    NumArray() : NumArray(DType::Float64, 0) {}
+    // 全为 0 的一维 / 多维数组
+    NumArray(DType dtype, std::size_t n) : NumArray(dtype, Shape{n}) {}
+    NumArray(DType dtype, Shape shape);
+    explicit NumArray(std::vector<std::int64_t> data) : NumArray(Storage(std::move(data))) {}
+    explicit NumArray(std::vector<double> data) : NumArray(Storage(std::move(data))) {}
+    explicit NumArray(std::vector<float> data) : NumArray(Storage(std::move(data))) {}
+
+    DType dtype() const { return static_cast<DType>(buf_->index()); }
+    bool is_integral() const { return dtype() == DType::Int64; }
+    std::size_t size() const;
+    std::size_t ndim() const { return shape_.size(); }
+    const Shape& shape() const { return shape_; }
+    // 元素是否按行优先顺序紧密排列
+    bool is_contiguous() const;
+
+    // 按行优先顺序的第 i 个元素，按 double / int64 读出
+    double number(std::size_t i) const;
+    std::int64_t integer(std::size_t i) const;
+    // 写入按行优先顺序的第 i 个元素，按本数组的类型截断
+    void set(std::size_t i, double v);
+    void set(std::size_t i, std::int64_t v);
+
+    NumArray astype(DType dtype) const;
+    // 行优先紧密排列的数组；已经紧密时与原数组共享存储
+    NumArray contiguous() const;
+
+    // 以下均为视图，不复制元素；参数不合法时抛出 std::invalid_argument
+    NumArray reshape(Shape shape) const;// 至多一维可为 SIZE_MAX，其长度由其余维推出
+    NumArray transpose() const;// 反转所有维
+    NumArray transpose(const std::vector<std::size_t>& axes) const;
+    NumArray slice(std::size_t axis, std::ptrdiff_t start, std::ptrdiff_t stop, std::ptrdiff_t step = 1) const;
+    NumArray take(std::size_t i) const;// 第一维的第 i 个子数组，少一维
+
+    // 逐元素运算，按 NumPy 规则广播：从最后一维对齐，长度为 1 的维扩展到另一方
+    // 形状无法广播时抛出 std::invalid_argument，整数取模除以 0 时抛出 std::domain_error
+    static NumArray binary(Op op, const NumArray& a, const NumArray& b);
+    // 逐元素套用 f，整数数组的结果为 float64
+    NumArray map(double (*f)(double)) const;
+
+    double sum() const;
+    double dot(const NumArray& other) const;
+    // 矩阵乘法，至少一方为二维；一维的一方当作行向量 / 列向量，结果相应少一维
+    // 两个 int64 数组直接按整数计算，其余经 float64 的 gemm 计算后转为提升后的类型
+    static NumArray matmul(const NumArray& a, const NumArray& b);
+
+    // 类型名与 "int64" / "float64" / "float32" 互转
+    static const char* dtype_name(DType dtype);
+    static bool parse_dtype(const std::string& name, DType& out);
+    // 两种类型运算后的类型
+    static DType promote(DType a, DType b);
+    // 形如 (2, 3) 的形状描述，用于错误信息
+    static std::string shape_string(const Shape& shape);
+
+private:
+    explicit NumArray(Storage data);
+
+    std::shared_ptr<Storage> buf_;
+    Shape shape_;
+    std::vector<std::ptrdiff_t> strides_;// 以元素为单位
+    std::ptrdiff_t offset_ = 0;
+
+    // 行优先顺序的第 i 个元素在存储中的位置
+    std::ptrdiff_t locate(std::size_t i) const;
+    // 写入前调用：存储被其他数组共享时先复制一份
+    void detach();
+    static std::vector<std::ptrdiff_t> row_major(const Shape& shape);
+};
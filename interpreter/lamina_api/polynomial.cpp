@@ -0,0 +1,220 @@
+#include "polynomial.hpp"
+
+Polynomial Polynomial::constant(const ::Rational& c) {
+    Polynomial p;
+    if (!c.is_zero()) p.terms[{}] = c;
+    return p;
+}
+
+Polynomial Polynomial::variable(const std::string& name) {
+    Polynomial p;
+    p.variables.push_back(name);
+    p.terms[{1}] = ::Rational(1);
+    return p;
+}
+
+void Polynomial::add_term(const Exponents& e, const ::Rational& c) {
+    if (c.is_zero()) return;
+    auto it = terms.find(e);
+    if (it == terms.end()) {
+        terms.emplace(e, c);
+        return;
+    }
+    it->second = it->second + c;
+    if (it->second.is_zero()) terms.erase(it);
+}
+
+std::vector<std::string> Polynomial::merge_variables(const Polynomial& a, const Polynomial& b) {
+    std::vector<std::string> vars;
+    std::set_union(a.variables.begin(), a.variables.end(), b.variables.begin(), b.variables.end(),
+        std::back_inserter(vars));
+    return vars;
+}
+
+Polynomial Polynomial::aligned(const std::vector<std::string>& vars) const {
+    if (vars == variables) return *this;
+    // 旧变量在新变量表中的位置
+    std::vector<size_t> pos(variables.size());
+    for (size_t i = 0; i < variables.size(); i++) {
+        pos[i] = std::lower_bound(vars.begin(), vars.end(), variables[i]) - vars.begin();
+    }
+    Polynomial res;
+    res.variables = vars;
+    for (const auto& [e, c] : terms) {
+        Exponents ne(vars.size(), 0);
+        for (size_t i = 0; i < e.size(); i++) ne[pos[i]] = e[i];
+        res.terms.emplace(std::move(ne), c);
+    }
+    return res;
+}
+
+Polynomial Polynomial::operator+(const Polynomial& other) const {
+    auto vars = merge_variables(*this, other);
+    Polynomial res = aligned(vars);
+    for (const auto& [e, c] : other.aligned(vars).terms) res.add_term(e, c);
+    return res;
+}
+
+Polynomial Polynomial::operator-() const {
+    Polynomial res = *this;
+    for (auto& t : res.terms) t.second = -t.second;
+    return res;
+}
+
+Polynomial Polynomial::operator-(const Polynomial& other) const {
+    return *this + (-other);
+}
+
+Polynomial Polynomial::operator*(const Polynomial& other) const {
+    auto vars = merge_variables(*this, other);
+    Polynomial a = aligned(vars), b = other.aligned(vars);
+    Polynomial res;
+    res.variables = vars;
+    Exponents e(vars.size());
+    for (const auto& [ea, ca] : a.terms) {
+        for (const auto& [eb, cb] : b.terms) {
+            for (size_t i = 0; i < e.size(); i++) e[i] = ea[i] + eb[i];
+            res.add_term(e, ca * cb);
+        }
+    }
+    return res;
+}
+
+Polynomial Polynomial::power(unsigned int exponent) const {
+    Polynomial result = constant(::Rational(1)).aligned(variables), base = *this;
+    while (exponent) {
+        if (exponent & 1u) result = result * base;
+        exponent >>= 1;
+        if (exponent) base = base * base;
+    }
+    return result;
+}
+
+std::pair<Polynomial, Polynomial> Polynomial::divide(const Polynomial& divisor) const {
+    if (divisor.is_zero()) throw std::runtime_error("Polynomial division by zero");
+    auto vars = merge_variables(*this, divisor);
+    Polynomial p = aligned(vars), g = divisor.aligned(vars);
+    Polynomial quotient, remainder;
+    quotient.variables = remainder.variables = vars;
+    const auto& [lead_e, lead_c] = *g.terms.rbegin();
+
+    while (!p.is_zero()) {
+        auto [pe, pc] = *p.terms.rbegin();
+        bool divisible = true;
+        for (size_t i = 0; i < pe.size() && divisible; i++) divisible = pe[i] >= lead_e[i];
+        if (!divisible) {
+            // 首项不能整除，移入余式
+            remainder.add_term(pe, pc);
+            p.terms.erase(pe);
+            continue;
+        }
+        Exponents te(pe.size());
+        for (size_t i = 0; i < te.size(); i++) te[i] = pe[i] - lead_e[i];
+        ::Rational tc = pc / lead_c;
+        quotient.add_term(te, tc);
+        Exponents e(te.size());
+        for (const auto& [ge, gc] : g.terms) {
+            for (size_t i = 0; i < e.size(); i++) e[i] = te[i] + ge[i];
+            p.add_term(e, -(tc * gc));
+        }
+    }
+    return {quotient, remainder};
+}
+
+unsigned int Polynomial::degree() const {
+    unsigned int d = 0;
+    for (const auto& [e, c] : terms) {
+        unsigned int sum = 0;
+        for (auto i : e) sum += i;
+        d = std::max(d, sum);
+    }
+    return d;
+}
+
+namespace {
+    // C(n, k)，超过 limit 时提前返回
+    double binomial(unsigned int n, unsigned int k, double limit) {
+        k = std::min(k, n - k);
+        double r = 1;
+        for (unsigned int i = 1; i <= k && r <= limit; i++) r = r * (n - k + i) / i;
+        return r;
+    }
+
+    // 展开后的项数与总次数都不超过限制；项数用 变量数 v、总次数 d 的单项式个数 C(d + v, v) 再取较小值
+    bool within_budget(double terms, unsigned int degree, size_t variables) {
+        if (degree > Polynomial::max_degree) return false;
+        const double limit = static_cast<double>(Polynomial::max_terms);
+        return std::min(terms, binomial(degree + static_cast<unsigned int>(variables), degree, limit)) <= limit;
+    }
+}
+
+bool Polynomial::from_symbolic(const std::shared_ptr<SymbolicExpr>& expr, Polynomial& out) {
+    using Type = SymbolicExpr::Type;
+    switch (expr->type) {
+        case Type::Number:
+            out = constant(expr->convert_rational());
+            return true;
+        case Type::Variable:
+            out = variable(expr->identifier);
+            return true;
+        case Type::Add:
+        case Type::Multiply: {
+            if (expr->operands.empty()) return false;
+            Polynomial acc;
+            if (!from_symbolic(expr->operands[0], acc)) return false;
+            for (size_t i = 1; i < expr->operands.size(); i++) {
+                Polynomial next;
+                if (!from_symbolic(expr->operands[i], next)) return false;
+                if (expr->type == Type::Multiply && !within_budget(static_cast<double>(acc.terms.size()) * next.terms.size(),
+                        acc.degree() + next.degree(), acc.variables.size() + next.variables.size()))
+                    return false;
+                acc = expr->type == Type::Add ? acc + next : acc * next;
+            }
+            out = std::move(acc);
+            return true;
+        }
+        case Type::Power: {
+            // 只接受非负整数指数，且展开结果在规模限制内
+            const auto& ex = expr->operands[1];
+            if (!ex->is_number()) return false;
+            ::Rational r = ex->convert_rational();
+            if (!r.is_integer() || r < ::Rational(0) || r > ::Rational(static_cast<int>(max_degree))) return false;
+            Polynomial base;
+            if (!from_symbolic(expr->operands[0], base)) return false;
+            const unsigned int n = static_cast<unsigned int>(r.get_numerator().to_int());
+            // t 项之和的 n 次方至多有 C(n + t - 1, t - 1) 项
+            const unsigned int t = static_cast<unsigned int>(std::max<size_t>(base.terms.size(), 1));
+            const double limit = static_cast<double>(max_terms);
+            if (!within_budget(binomial(n + t - 1, t - 1, limit), base.degree() * n, base.variables.size()))
+                return false;
+            out = base.power(n);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+std::shared_ptr<SymbolicExpr> Polynomial::to_symbolic() const {
+    // 直接构造规范形式的 n 元加法，与 simplify 的结果一致，不再整体化简
+    std::vector<std::shared_ptr<SymbolicExpr>> sum;
+    sum.reserve(terms.size());
+    for (const auto& [e, c] : terms) {
+        std::vector<std::shared_ptr<SymbolicExpr>> factors;
+        for (size_t i = 0; i < e.size(); i++) {
+            if (!e[i]) continue;
+            auto factor = SymbolicExpr::variable(variables[i]);
+            if (e[i] > 1) factor = SymbolicExpr::power(factor, SymbolicExpr::number(static_cast<int>(e[i])));
+            factors.push_back(factor);
+        }
+        if (factors.empty()) {
+            sum.push_back(SymbolicExpr::exact_number(c));
+            continue;
+        }
+        SymbolicExpr::sort_factors(factors);
+        if (c != ::Rational(1)) factors.insert(factors.begin(), SymbolicExpr::exact_number(c));
+        sum.push_back(SymbolicExpr::multiply(factors));
+    }
+    SymbolicExpr::sort_terms(sum);
+    return SymbolicExpr::add(sum);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "symbolic.hpp"
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 稀疏多元多项式，系数为有理数
+// 符号表达式中只含数字、变量、加法、乘法和非负整数次幂时，用它来展开和约分
+
+class LAMINA_API Polynomial {
+public:
+    // 每个变量的指数，顺序与 variables 一致
+    using Exponents = std::vector<unsigned int>;
+
+    // 变量名，按字典序排列
+    std::vector<std::string> variables;
+
+    // 单项式 -> 系数，系数均非零；键的字典序即单项式的字典序
+    std::map<Exponents, ::Rational> terms;
+
+    // from_symbolic 的规模限制：展开结果的项数与总次数
+    static constexpr size_t max_terms = 2048;
+    static constexpr unsigned int max_degree = 256;
+
+    Polynomial() = default;
+
+    static Polynomial constant(const ::Rational& c);
+    static Polynomial variable(const std::string& name);
+
+    bool is_zero() const { return terms.empty(); }
+    bool is_constant() const {
+        return terms.empty() || (terms.size() == 1 && is_constant_monomial(terms.begin()->first));
+    }
+
+    Polynomial operator+(const Polynomial& other) const;
+    Polynomial operator-(const Polynomial& other) const;
+    Polynomial operator*(const Polynomial& other) const;
+    Polynomial operator-() const;
+    Polynomial power(unsigned int exponent) const;
+
+    // 总次数，零多项式为 0
+    unsigned int degree() const;
+
+    // 字典序下的多元带余除法，返回 {商, 余式}
+    std::pair<Polynomial, Polynomial> divide(const Polynomial& divisor) const;
+
+    // 表达式不是多项式，或展开后超出规模限制时返回 false
+    static bool from_symbolic(const std::shared_ptr<SymbolicExpr>& expr, Polynomial& out);
+
+    // 转回符号表达式：按规范顺序直接构造，结果即化简后的形式
+    std::shared_ptr<SymbolicExpr> to_symbolic() const;
+
+private:
+    static bool is_constant_monomial(const Exponents& e) {
+        for (auto i : e) {
+            if (i) return false;
+        }
+        return true;
+    }
+
+    // 把变量表扩充为 vars（vars 须包含当前所有变量）
+    Polynomial aligned(const std::vector<std::string>& vars) const;
+    static std::vector<std::string> merge_variables(const Polynomial& a, const Polynomial& b);
+    void add_term(const Exponents& e, const ::Rational& c);
+};
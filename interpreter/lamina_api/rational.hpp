@@ -39,7 +39,7 @@ private:
 
         // 化简
         BigInt g = gcd(numerator, denominator);
-        if (g != 0 and g != 1) {
+        if (g != BigInt(0) and g != BigInt(1)) {
             numerator = numerator / g;
             denominator = denominator / g;
         }
@@ -204,7 +204,9 @@ public:
             return Rational();
         }
         if (std::floor(value) == value) {   // 是整数，分母设为1
-            return Rational(BigInt(std::to_string(value)));
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(0) << value;
+            return Rational(BigInt(oss.str()));
         }
         std::ostringstream oss;
         oss << std::scientific << std::setprecision(15) << value;
@@ -251,10 +253,17 @@ public:
 
     // 转换为字符串
     std::string to_string() const {
-        if (is_integer()) {
-            return numerator.ToString();
-        }
-        return numerator.ToString() + "/" + denominator.ToString();
+        std::string result;
+        write_to(result);
+        return result;
+    }
+
+    // 追加到 out 末尾
+    void write_to(std::string& out) const {
+        numerator.write_to(out);
+        if (is_integer()) return;
+        out += '/';
+        denominator.write_to(out);
     }
 
     //转换成小数字符串，如果为循环小数循环节用括号圈出并在末尾添加...
@@ -295,8 +304,11 @@ public:
             BigInt pow10n(10);
             pow10n = pow10n.power(BigInt(n));
             std::string re = (numerator * pow10n / denominator).ToString();
-            if (n == re.size()) re.insert(re.end() - n, '0');//如果没有个位添加为0
+            const bool negative = re[0] == '-';
+            if (negative) re.erase(re.begin());
+            if (re.size() <= static_cast<size_t>(n)) re.insert(0, n + 1 - re.size(), '0');//整数位为0，小数位不足n位时补0
             re.insert(re.end() - n,'.');
+            if (negative) re.insert(re.begin(), '-');
             while (re.back() == '0') re.pop_back();//去除末尾的0
             if (re.back() == '.') re.pop_back();//如果为小数点也排除
             return re;
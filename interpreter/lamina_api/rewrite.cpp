@@ -0,0 +1,73 @@
+#include "rewrite.hpp"
+#include <algorithm>
+
+void RewriteEngine::add_rule(const std::string& name, SymbolicExpr::Type head, const std::vector<Shape>& shape,
+                             Action action, bool variadic) {
+    rules.push_back(std::make_unique<Rule>(Rule{name, std::move(action), rules.size()}));
+    Node* node = &roots[head];
+    for (const auto& s : shape) {
+        if (s.any) {
+            if (!node->wildcard) node->wildcard = std::make_unique<Node>();
+            node = node->wildcard.get();
+        } else {
+            auto& child = node->children[s.type];
+            if (!child) child = std::make_unique<Node>();
+            node = child.get();
+        }
+    }
+    (variadic ? node->variadic : node->exact).push_back(rules.back().get());
+}
+
+void RewriteEngine::add_rule_containing(const std::string& name, SymbolicExpr::Type head, SymbolicExpr::Type operand,
+                                        Action action) {
+    rules.push_back(std::make_unique<Rule>(Rule{name, std::move(action), rules.size()}));
+    roots[head];
+    containing[head][operand].push_back(rules.back().get());
+}
+
+void RewriteEngine::collect(const Node* node, const SymbolicExpr& expr, std::size_t depth,
+                            std::vector<const Rule*>& out) const {
+    out.insert(out.end(), node->variadic.begin(), node->variadic.end());
+    if (depth == expr.operands.size()) {
+        out.insert(out.end(), node->exact.begin(), node->exact.end());
+        return;
+    }
+    auto it = node->children.find(expr.operands[depth]->type);
+    if (it != node->children.end()) collect(it->second.get(), expr, depth + 1, out);
+    if (node->wildcard) collect(node->wildcard.get(), expr, depth + 1, out);
+}
+
+RewriteEngine::Expr RewriteEngine::rewrite(Expr expr, std::size_t& budget) const {
+    std::vector<const Rule*> candidates;
+    for (;;) {
+        // 已经是某次化简的结果（如规则内部调用了 simplify）时不必再改写；预算耗尽时保留当前形式，保证终止
+        if (expr->already_simplified || budget == 0) return expr;
+        auto root = roots.find(expr->type);
+        if (root == roots.end()) return expr;
+        candidates.clear();
+        collect(&root->second, *expr, 0, candidates);
+        if (auto held = containing.find(expr->type); held != containing.end()) {
+            // 先记下出现过的操作数类型，每条规则只检查一次
+            unsigned present = 0;
+            for (const auto& op : expr->operands) present |= 1u << static_cast<unsigned>(op->type);
+            for (const auto& [type, list] : held->second) {
+                if (present & (1u << static_cast<unsigned>(type))) candidates.insert(candidates.end(), list.begin(), list.end());
+            }
+        }
+        // 同一节点可能从多条路径匹配到规则，按注册顺序尝试
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Rule* a, const Rule* b) { return a->order < b->order; });
+
+        bool changed = false;
+        for (const Rule* rule : candidates) {
+            auto res = rule->action(expr);
+            if (!res) continue;
+            if (SymbolicExpr::structurally_equal(res, expr)) continue;
+            budget--;
+            expr = SymbolicExpr::intern(res);
+            changed = true;
+            break;
+        }
+        if (!changed) return expr;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "symbolic.hpp"
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 符号表达式的改写引擎
+// 规则按头部类型和操作数形状索引（判别树）：第一层为节点类型，其后每层对应一个操作数的类型，
+// 通配符单独成支。改写时只取出形状能匹配的规则，按注册顺序尝试
+// 乘法、加法的操作数按规范顺序排列，某类操作数不在固定位置，这类规则按“含有某类型操作数”索引
+
+class LAMINA_API RewriteEngine {
+public:
+    using Expr = std::shared_ptr<SymbolicExpr>;
+    // 规则不适用时返回 nullptr；结果继续参与改写，直到不动点或预算耗尽
+    using Action = std::function<Expr(const Expr&)>;
+
+    // 操作数形状：具体类型或通配
+    struct Shape {
+        bool any = true;
+        SymbolicExpr::Type type = SymbolicExpr::Type::Number;
+
+        static Shape of(SymbolicExpr::Type t) { return {false, t}; }
+        static Shape wildcard() { return {}; }
+    };
+
+    // 注册规则。variadic 为 false 时只匹配操作数个数与 shape 相同的节点，
+    // 为 true 时 shape 只约束前几个操作数
+    void add_rule(const std::string& name, SymbolicExpr::Type head, const std::vector<Shape>& shape,
+                  Action action, bool variadic = false);
+
+    // 注册只在节点含有 operand 类型的操作数（位置不限）时适用的规则
+    void add_rule_containing(const std::string& name, SymbolicExpr::Type head, SymbolicExpr::Type operand,
+                             Action action);
+
+    // 改写一个操作数已化简的节点；budget 为剩余可用的改写次数，按引用递减
+    Expr rewrite(Expr expr, std::size_t& budget) const;
+
+    std::size_t rule_count() const { return rules.size(); }
+
+private:
+    struct Rule {
+        std::string name;
+        Action action;
+        std::size_t order;
+    };
+
+    struct Node {
+        std::map<SymbolicExpr::Type, std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> wildcard;
+        std::vector<const Rule*> exact;    // 操作数个数恰好等于深度时匹配
+        std::vector<const Rule*> variadic; // 前缀匹配即可
+    };
+
+    void collect(const Node* node, const SymbolicExpr& expr, std::size_t depth, std::vector<const Rule*>& out) const;
+
+    std::vector<std::unique_ptr<Rule>> rules;
+    std::map<SymbolicExpr::Type, Node> roots;
+    // 头部类型 -> 操作数类型 -> 规则
+    std::map<SymbolicExpr::Type, std::map<SymbolicExpr::Type, std::vector<const Rule*>>> containing;
+};
@@ -0,0 +1,383 @@
+#include "squarefree.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 Wide;
+constexpr size_t WIDE_MAX_DIGITS = 38;// 10^38 < 2^127
+#else
+using Wide = std::uint64_t;
+constexpr size_t WIDE_MAX_DIGITS = 19;
+#endif
+
+// 编译期筛出的小素数，用于试除
+constexpr unsigned SIEVE_LIMIT = 1u << 15;
+
+constexpr std::array<bool, SIEVE_LIMIT> sieve() {
+    std::array<bool, SIEVE_LIMIT> composite{};
+    composite[0] = composite[1] = true;
+    for (unsigned i = 2; i * i < SIEVE_LIMIT; i++) {
+        if (composite[i]) continue;
+        for (unsigned j = i * i; j < SIEVE_LIMIT; j += i) composite[j] = true;
+    }
+    return composite;
+}
+
+constexpr size_t count_primes() {
+    auto composite = sieve();
+    size_t count = 0;
+    for (unsigned i = 0; i < SIEVE_LIMIT; i++) {
+        if (!composite[i]) count++;
+    }
+    return count;
+}
+
+constexpr auto SMALL_PRIMES = [] {
+    auto composite = sieve();
+    std::array<std::uint32_t, count_primes()> primes{};
+    size_t k = 0;
+    for (unsigned i = 0; i < SIEVE_LIMIT; i++) {
+        if (!composite[i]) primes[k++] = i;
+    }
+    return primes;
+}();
+
+// 试除后小于该值的余数必为 1 或素数
+constexpr Wide TRIAL_BOUND = static_cast<Wide>(SIEVE_LIMIT) * SIEVE_LIMIT;
+
+// Pollard rho 每个参数 c 的迭代上限，超出时放弃分解该部分
+constexpr size_t RHO_ITERATIONS = 1u << 18;
+
+Wide add_mod(Wide a, Wide b, Wide m) {
+    return a >= m - b ? a - (m - b) : a + b;
+}
+
+Wide mul_mod(Wide a, Wide b, Wide m) {
+#if defined(__SIZEOF_INT128__)
+    if (m <= UINT64_MAX) return a * b % m;
+#endif
+    // 倍加法，避免溢出
+    Wide r = 0;
+    a %= m;
+    while (b) {
+        if (b & 1) r = add_mod(r, a, m);
+        a = add_mod(a, a, m);
+        b >>= 1;
+    }
+    return r;
+}
+
+Wide pow_mod(Wide a, Wide e, Wide m) {
+    Wide r = 1 % m;
+    a %= m;
+    while (e) {
+        if (e & 1) r = mul_mod(r, a, m);
+        a = mul_mod(a, a, m);
+        e >>= 1;
+    }
+    return r;
+}
+
+Wide gcd_wide(Wide a, Wide b) {
+    while (b) {
+        Wide t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+Wide isqrt_wide(Wide n) {
+    if (n < 2) return n;
+    Wide x = static_cast<Wide>(std::sqrt(static_cast<long double>(n)));
+    if (x == 0) x = 1;
+    // 牛顿迭代修正浮点估计，再逐一调整到精确的下取整
+    for (;;) {
+        Wide y = (x + n / x) / 2;
+        if (y >= x) break;
+        x = y;
+    }
+    while (x * x > n) --x;
+    while ((x + 1) * (x + 1) <= n) ++x;
+    return x;
+}
+
+// 前 20 个素数作为底数：n < 3.3e24 时结论确定，更大时误判概率可忽略
+bool is_prime_wide(Wide n) {
+    if (n < 2) return false;
+    for (size_t i = 0; i < 20; i++) {
+        Wide p = SMALL_PRIMES[i];
+        if (n == p) return true;
+        if (n % p == 0) return false;
+    }
+    Wide d = n - 1;
+    unsigned s = 0;
+    while ((d & 1) == 0) {
+        d >>= 1;
+        s++;
+    }
+    for (size_t i = 0; i < 20; i++) {
+        Wide x = pow_mod(SMALL_PRIMES[i], d, n);
+        if (x == 1 || x == n - 1) continue;
+        bool witness = true;
+        for (unsigned r = 1; r < s && witness; r++) {
+            x = mul_mod(x, x, n);
+            if (x == n - 1) witness = false;
+        }
+        if (witness) return false;
+    }
+    return true;
+}
+
+// Brent 版 Pollard rho，返回 n 的一个非平凡因子；失败返回 0
+Wide pollard_rho(Wide n) {
+    auto diff = [](Wide a, Wide b) { return a > b ? a - b : b - a; };
+    for (Wide c = 1; c < 4; c++) {
+        auto f = [&](Wide x) { return add_mod(mul_mod(x, x, n), c, n); };
+        Wide y = 2, x = 2, ys = 2, q = 1, g = 1;
+        size_t r = 1, steps = 0;
+        const size_t batch = 128;
+        while (g == 1 && steps < RHO_ITERATIONS) {
+            x = y;
+            for (size_t i = 0; i < r; i++) y = f(y);
+            for (size_t k = 0; k < r && g == 1; k += batch) {
+                ys = y;
+                for (size_t i = 0; i < batch && i < r - k; i++) {
+                    y = f(y);
+                    q = mul_mod(q, diff(x, y), n);
+                }
+                g = gcd_wide(q, n);
+                steps += batch;
+            }
+            r *= 2;
+        }
+        if (g == n) {
+            // 批量乘积恰好为 0 时逐步回退
+            do {
+                ys = f(ys);
+                g = gcd_wide(diff(x, ys), n);
+            } while (g == 1);
+        }
+        if (g != 1 && g != n) return g;
+    }
+    return 0;
+}
+
+// 分解一个没有小素因子的数；无法分解的部分放入 leftover
+void factor_wide(Wide n, std::map<Wide, unsigned>& primes, std::vector<Wide>& leftover) {
+    if (n == 1) return;
+    if (n < TRIAL_BOUND || is_prime_wide(n)) {
+        primes[n]++;
+        return;
+    }
+    Wide r = isqrt_wide(n);
+    if (r * r == n) {
+        factor_wide(r, primes, leftover);
+        factor_wide(r, primes, leftover);
+        return;
+    }
+    Wide d = pollard_rho(n);
+    if (d == 0) {
+        leftover.push_back(n);
+        return;
+    }
+    factor_wide(d, primes, leftover);
+    factor_wide(n / d, primes, leftover);
+}
+
+void decompose_wide(Wide n, Wide& outside, Wide& inside) {
+    outside = inside = 1;
+    if (n == 0) {
+        outside = 0;
+        return;
+    }
+    for (std::uint32_t p : SMALL_PRIMES) {
+        if (static_cast<Wide>(p) * p > n) break;
+        unsigned e = 0;
+        while (n % p == 0) {
+            n /= p;
+            e++;
+        }
+        for (unsigned i = 0; i < e / 2; i++) outside *= p;
+        if (e & 1) inside *= p;
+    }
+    std::map<Wide, unsigned> primes;
+    std::vector<Wide> leftover;
+    factor_wide(n, primes, leftover);
+    for (const auto& [p, e] : primes) {
+        for (unsigned i = 0; i < e / 2; i++) outside *= p;
+        if (e & 1) inside *= p;
+    }
+    // 无法分解的部分保留在根号内，结果仍然正确，只是可能不是最简
+    for (Wide l : leftover) inside *= l;
+}
+
+bool to_wide(const ::BigInt& n, Wide& out) {
+    if (n.digits.size() > WIDE_MAX_DIGITS) return false;
+    out = 0;
+    for (size_t i = n.digits.size(); i-- > 0;) out = out * 10 + n.digits[i];
+#if defined(__SIZEOF_INT128__)
+    // 留出余量，保证 mul_mod 与 isqrt_wide 中不会溢出
+    if (out >> 125) return false;
+#endif
+    return true;
+}
+
+::BigInt from_wide(Wide w) {
+    if (w == 0) return ::BigInt(0);
+    std::string s;
+    while (w) {
+        s.push_back(static_cast<char>('0' + static_cast<int>(w % 10)));
+        w /= 10;
+    }
+    return ::BigInt(std::string(s.rbegin(), s.rend()));
+}
+
+// 以 1e9 为基的大数，高位在前，只用于小素数试除
+struct Limbs {
+    std::vector<std::uint32_t> v;
+
+    explicit Limbs(const ::BigInt& n) {
+        // digits 低位在前，从低位起每 9 位一组
+        for (size_t begin = 0; begin < n.digits.size(); begin += 9) {
+            size_t end = std::min(begin + 9, n.digits.size());
+            std::uint32_t limb = 0;
+            for (size_t i = end; i-- > begin;) limb = limb * 10 + n.digits[i];
+            v.insert(v.begin(), limb);
+        }
+    }
+
+    std::uint32_t mod(std::uint32_t p) const {
+        std::uint64_t r = 0;
+        for (auto limb : v) r = (r * 1000000000ull + limb) % p;
+        return static_cast<std::uint32_t>(r);
+    }
+
+    void divide(std::uint32_t p) {
+        std::uint64_t r = 0;
+        for (auto& limb : v) {
+            std::uint64_t cur = r * 1000000000ull + limb;
+            limb = static_cast<std::uint32_t>(cur / p);
+            r = cur % p;
+        }
+        while (v.size() > 1 && v.front() == 0) v.erase(v.begin());
+    }
+
+    ::BigInt to_bigint() const {
+        std::string s = std::to_string(v.front());
+        for (size_t i = 1; i < v.size(); i++) {
+            std::string part = std::to_string(v[i]);
+            s += std::string(9 - part.size(), '0') + part;
+        }
+        return ::BigInt(s);
+    }
+};
+
+SquareFreeParts decompose_big(const ::BigInt& n) {
+    Wide w;
+    if (to_wide(n, w)) {
+        Wide outside, inside;
+        decompose_wide(w, outside, inside);
+        return {from_wide(outside), from_wide(inside)};
+    }
+    // 先用小素数试除，剩余部分一旦能放进 Wide 就交给 Pollard rho
+    SquareFreeParts res{::BigInt(1), ::BigInt(1)};
+    Limbs rest(n);
+    for (std::uint32_t p : SMALL_PRIMES) {
+        unsigned e = 0;
+        while (rest.mod(p) == 0) {
+            rest.divide(p);
+            e++;
+        }
+        if (e >= 2) res.outside = res.outside * ::BigInt(static_cast<int>(p)).power(::BigInt(static_cast<int>(e / 2)));
+        if (e & 1) res.inside = res.inside * ::BigInt(static_cast<int>(p));
+        if (e && rest.v.size() * 9 <= WIDE_MAX_DIGITS) break;
+    }
+    ::BigInt cofactor = rest.to_bigint();
+    if (to_wide(cofactor, w)) {
+        Wide outside, inside;
+        decompose_wide(w, outside, inside);
+        res.outside = res.outside * from_wide(outside);
+        res.inside = res.inside * from_wide(inside);
+        return res;
+    }
+    // 过大的余数只判断是否为完全平方
+    ::BigInt root = cofactor.sqrt();
+    if (root * root == cofactor) {
+        res.outside = res.outside * root;
+    } else {
+        res.inside = res.inside * cofactor;
+    }
+    return res;
+}
+
+// 最近化简过的根式，LRU 淘汰
+class DecompositionCache {
+public:
+    bool lookup(const std::string& key, SquareFreeParts& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) return false;
+        entries.splice(entries.begin(), entries, it->second);
+        out = it->second->second;
+        return true;
+    }
+
+    void store(const std::string& key, const SquareFreeParts& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (index.count(key)) return;
+        entries.emplace_front(key, value);
+        index[key] = entries.begin();
+        if (entries.size() > CAPACITY) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+private:
+    static constexpr size_t CAPACITY = 256;
+    std::mutex mutex;
+    std::list<std::pair<std::string, SquareFreeParts>> entries;
+    std::unordered_map<std::string, std::list<std::pair<std::string, SquareFreeParts>>::iterator> index;
+};
+
+DecompositionCache& cache() {
+    static DecompositionCache instance;
+    return instance;
+}
+
+}// namespace
+
+SquareFreeParts square_free_decompose(const ::BigInt& n) {
+    if (n.negative && !n.is_zero()) throw std::runtime_error("Square root of negative number");
+    // 小数直接试除即可，不必查缓存
+    if (n.digits.size() <= 9) {
+        Wide outside, inside;
+        decompose_wide(static_cast<Wide>(n.to_int()), outside, inside);
+        return {from_wide(outside), from_wide(inside)};
+    }
+    std::string key = n.to_string();
+    SquareFreeParts res;
+    if (cache().lookup(key, res)) return res;
+    res = decompose_big(n);
+    cache().store(key, res);
+    return res;
+}
+
+std::pair<std::uint64_t, std::uint64_t> square_free_decompose(std::uint64_t n) {
+    if (n < TRIAL_BOUND) {
+        Wide outside, inside;
+        decompose_wide(n, outside, inside);
+        return {static_cast<std::uint64_t>(outside), static_cast<std::uint64_t>(inside)};
+    }
+    auto parts = square_free_decompose(::BigInt(std::to_string(n)));
+    return {std::stoull(parts.outside.to_string()), std::stoull(parts.inside.to_string())};
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "bigint.hpp"
+#include <cstdint>
+#include <utility>
+
+#ifndef LAMINA_API
+#ifdef _WIN32
+#ifdef LAMINA_CORE_EXPORTS
+#define LAMINA_API __declspec(dllexport)
+#else
+#define LAMINA_API __declspec(dllimport)
+#endif
+#else
+#define LAMINA_API
+#endif
+#endif
+
+// 平方因子分解：n = outside² × inside，inside 无平方因子
+// 先用编译期筛出的小素数试除，剩余部分用 Miller-Rabin + Pollard rho 分解
+// 最近的结果会被缓存，重复化简同一个根式时不再分解
+
+struct SquareFreeParts {
+    ::BigInt outside;// 提到根号外的部分
+    ::BigInt inside; // 留在根号内的部分
+};
+
+// n 须非负
+LAMINA_API SquareFreeParts square_free_decompose(const ::BigInt& n);
+
+// 64 位快速版本，返回 {outside, inside}
+LAMINA_API std::pair<std::uint64_t, std::uint64_t> square_free_decompose(std::uint64_t n);
@@ -1,149 +1,363 @@
 #include "symbolic.hpp"
+#include "polynomial.hpp"
+#include "rewrite.hpp"
+#include "squarefree.hpp"
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
+namespace {
+	// 驻留表：结构哈希 -> 弱引用，节点全部释放后自动失效
+	std::unordered_multimap<std::size_t, std::weak_ptr<SymbolicExpr>> intern_table;
+	std::mutex intern_mutex;
+	std::size_t intern_sweep_threshold = 1024;
+
+	inline std::size_t hash_mix(std::size_t seed, std::size_t v) {
+		return seed ^ (v + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+	}
+
+	std::size_t bigint_digits_hash(const ::BigInt& bi) {
+		std::size_t h = bi.negative ? 0x5bd1e995u : 0;
+		for (auto d : bi.digits) h = hash_mix(h, d);
+		return h;
+	}
+}
+
+std::pmr::memory_resource* SymbolicExpr::node_pool() {
+	// 不析构：全局 Value 中的表达式可能在静态析构阶段才释放
+	static auto* pool = new std::pmr::synchronized_pool_resource();
+	return pool;
+}
+
+std::size_t SymbolicExpr::structural_hash() const {
+	if (hash_cached) return hash_value;
+	std::size_t h = std::hash<int>()(static_cast<int>(type));
+	h = hash_mix(h, number_value.index());
+	if (std::holds_alternative<int>(number_value)) {
+		h = hash_mix(h, std::hash<int>()(std::get<int>(number_value)));
+	} else if (std::holds_alternative<::BigInt>(number_value)) {
+		h = hash_mix(h, bigint_digits_hash(std::get<::BigInt>(number_value)));
+	} else {
+		const auto& r = std::get<::Rational>(number_value);
+		h = hash_mix(h, bigint_digits_hash(r.get_numerator()));
+		h = hash_mix(h, bigint_digits_hash(r.get_denominator()));
+	}
+	if (!identifier.empty()) h = hash_mix(h, std::hash<std::string>()(identifier));
+	for (const auto& op : operands) h = hash_mix(h, op ? op->structural_hash() : 0);
+	hash_value = h;
+	hash_cached = true;
+	return h;
+}
+
+bool SymbolicExpr::structurally_equal(const std::shared_ptr<SymbolicExpr>& a, const std::shared_ptr<SymbolicExpr>& b) {
+	if (a == b) return true;
+	if (!a || !b) return false;
+	// 两个驻留节点不同，则结构一定不同
+	if (a->interned && b->interned) return false;
+	if (a->type != b->type || a->structural_hash() != b->structural_hash()) return false;
+	if (a->identifier != b->identifier || a->operands.size() != b->operands.size()) return false;
+	if (!(a->number_value == b->number_value)) return false;
+	for (std::size_t i = 0; i < a->operands.size(); i++) {
+		if (!structurally_equal(a->operands[i], b->operands[i])) return false;
+	}
+	return true;
+}
+
+std::shared_ptr<SymbolicExpr> SymbolicExpr::intern(std::shared_ptr<SymbolicExpr> expr) {
+	if (!expr || expr->interned) return expr;
+	// 子节点先驻留，这样比较时可以只比较指针
+	for (auto& op : expr->operands) op = intern(op);
+	expr->hash_cached = false;
+	std::size_t h = expr->structural_hash();
+
+	std::lock_guard<std::mutex> lock(intern_mutex);
+	auto range = intern_table.equal_range(h);
+	for (auto it = range.first; it != range.second;) {
+		auto existing = it->second.lock();
+		if (!existing) {
+			it = intern_table.erase(it);
+			continue;
+		}
+		if (structurally_equal(existing, expr)) return existing;
+		++it;
+	}
+	// 表过大时统一清理失效项
+	if (intern_table.size() >= intern_sweep_threshold) {
+		for (auto it = intern_table.begin(); it != intern_table.end();) {
+			if (it->second.expired()) it = intern_table.erase(it);
+			else ++it;
+		}
+		intern_sweep_threshold = std::max<std::size_t>(1024, intern_table.size() * 2);
+	}
+	expr->interned = true;
+	intern_table.emplace(h, expr);
+	return expr;
+}
+
+std::size_t SymbolicExpr::intern_table_size() {
+	std::lock_guard<std::mutex> lock(intern_mutex);
+	return intern_table.size();
+}
+
+
+namespace {
+	// 驻留节点的化简缓存、编译缓存可能被多个线程同时读写
+	std::mutex simplify_cache_mutex;
+	std::mutex program_cache_mutex;
+
+	// 一次 simplify 调用链的状态：最外层调用创建，嵌套调用共享，不同线程互不影响
+	struct SimplifyState {
+		int depth = 0;
+		std::size_t budget = 1 << 16;	// 改写规则的总次数上限
+	};
+	thread_local SimplifyState* active_simplify = nullptr;
+	constexpr int max_simplify_level = 30;
+
+	// root 的子树中是否含有 target 节点；共享的子节点只访问一次
+	bool contains_node(const SymbolicExpr* root, const SymbolicExpr* target) {
+		std::unordered_set<const SymbolicExpr*> seen;
+		std::vector<const SymbolicExpr*> stack{root};
+		while (!stack.empty()) {
+			const SymbolicExpr* e = stack.back();
+			stack.pop_back();
+			if (e == target) return true;
+			if (!seen.insert(e).second) continue;
+			for (const auto& op : e->operands) {
+				if (op) stack.push_back(op.get());
+			}
+		}
+		return false;
+	}
+}
 
 // 符号表达式的化简实现
 std::shared_ptr<SymbolicExpr> SymbolicExpr::simplify() const {
-	// 添加“化简”标记，避免 simplify 重复调用导致效率降低（似乎暂时不可用？）
-	//if (already_simplified) return std::make_shared<SymbolicExpr>(*this);
+	// 添加“化简”标记，避免 simplify 重复调用导致效率降低
+	// 只有驻留节点才会被标记或缓存，复制出的节点可能被修改，不能信任
+	if (interned) {
+		if (already_simplified) {
+			if (auto self = std::const_pointer_cast<SymbolicExpr>(weak_from_this().lock())) return self;
+		}
+		std::lock_guard<std::mutex> lock(simplify_cache_mutex);
+		if (simplified_cache) return simplified_cache;
+	}
 	
-	static int current_simplify_level = 0;
-	const int max_simplify_level = 30;
-	if (current_simplify_level > max_simplify_level) {
+	SimplifyState local;
+	const bool outermost = active_simplify == nullptr;
+	if (outermost) active_simplify = &local;
+	// 异常（如负数开方）穿出时也要恢复状态
+	struct Leave {
+		bool outermost;
+		~Leave() {
+			active_simplify->depth--;
+			if (outermost) active_simplify = nullptr;
+		}
+	} leave{outermost};
+	if (++active_simplify->depth > max_simplify_level) {
 		// 不用 err_stream
 		std::cerr << "[Warning] SymbolicExpr: reaching maximum simplifying depth\n";
 	}
-	current_simplify_level++;
-	
-    auto intcall = [&]() {
-		switch (type) {
-			case Type::Number:
-			case Type::Variable:
-				return std::make_shared<SymbolicExpr>(*this);
-				
-			case Type::Sqrt:
-				return simplify_sqrt();
-				
-			case Type::Multiply:
-				return simplify_multiply();
-				
-			case Type::Add:
-				return simplify_add();
-
-			case Type::Power:
-				return simplify_power();
-			
-			default:
-				return std::make_shared<SymbolicExpr>(*this);
-		}
-	};
 	
-	auto res = intcall();
-	current_simplify_level--;
+	// 结果驻留后再标记：同结构的表达式共享化简结果，再次化简时直接返回自身
+	auto res = intern(simplify_step());
 	res->already_simplified = true;
+	if (interned && res.get() != this && !contains_node(res.get(), this)) {
+		std::lock_guard<std::mutex> lock(simplify_cache_mutex);
+		simplified_cache = res;
+	}
 	return res;
 }
 
-std::shared_ptr<SymbolicExpr> SymbolicExpr::simplify_sqrt() const {
-    if (operands.empty()) return std::make_shared<SymbolicExpr>(*this);
-    
-    auto simplified_operand = operands[0]->simplify();
-	if (simplified_operand->type == SymbolicExpr::Type::Infinity) return simplified_operand;
-    
-    if (simplified_operand->is_number()) {
-		
-		auto scvrs = simplified_operand->convert_rational();
-		
-		if (simplified_operand->is_rational() && scvrs.get_denominator() == ::BigInt(1)) {
-			
-			// TODO: Debug output:
-			err_stream << "[Debug output] x/1 simplifier\n";
-			
-			::BigInt actual = scvrs.get_numerator();
-			simplified_operand->number_value = actual;
+// 单次化简：自底向上，先化简操作数，再交给改写规则
+std::shared_ptr<SymbolicExpr> SymbolicExpr::simplify_step() const {
+	switch (type) {
+		case Type::Sqrt:
+		case Type::Multiply:
+		case Type::Add:
+		case Type::Power: {
+			// 注意不能对新节点再调用 simplify：原有的化简规则并不幂等（如 π^2 会展开为 π*π）
+			auto node = SymbolicExpr::make_node(*this);
+			for (auto& op : node->operands) op = op->simplify();
+			return rewrite_engine().rewrite(intern(node), active_simplify->budget);
 		}
 		
-		// pair 格式：first 为系数，second 为根式下的值
-		// 注意自行判断 second 为 1 的情况。
-		auto num_process = [](int n) -> std::pair<int, int> {
-			if (n < 0) throw std::runtime_error("Square root of negative number");
-			if (n == 0 || n == 1) return std::make_pair(n, 1);
-			int sqrt_n = static_cast<int>(std::sqrt(n));
-            if (sqrt_n * sqrt_n == n) return std::make_pair(sqrt_n, 1);
-            int factor = 1, remaining = n;
-            for (int i = 2; i * i <= remaining; ++i) {
-                while (remaining % (i * i) == 0) {
-                    factor *= i;
-                    remaining /= (i * i);
-                }
-            }
-            return std::make_pair(factor, remaining);
-		};
+		default:
+			return SymbolicExpr::make_node(*this);
+	}
+}
+
+const RewriteEngine& SymbolicExpr::rewrite_engine() {
+	static const RewriteEngine engine = [] {
+		using Shape = RewriteEngine::Shape;
+		using Expr = std::shared_ptr<SymbolicExpr>;
+		RewriteEngine e;
+		const Shape any = Shape::wildcard();
+		const Shape num = Shape::of(Type::Number);
+		const Shape inf = Shape::of(Type::Infinity);
 		
-		auto in_simplify_range = [](const ::BigInt& bi) -> bool {
-			return bi <= BigInt(INT_MAX) && bi >= BigInt(INT_MIN);
+		auto value_is = [](const Expr& x, int v) {
+			return x->is_number() && x->convert_rational() == ::Rational(v);
 		};
-		
-		auto generate_component = [](const ::Rational& rat) -> std::shared_ptr<SymbolicExpr> {
-			if (rat.get_denominator() == ::BigInt(1)) return SymbolicExpr::number(rat.get_numerator());
-			else return SymbolicExpr::number(rat);
+		// 两个 int 的运算结果超出 int 时用 BigInt
+		auto from_long = [](long long v) -> Expr {
+			if (v >= INT_MIN && v <= INT_MAX) return SymbolicExpr::number(static_cast<int>(v));
+			return SymbolicExpr::number(::BigInt(std::to_string(v)));
 		};
 		
-        auto num_val = simplified_operand->get_number();
-        if (std::holds_alternative<int>(num_val)) {
-			// TODO: Debug output:
-			//err_stream << "[Debug output] numeric simplifier\n";
-            int n = std::get<int>(num_val);
-			auto res = num_process(n);
-			if (res.second == 1) return SymbolicExpr::number(res.first);
-			else if (res.first == 1) return SymbolicExpr::sqrt(SymbolicExpr::number(res.second));
-			else return SymbolicExpr::multiply(SymbolicExpr::number(res.first), SymbolicExpr::sqrt(SymbolicExpr::number(res.second)));
-        }
-        if (std::holds_alternative<::BigInt>(num_val)) {
-            const auto& bi = std::get<::BigInt>(num_val);
-            if (bi.negative) throw std::runtime_error("Square root of negative number");
-            if (bi.is_zero() || bi == BigInt(1)) return SymbolicExpr::number(bi);
-			//err_stream << "[Debug output] bigint simplifier init\n";
-            if (bi.is_perfect_square()) return SymbolicExpr::number(bi.sqrt());
-			// TODO: Debug output:
-			//err_stream << "[Debug output] bigint simplifier\n";
-            // TODO: 这个等BigInt效率高点再说，或者换个算法
-            /*BigInt factor(1), remaining(bi);
-            for (BigInt i(2); i * i <= remaining; i = i + BigInt(1)) {
-                while ((remaining % (i * i)).is_zero()) {
-                    factor = factor * i;
-                    remaining = remaining / (i * i);
-                }
-            }
-            if (factor > BigInt(1)) {
-                if (remaining == BigInt(1)) return SymbolicExpr::number(factor);
-                else return SymbolicExpr::multiply(SymbolicExpr::number(factor), SymbolicExpr::sqrt(SymbolicExpr::number(remaining)));
-            }*/
-            // 暂时只判断可以转成int的
-            if (in_simplify_range(bi)) {
-                return SymbolicExpr::sqrt(SymbolicExpr::number(bi.to_int()))->simplify();
-            }
-        }
-		// 分数化简中底数和指数分别判断
-		if (std::holds_alternative<::Rational>(num_val)) {
-			const auto &nobj = std::get<::Rational>(num_val);
-			const auto &nume = nobj.get_numerator();
-			const auto &deme = nobj.get_denominator();
-			// 暂时只判断可以转成int的
-			if (in_simplify_range(nume) && in_simplify_range(deme)) {
-				auto numsimp = num_process(nume.to_int());
-				auto demsimp = num_process(deme.to_int());
-				::Rational numarea = ::Rational(numsimp.first, demsimp.first);
-				::Rational sqarea = ::Rational(numsimp.second, demsimp.second);
-				
-				// TODO: Debug output:
-				err_stream << "[Debug output] numa = " << numarea.to_string() << "; sqa = " << sqarea.to_string() << std::endl;
-				
-				if (sqarea == ::Rational(1)) return SymbolicExpr::number(numarea);
-				else if (numarea == ::Rational(1)) return SymbolicExpr::sqrt(SymbolicExpr::number(sqarea));
-				return SymbolicExpr::multiply(generate_component(numarea), SymbolicExpr::sqrt(generate_component(sqarea)));
-			}
-		}
+		// 乘法：数字因子在最前（构造函数保证），先合并数字，再处理 0、1 和无穷，
+		// 然后依次是展开嵌套乘法、多项式约分、分配律，最后合并同底数的幂并排序
+		e.add_rule("mul-numbers", Type::Multiply, {num, num}, [from_long](const Expr& x) -> Expr {
+			const auto& l = x->operands[0];
+			const auto& r = x->operands[1];
+			Expr product = l->is_int() && r->is_int()
+				? from_long(static_cast<long long>(l->get_int()) * r->get_int())
+				: SymbolicExpr::exact_number(l->convert_rational() * r->convert_rational());
+			if (x->operands.size() == 2) return product;
+			std::vector<Expr> factors{product};
+			factors.insert(factors.end(), x->operands.begin() + 2, x->operands.end());
+			return SymbolicExpr::multiply(factors);
+		}, true);
+		e.add_rule("mul-zero", Type::Multiply, {num}, [value_is](const Expr& x) -> Expr {
+			return value_is(x->operands[0], 0) ? x->operands[0] : nullptr;
+		}, true);
+		e.add_rule("mul-one", Type::Multiply, {num}, [value_is](const Expr& x) -> Expr {
+			if (!value_is(x->operands[0], 1)) return nullptr;
+			return SymbolicExpr::multiply(std::vector<Expr>(x->operands.begin() + 1, x->operands.end()));
+		}, true);
+		e.add_rule_containing("mul-infinity", Type::Multiply, Type::Infinity, [](const Expr& x) -> Expr {
+			for (const auto& op : x->operands) if (op->type == Type::Infinity) return op;
+			return nullptr;
+		});
+		e.add_rule_containing("mul-flatten", Type::Multiply, Type::Multiply,
+			[](const Expr& x) { return x->multiply_flatten(); });
+		// 除法表示为 (多项式)^-1 因子
+		e.add_rule_containing("mul-divide", Type::Multiply, Type::Power,
+			[](const Expr& x) { return x->multiply_divide(); });
+		e.add_rule_containing("mul-expand", Type::Multiply, Type::Add,
+			[](const Expr& x) { return x->multiply_expand(); });
+		// 合并同底数的幂、根式并排序：任意两个因子都可能同底，只能扫描整个节点，
+		// 因此排在最后，其他规则都不适用时才执行；结果与原节点结构相等即到达不动点
+		e.add_rule("mul-collect", Type::Multiply, {}, [](const Expr& x) { return x->multiply_collect(); }, true);
+		
+		// 加法
+		e.add_rule_containing("add-infinity", Type::Add, Type::Infinity, [](const Expr& x) -> Expr {
+			for (const auto& op : x->operands) if (op->type == Type::Infinity) return op;
+			return nullptr;
+		});
+		e.add_rule("add-numbers", Type::Add, {num, num}, [](const Expr& x) -> Expr {
+			const auto& l = x->operands[0];
+			const auto& r = x->operands[1];
+			// 与整体加法化简一致，结果用分数表示
+			return SymbolicExpr::number(l->convert_rational() + r->convert_rational());
+		});
+		e.add_rule_containing("add-flatten", Type::Add, Type::Add, [](const Expr& x) { return x->add_flatten(); });
+		// 合并同类项并排序：同类项可能是任意两项，只能扫描整个节点，排在最后
+		e.add_rule("add-collect", Type::Add, {}, [](const Expr& x) { return x->add_collect(); }, true);
+		
+		// 幂：顺序与原先的判断一致，0^0 视为 1
+		e.add_rule("pow-zero-exponent", Type::Power, {any, num}, [value_is](const Expr& x) -> Expr {
+			return value_is(x->operands[1], 0) ? SymbolicExpr::number(1) : nullptr;
+		});
+		e.add_rule("pow-zero-base", Type::Power, {num, any}, [value_is](const Expr& x) -> Expr {
+			return value_is(x->operands[0], 0) ? SymbolicExpr::number(0) : nullptr;
+		});
+		e.add_rule("pow-one-exponent", Type::Power, {any, num}, [value_is](const Expr& x) -> Expr {
+			return value_is(x->operands[1], 1) ? x->operands[0] : nullptr;
+		});
+		e.add_rule("pow-one-base", Type::Power, {num, any}, [value_is](const Expr& x) -> Expr {
+			return value_is(x->operands[0], 1) ? x->operands[0] : nullptr;
+		});
+		e.add_rule("pow-infinity", Type::Power, {inf, any}, [](const Expr& x) { return x->operands[0]; });
+		e.add_rule("pow-infinity", Type::Power, {any, inf}, [](const Expr& x) { return x->operands[1]; });
+		e.add_rule("pow-number", Type::Power, {num, num}, [](const Expr& x) { return x->power_of_number(); });
+		e.add_rule("pow-root", Type::Power, {num, num}, [](const Expr& x) { return x->root_of_number(); });
+		e.add_rule("pow-nested", Type::Power, {Shape::of(Type::Power), any},
+			[](const Expr& x) { return x->power_of_power(); });
+		e.add_rule("pow-nested", Type::Power, {Shape::of(Type::Sqrt), any},
+			[](const Expr& x) { return x->power_of_power(); });
+		e.add_rule("pow-rationalize", Type::Power, {Shape::of(Type::Add), num},
+			[](const Expr& x) { return x->power_rationalize(); });
+		e.add_rule("pow-reciprocal", Type::Power, {any, num}, [](const Expr& x) { return x->power_reciprocal(); });
+		e.add_rule("pow-expand", Type::Power, {Shape::of(Type::Add), num},
+			[](const Expr& x) { return x->power_expand(); });
+		e.add_rule("pow-expand", Type::Power, {Shape::of(Type::Multiply), num},
+			[](const Expr& x) { return x->power_expand(); });
+		
+		// 平方根
+		e.add_rule("sqrt-infinity", Type::Sqrt, {inf}, [](const Expr& x) { return x->operands[0]; });
+		e.add_rule("sqrt-number", Type::Sqrt, {num}, [](const Expr& x) { return x->sqrt_number(); });
+		e.add_rule("sqrt-square", Type::Sqrt, {Shape::of(Type::Multiply)},
+			[](const Expr& x) { return x->sqrt_square(); });
+		e.add_rule("sqrt-square", Type::Sqrt, {Shape::of(Type::Power)},
+			[](const Expr& x) { return x->sqrt_square(); });
+		return e;
+	}();
+	return engine;
+}
+
+// 数字的平方根：分子、分母分别分解出平方因子
+std::shared_ptr<SymbolicExpr> SymbolicExpr::sqrt_number() const {
+    auto simplified_operand = operands[0];
+    if (!simplified_operand->is_number()) return nullptr;
+	
+	auto scvrs = simplified_operand->convert_rational();
+	
+	if (simplified_operand->is_rational() && scvrs.get_denominator() == ::BigInt(1)) {
+		
+		// TODO: Debug output:
+		err_stream << "[Debug output] x/1 simplifier\n";
+		
+		::BigInt actual = scvrs.get_numerator();
+		simplified_operand = SymbolicExpr::number(actual);
+	}
+	
+	auto in_simplify_range = [](const ::BigInt& bi) -> bool {
+		return bi <= BigInt(INT_MAX) && bi >= BigInt(INT_MIN);
+	};
+	
+	// 能放进 int 的整数仍用 int 表示，与其余化简规则保持一致
+	auto generate_component = [in_simplify_range](const ::Rational& rat) -> std::shared_ptr<SymbolicExpr> {
+		if (rat.get_denominator() != ::BigInt(1)) return SymbolicExpr::number(rat);
+		const auto& n = rat.get_numerator();
+		if (in_simplify_range(n)) return SymbolicExpr::number(n.to_int());
+		return SymbolicExpr::number(n);
+	};
+	
+	// outside × √inside
+	auto generate_sqrt = [generate_component](const ::Rational& outside, const ::Rational& inside) -> std::shared_ptr<SymbolicExpr> {
+		if (inside == ::Rational(1)) return generate_component(outside);
+		auto root = SymbolicExpr::sqrt(generate_component(inside));
+		if (outside == ::Rational(1)) return root;
+		return SymbolicExpr::multiply(generate_component(outside), root);
+	};
+	
+    auto num_val = simplified_operand->get_number();
+    if (std::holds_alternative<int>(num_val) || std::holds_alternative<::BigInt>(num_val)) {
+        ::BigInt n = std::holds_alternative<int>(num_val) ? ::BigInt(std::get<int>(num_val)) : std::get<::BigInt>(num_val);
+        if (n.negative && !n.is_zero()) throw std::runtime_error("Square root of negative number");
+        auto parts = square_free_decompose(n);
+        return generate_sqrt(::Rational(parts.outside), ::Rational(parts.inside));
     }
+	// 分数化简中分子和分母分别分解
+	if (std::holds_alternative<::Rational>(num_val)) {
+		const auto &nobj = std::get<::Rational>(num_val);
+		if (nobj < ::Rational(0)) throw std::runtime_error("Square root of negative number");
+		auto numsimp = square_free_decompose(nobj.get_numerator());
+		auto demsimp = square_free_decompose(nobj.get_denominator());
+		::Rational numarea = ::Rational(numsimp.outside, demsimp.outside);
+		::Rational sqarea = ::Rational(numsimp.inside, demsimp.inside);
+		
+		// TODO: Debug output:
+		err_stream << "[Debug output] numa = " << numarea.to_string() << "; sqa = " << sqarea.to_string() << std::endl;
+		
+		return generate_sqrt(numarea, sqarea);
+	}
+    return nullptr;
+}
+
+// 平方的平方根：sqrt(x*x)、sqrt(x^2) 等
+std::shared_ptr<SymbolicExpr> SymbolicExpr::sqrt_square() const {
+    const auto& simplified_operand = operands[0];
 	err_stream << "[Debug output] end numeric sqrt simplifier\n";
     // sqrt(x*x) 或 sqrt(π*π) 直接返回 x 或 π
     if (simplified_operand->type == SymbolicExpr::Type::Multiply && simplified_operand->operands.size() == 2) {
@@ -214,1132 +428,1082 @@ std::shared_ptr<SymbolicExpr> SymbolicExpr::simplify_sqrt() const {
             }
         }
     }
-    return SymbolicExpr::sqrt(simplified_operand);
+    return nullptr;
 }
 
-std::shared_ptr<SymbolicExpr> SymbolicExpr::simplify_multiply() const {
-    if (operands.size() != 2) return std::make_shared<SymbolicExpr>(*this);
-    
-    auto left = operands[0]->simplify();
-    auto right = operands[1]->simplify();
-	
-	// TODO: 理论上为未定式
-	if (left->type == SymbolicExpr::Type::Number && left->convert_rational() == ::Rational(0)) return left;
-	if (right->type == SymbolicExpr::Type::Number && right->convert_rational() == ::Rational(0)) return right;
-	
-	if (left->type == SymbolicExpr::Type::Infinity) return left;
-	if (right->type == SymbolicExpr::Type::Infinity) return right;
-	
-	// TODO: Debug output:
-	err_stream << "[Debug output] Init: Processing l:" << left->to_string() << ", r:" << right->to_string() << std::endl;
-	
-	// TODO: 1 或 -1 乘以某个内容，直接返回另一边
-	// TODO: 加快运算速度，数字和 Multiply 相乘时，直接处理 Multiply 内的数字，不进入指数环节
-	auto has_no_multiply_effect = [](const std::shared_ptr<SymbolicExpr>& obj) -> bool {
-		return (obj->is_number() && obj->convert_rational() == ::Rational(1));
-	};
-	if (has_no_multiply_effect(left)) {
-		err_stream << "[Debug output] left has no effect\n";
-		return right;
+namespace {
+	using ExprPtr = std::shared_ptr<SymbolicExpr>;
+
+	// 类型在规范顺序中的位置：数字最前，无穷最后
+	int type_rank(SymbolicExpr::Type t) {
+		switch (t) {
+			case SymbolicExpr::Type::Number: return 0;
+			case SymbolicExpr::Type::Sqrt: return 1;
+			case SymbolicExpr::Type::Variable: return 2;
+			case SymbolicExpr::Type::Power: return 3;
+			case SymbolicExpr::Type::Multiply: return 4;
+			case SymbolicExpr::Type::Add: return 5;
+			case SymbolicExpr::Type::Infinity: return 7;
+			default: return 6;
+		}
 	}
-	if (has_no_multiply_effect(right)) {
-		err_stream << "[Debug output] right has no effect\n";
-		return left;
+
+	// π、e 排在其他变量之前
+	int variable_rank(const std::string& id) {
+		if (id == "π" || id == "pi") return 0;
+		if (id == "e") return 1;
+		return 2;
 	}
-	
-    // 如果两个操作数都是数字，直接相乘
-    if (left->is_number() && right->is_number()) {
-		err_stream << "[Debug output] numeric calling in multiplier: ";
-        auto left_num = left->get_number();
-        auto right_num = right->get_number();
-        
-        if (std::holds_alternative<int>(left_num) && std::holds_alternative<int>(right_num)) {
-            int result = std::get<int>(left_num) * std::get<int>(right_num);
-			err_stream << result << std::endl;
-            return SymbolicExpr::number(result);
-        } else {
-			::Rational result = left->convert_rational() * right->convert_rational();
-			err_stream << result.to_string() << std::endl;
-			return SymbolicExpr::number(result);
+
+	// 项 = 数字系数 × 其余部分
+	void split_coefficient(const ExprPtr& term, ::Rational& k, ExprPtr& rest) {
+		k = ::Rational(1);
+		if (term->type != SymbolicExpr::Type::Multiply) {
+			rest = term;
+			return;
 		}
-    }
-	
-	if (right->is_number())
-		std::swap(left, right);	// 尽可能保证左侧操作数为 number
-	
-	// 如果右侧只有 variable，认为化简完成
-	// TODO: 确定如果有 power 项目，要不要同样判断
-	/*
-	std::function<bool(std::shared_ptr<SymbolicExpr>,bool)> check_simp_1;
-	check_simp_1 = [&check_simp_1](std::shared_ptr<SymbolicExpr> obj, bool allow_num) -> bool {
-		return (obj->type == SymbolicExpr::Type::Number && allow_num) || obj->type == SymbolicExpr::Type::Variable || (
-			(obj->type == SymbolicExpr::Type::Multiply || obj->type == SymbolicExpr::Type::Power) && check_simp_1(obj->operands[0], allow_num) && check_simp_1(obj->operands[1], true)
-			) || (
-			obj->type == SymbolicExpr::Type::Sqrt && check_simp_1(obj->operands[0], allow_num)
-			);
-	};
-	if (check_simp_1(right, false)) return std::make_shared<SymbolicExpr>(*this);	// 已经化简完成
-	*/
-	
-	// 加法运算特殊化简
-	if ((left->type == SymbolicExpr::Type::Add) || (right->type == SymbolicExpr::Type::Add)) {
-		
-		auto res = SymbolicExpr::number(0);
-		// TODO: *** 此处可能导致 res 被反复化简
-		
-		if ((left->type == SymbolicExpr::Type::Add) && (right->type == SymbolicExpr::Type::Add)) {
-			for (auto &i : left->operands) {
-				for (auto &j : right->operands) {
-					auto adt = SymbolicExpr::multiply(i, j)->simplify();
-					err_stream << "[Debug output] [1] --- Adding term: " << adt->to_string() << std::endl;
-					res = SymbolicExpr::add(res, adt);
-				}
-			}
+		std::vector<ExprPtr> factors;
+		for (const auto& op : term->operands) {
+			if (op->is_number()) k = k * op->convert_rational();
+			else factors.push_back(op);
+		}
+		rest = SymbolicExpr::multiply(factors);
+	}
+
+	// k × rest，嵌套乘法展平；rest 中的因子已按规范顺序排列
+	ExprPtr scaled(const ::Rational& k, const ExprPtr& rest) {
+		if (k == ::Rational(1)) return rest;
+		std::vector<ExprPtr> factors{SymbolicExpr::exact_number(k)};
+		if (rest->type == SymbolicExpr::Type::Multiply) {
+			factors.insert(factors.end(), rest->operands.begin(), rest->operands.end());
 		} else {
-			if (left->type != SymbolicExpr::Type::Add)
-				std::swap(left, right);
-			
-			for (auto &i : left->operands) {
-				auto adt = SymbolicExpr::multiply(i, right)->simplify();
-				err_stream << "[Debug output] [2] --- Adding term: " << adt->to_string() << std::endl;
-				res = SymbolicExpr::add(res, adt);
-			}
+			factors.push_back(rest);
 		}
+		return SymbolicExpr::multiply(factors);
+	}
 
-		err_stream << "[Debug output] === Begin adder simplifier ===\n";
-		return res->simplify();
-		
+	// 总次数：数字因子与数字的根式不计，指数不是数字的幂按 1 计
+	::Rational term_degree(const ExprPtr& rest) {
+		auto factor_degree = [](const ExprPtr& f) -> ::Rational {
+			if (f->is_number()) return ::Rational(0);
+			if (f->type == SymbolicExpr::Type::Sqrt && f->operands[0]->is_number()) return ::Rational(0);
+			if (f->type == SymbolicExpr::Type::Power && f->operands[1]->is_number()) return f->operands[1]->convert_rational();
+			return ::Rational(1);
+		};
+		if (rest->type != SymbolicExpr::Type::Multiply) return factor_degree(rest);
+		::Rational d(0);
+		for (const auto& op : rest->operands) d = d + factor_degree(op);
+		return d;
 	}
-	
-	// 注意，multiply 不属于这类类型，需要手动化简
-	auto is_power_compatible = [](const std::shared_ptr<SymbolicExpr>& expr) -> bool {
-		return expr->type == SymbolicExpr::Type::Number || expr->type == SymbolicExpr::Type::Sqrt
-			|| expr->type == SymbolicExpr::Type::Power || expr->type == SymbolicExpr::Type::Variable;
-	};
-	
-	// 注意，除法使用指数
-	std::function<std::shared_ptr<SymbolicExpr>(const std::shared_ptr<SymbolicExpr>&)> power_compatible;
-	power_compatible = [&](const std::shared_ptr<SymbolicExpr>& expr) -> std::shared_ptr<SymbolicExpr> {
-		std::shared_ptr<SymbolicExpr> ret;
-		if (expr->type == SymbolicExpr::Type::Number || expr->type == SymbolicExpr::Type::Variable) {
-			return SymbolicExpr::power(expr, SymbolicExpr::number(1));
-		} else if (expr->type == SymbolicExpr::Type::Sqrt) {
-			ret = SymbolicExpr::power(power_compatible(expr->operands[0])->simplify(), SymbolicExpr::number(::Rational(1, 2)));
-		} else if (expr->type == SymbolicExpr::Type::Power) {
-			auto pcp = power_compatible(expr->operands[1]);
-			ret = SymbolicExpr::power(power_compatible(expr->operands[0]), pcp)->simplify();
-		} else {
-			return expr;
+
+	// 按结构把键分组：结构哈希只用来缩小范围，最终由 structurally_equal 判断
+	class StructuralIndex {
+	public:
+		// 返回 key 所在组的下标，新键分配下一个下标
+		size_t find_or_add(const ExprPtr& key) {
+			auto range = index.equal_range(key->structural_hash());
+			for (auto it = range.first; it != range.second; ++it) {
+				if (SymbolicExpr::structurally_equal(keys[it->second], key)) return it->second;
+			}
+			index.emplace(key->structural_hash(), keys.size());
+			keys.push_back(key);
+			return keys.size() - 1;
 		}
-		if (ret->type == SymbolicExpr::Type::Number || ret->type == SymbolicExpr::Type::Variable)
-			ret = SymbolicExpr::power(ret, SymbolicExpr::number(1));
-		if (ret->type == SymbolicExpr::Type::Sqrt)
-			ret = SymbolicExpr::power(ret->operands[0], SymbolicExpr::number(::Rational(1, 2)));
-		return ret;
+		size_t size() const { return keys.size(); }
+		const ExprPtr& key(size_t i) const { return keys[i]; }
+	private:
+		std::vector<ExprPtr> keys;
+		std::unordered_multimap<std::size_t, size_t> index;
 	};
-	
-	auto is_compounded_sqrt = [](const std::shared_ptr<SymbolicExpr>& expr) -> bool {
-		if (expr->type == SymbolicExpr::Type::Multiply) {
-			if (expr->operands.size() >= 2 && (expr->operands[0]->type == SymbolicExpr::Type::Number)
-				&& (expr->operands[1]->type == SymbolicExpr::Type::Sqrt)) return true;
+}
+
+int SymbolicExpr::compare(const std::shared_ptr<SymbolicExpr>& a, const std::shared_ptr<SymbolicExpr>& b) {
+	if (a == b) return 0;
+	const bool a_pow = a->type == Type::Power, b_pow = b->type == Type::Power;
+	// 幂与非幂比较时把非幂项看作 x^1：先比底数再比指数，同底的 x、x^2 相邻
+	if ((a_pow || b_pow) && !a->is_number() && !b->is_number()
+		&& a->type != Type::Infinity && b->type != Type::Infinity) {
+		if (int c = compare(a_pow ? a->operands[0] : a, b_pow ? b->operands[0] : b)) return c;
+		const auto one = number(1);
+		if (int c = compare(a_pow ? a->operands[1] : one, b_pow ? b->operands[1] : one)) return c;
+		return a_pow == b_pow ? 0 : (a_pow ? 1 : -1);
+	}
+	const int ra = type_rank(a->type), rb = type_rank(b->type);
+	if (ra != rb) return ra < rb ? -1 : 1;
+	switch (a->type) {
+		case Type::Number: {
+			const ::Rational x = a->convert_rational(), y = b->convert_rational();
+			if (x == y) return 0;
+			return x < y ? -1 : 1;
 		}
-		return false;
-	};
-	
-	auto is_for_auxiliary = [is_compounded_sqrt](const std::shared_ptr<SymbolicExpr> &obj) -> bool {
-		// 判断是否可用于 sqrt_and_auxiliary，如果不可用，直接尝试 flatten multiply
-		return (obj->type == SymbolicExpr::Type::Number) || (obj->type == SymbolicExpr::Type::Sqrt)
-			|| is_compounded_sqrt(obj);
+		case Type::Infinity: {
+			const int x = std::get<int>(a->number_value), y = std::get<int>(b->number_value);
+			return x == y ? 0 : (x < y ? -1 : 1);
+		}
+		case Type::Variable: {
+			const int va = variable_rank(a->identifier), vb = variable_rank(b->identifier);
+			if (va != vb) return va < vb ? -1 : 1;
+			return a->identifier.compare(b->identifier) < 0 ? -1 : (a->identifier == b->identifier ? 0 : 1);
+		}
+		default:
+			break;
+	}
+	const size_t n = std::min(a->operands.size(), b->operands.size());
+	for (size_t i = 0; i < n; i++) {
+		if (int c = compare(a->operands[i], b->operands[i])) return c;
+	}
+	if (a->operands.size() != b->operands.size()) return a->operands.size() < b->operands.size() ? -1 : 1;
+	return 0;
+}
+
+void SymbolicExpr::sort_factors(std::vector<std::shared_ptr<SymbolicExpr>>& factors) {
+	std::stable_sort(factors.begin(), factors.end(),
+		[](const std::shared_ptr<SymbolicExpr>& a, const std::shared_ptr<SymbolicExpr>& b) { return compare(a, b) < 0; });
+}
+
+void SymbolicExpr::sort_terms(std::vector<std::shared_ptr<SymbolicExpr>>& terms) {
+	// 每项的 (底数, 指数) 列表按底数升序排列，数字的根式不参与比较
+	struct Keyed {
+		ExprPtr term, rest;
+		::Rational degree;
+		std::vector<std::pair<ExprPtr, ExprPtr>> powers;
 	};
-	
-	// 考虑：和指数类型乘法合并/简化
-	auto sqrt_and_auxiliary = [is_power_compatible, power_compatible, is_compounded_sqrt, is_for_auxiliary]
-		(const std::shared_ptr<SymbolicExpr> &obj, bool no_simplify = false) -> std::shared_ptr<SymbolicExpr> {
-		
-		// TODO: Debug output:
-		err_stream << "[Debug output] Starting sqrt-and-aux process" << std::endl;
-		
-		// 此处可以考虑优化
-		auto left = no_simplify ? obj->operands[0] : obj->operands[0]->simplify();
-		auto right = no_simplify ? obj->operands[1] : obj->operands[1]->simplify();
-		
-		// TODO: Debug output:
-		err_stream << "[Debug output] Processing l:" << left->to_string() << ", r:" << right->to_string() << std::endl;
-		
-		if (is_for_auxiliary(left) && is_for_auxiliary(right)) {
-			// 根式相乘的一般处理
-			if (left->type == SymbolicExpr::Type::Sqrt || is_compounded_sqrt(left)
-				|| right->type == SymbolicExpr::Type::Sqrt || is_compounded_sqrt(right)) {
-				
-				if ((!is_compounded_sqrt(left)) && (!is_compounded_sqrt(right))) {
-					
-					if (right->type == SymbolicExpr::Type::Sqrt)
-						std::swap(left, right);
-					
-					// TODO: Debug output:
-					err_stream << "[Debug output] [4] Starting sqrt-and-aux process" << std::endl;
-					
-					bool negative = false;
-					if (left->type == SymbolicExpr::Type::Number && left->convert_rational() < ::Rational(0, 1))
-						negative = !negative;
-					if (right->type == SymbolicExpr::Type::Number && right->convert_rational() < ::Rational(0, 1))
-						negative = !negative;
-					
-					std::shared_ptr<SymbolicExpr> sresult = SymbolicExpr::multiply(
-						(left->type == SymbolicExpr::Type::Number) ? (SymbolicExpr::multiply(left, left))
-																	: left->operands[0],
-						(right->type == SymbolicExpr::Type::Number) ? (SymbolicExpr::multiply(right, right))
-																	: right->operands[0]);
-					
-					auto res = SymbolicExpr::sqrt(sresult)->simplify();
-					
-					if (negative) {
-						// 终端化到最简，否则难以处理
-						if (res->type == SymbolicExpr::Type::Multiply)
-							return SymbolicExpr::multiply(SymbolicExpr::multiply(SymbolicExpr::number(-1), res->operands[0])->simplify(), res->operands[1]);
-						else
-							return SymbolicExpr::multiply(SymbolicExpr::number(-1), res);
-						
-					} else {
-						return res;
-					}
-					
-				} else {
-					
-					// 把右侧加入到左侧
-					if (!is_compounded_sqrt(left))
-						std::swap(left, right);
-					
-					// TODO: Debug output:
-					err_stream << "[Debug output] [5] Starting sqrt-and-aux process" << std::endl;
-					
-					bool negative = false;
-					
-					auto res = std::make_shared<SymbolicExpr>(*left);
-					auto simplify_res = [&]() {
-						if (is_compounded_sqrt(res->operands[1])) {
-							res->operands[0] = SymbolicExpr::multiply(res->operands[0], res->operands[1]->operands[0])->simplify();
-							res->operands[1] = res->operands[1]->operands[1];		// 不用再 sqrt
-						}
-						res->simplify();
-					};
-					
-					if (right->type == SymbolicExpr::Type::Number) {
-						err_stream << "[Debug output] [5a] res: " << res->to_string() << std::endl;
-						res->operands[0] = SymbolicExpr::multiply(res->operands[0], right)->simplify();
-					} else if (right->type == SymbolicExpr::Type::Sqrt) {
-						err_stream << "[Debug output] [5b] res: " << res->to_string() << std::endl;
-						res->operands[1] = SymbolicExpr::multiply(res->operands[1], right)->simplify();
-						simplify_res();
-					} else if (is_compounded_sqrt(right)) {
-						err_stream << "[Debug output] [5c] res: " << res->to_string() << std::endl;
-						res->operands[0] = SymbolicExpr::multiply(res->operands[0], right->operands[0])->simplify();
-						res->operands[1] = SymbolicExpr::multiply(res->operands[1], right->operands[1])->simplify();
-						simplify_res();
-					}
-					
-					if (negative) {
-						err_stream << "[Debug output] [5] Negative processor. res: " << res->to_string() << std::endl;
-						if (res->type == SymbolicExpr::Type::Multiply) {
-							// 这个需要化简
-							res->operands[0] = SymbolicExpr::multiply(SymbolicExpr::number(-1), res->operands[0])->simplify();
-						} else {
-							// 不要再化简
-							res = SymbolicExpr::multiply(SymbolicExpr::number(-1), res);
-						}
-					}
-					//err_stream << "[Debug output] [5] Finalize. res: " << res->to_string() << std::endl;
-					return res;
-					
-				}
-				
+	std::vector<Keyed> keyed;
+	keyed.reserve(terms.size());
+	for (const auto& t : terms) {
+		Keyed k{t, nullptr, ::Rational(-1), {}};
+		if (!t->is_number()) {
+			::Rational c;
+			split_coefficient(t, c, k.rest);
+			k.degree = term_degree(k.rest);
+			auto add_power = [&k](const ExprPtr& f) {
+				if (f->type == Type::Sqrt && f->operands[0]->is_number()) return;
+				if (f->type == Type::Power) k.powers.emplace_back(f->operands[0], f->operands[1]);
+				else k.powers.emplace_back(f, SymbolicExpr::number(1));
+			};
+			if (k.rest->type == Type::Multiply) {
+				for (const auto& f : k.rest->operands) add_power(f);
+			} else {
+				add_power(k.rest);
 			}
 		}
-		
-		// 回退到保留乘法
-		return SymbolicExpr::multiply(left, right);
-	};
+		keyed.push_back(std::move(k));
+	}
+	// 次数降序；同次数时按字典序：先出现较前的底数或同底数指数较大的项在前
+	std::stable_sort(keyed.begin(), keyed.end(), [](const Keyed& a, const Keyed& b) {
+		const bool an = a.term->is_number(), bn = b.term->is_number();
+		if (an != bn) return bn;
+		if (an) return false;
+		if (!(a.degree == b.degree)) return b.degree < a.degree;
+		const size_t n = std::min(a.powers.size(), b.powers.size());
+		for (size_t i = 0; i < n; i++) {
+			if (int c = compare(a.powers[i].first, b.powers[i].first)) return c < 0;
+			if (int c = compare(a.powers[i].second, b.powers[i].second)) return c > 0;
+		}
+		if (a.powers.size() != b.powers.size()) return a.powers.size() > b.powers.size();
+		if (int c = compare(a.rest, b.rest)) return c < 0;
+		return compare(a.term, b.term) < 0;
+	});
+	for (size_t i = 0; i < terms.size(); i++) terms[i] = keyed[i].term;
+}
 
-	
-	// 指数类型相乘的处理（可能考虑合并相同指数项）
-	if ((left->type == SymbolicExpr::Type::Power || right->type == SymbolicExpr::Type::Power
-		|| (left->type == right->type && left->type == SymbolicExpr::Type::Variable))
-		|| (!is_for_auxiliary(left)) || (!is_for_auxiliary(right))) {
-
-		if (is_power_compatible(left) && is_power_compatible(right)) {
-			if (left->type != SymbolicExpr::Type::Power)
-				std::swap(left, right);
-			
-			auto lcom = left;
-			if (left->type != SymbolicExpr::Type::Power)
-				lcom = power_compatible(left);
-			
-			auto rcom = power_compatible(right);
-			
-			// TODO: 提升为成员函数，判断相等
-			std::function<bool(std::shared_ptr<SymbolicExpr>,std::shared_ptr<SymbolicExpr>)> is_power_equiv;
-			is_power_equiv = [&](std::shared_ptr<SymbolicExpr> a, std::shared_ptr<SymbolicExpr> b) -> bool {
-				if (a->type != b->type) 
-					return false;
-				if (a->type == SymbolicExpr::Type::Number)
-					return a->convert_rational() == b->convert_rational();
-				else if (a->type == SymbolicExpr::Type::Sqrt)
-					return is_power_equiv(a->operands[0], b->operands[0]);
-				else if (a->type == SymbolicExpr::Type::Variable)
-					return a->identifier == b->identifier;
-				else
-					return false;
-			};
-			
-			// TODO: Debug output:
-			err_stream << "[Debug output] [1] preparing to merge exponents" << std::endl;
-			
-			// TODO: 这边可能还需要测试
-			if (lcom->operands[1]->is_number() && rcom->operands[1]->is_number()) {
-				
-				auto lcr = lcom->operands[1]->convert_rational();
-				auto rcr = rcom->operands[1]->convert_rational();
-				
-				auto ldr = lcr.get_denominator();
-				auto rdr = rcr.get_denominator();
-				
-				if (is_power_equiv(lcom->operands[0], rcom->operands[0])) {
-					// TODO: Debug output:
-					err_stream << "[Debug output] [1] Merging bases" << std::endl;
-					return SymbolicExpr::power(lcom->operands[0], SymbolicExpr::add(lcom->operands[1], rcom->operands[1]))->simplify();
-				}
-				
-				if (ldr == rdr) {
-					if (lcr == rcr) {
-						// TODO: Debug output:
-						err_stream << "[Debug output] [1a] Merging exponents in a simplified way" << std::endl;
-						
-						if (lcom->operands[0]->type == SymbolicExpr::Type::Variable || rcom->operands[0]->type == SymbolicExpr::Type::Variable) {
-							// !!! TODO: 这里好像是万恶之源
-							err_stream << "[Debug output] [1a] Entering special reservation\n";
-							auto mt = SymbolicExpr::multiply(lcom->operands[0]->simplify(), rcom->operands[0]->simplify());
-							if (lcr == ::Rational(1)) return mt;
-							else return SymbolicExpr::power(mt, SymbolicExpr::number(lcr)); // 不要化简整体！
-						} else {
-							err_stream << "[Debug output] [1a] No variable, normalizing\n";
-							auto tmp = SymbolicExpr::power(SymbolicExpr::multiply(lcom->operands[0], rcom->operands[0]),
-								SymbolicExpr::number(lcr));
-							return tmp->simplify();
-						}
-					} else if (ldr == ::BigInt(1)) {
-						// 没有分母（特殊处理，避免死循环）；此处，底数、指数均不能合并。
-						// 此处不应再对整体进行 multiply 的化简调用。
-						// 留给以后实现。
-						// TODO: Debug output:
-						err_stream << "[Debug output] [1b] Give up merging" << std::endl;
-					} else {
-						// 注意这里的 multiply 不化简（power 的处理要跟上）
-						// TODO: Debug output:
-						err_stream << "[Debug output] [1c] Merging exponents" << std::endl;
-						auto new_base = SymbolicExpr::multiply(
-								SymbolicExpr::power(lcom->operands[0], SymbolicExpr::number(lcr.get_numerator())),
-								SymbolicExpr::power(rcom->operands[0], SymbolicExpr::number(rcr.get_numerator())));
-						// 进行简化处理，同时避免死循环
-						// 执行外部的 simplify 时内部的是不必要的
-						new_base = new_base->simplify(); // new_base = sqrt_and_auxiliary(new_base, true);
-						return SymbolicExpr::power(new_base, SymbolicExpr::number(::Rational(::BigInt(1), lcr.get_denominator())))->simplify();
-					}
-				}
+namespace {
+	// 乘法节点拆成 数字系数 与 其余因子
+	void split_factors(const SymbolicExpr& x, ::Rational& coeff, std::vector<ExprPtr>& rest) {
+		coeff = ::Rational(1);
+		for (const auto& f : x.operands) {
+			if (f->is_number()) coeff = coeff * f->convert_rational();
+			else rest.push_back(f);
+		}
+	}
+}
+
+// 展开嵌套乘法：操作数已化简，只需展开一层
+std::shared_ptr<SymbolicExpr> SymbolicExpr::multiply_flatten() const {
+	if (std::none_of(operands.begin(), operands.end(), [](const ExprPtr& op) { return op->type == Type::Multiply; }))
+		return nullptr;
+	std::vector<ExprPtr> factors;
+	for (const auto& op : operands) {
+		if (op->type == Type::Multiply) factors.insert(factors.end(), op->operands.begin(), op->operands.end());
+		else factors.push_back(op);
+	}
+	return SymbolicExpr::multiply(factors);
+}
+
+std::shared_ptr<SymbolicExpr> SymbolicExpr::multiply_divide() const {
+	::Rational coeff;
+	std::vector<ExprPtr> rest;
+	split_factors(*this, coeff, rest);
+	// 多项式除法：分子能被 (多项式)^-1 整除时直接给出商
+	for (size_t i = 0; i < rest.size(); i++) {
+		const auto& f = rest[i];
+		if (f->type != Type::Power || f->operands[0]->type != Type::Add || !f->operands[1]->is_number()
+			|| !(f->operands[1]->convert_rational() == ::Rational(-1))) continue;
+		// 分子整体交给 from_symbolic，乘积的规模受其限制
+		std::vector<ExprPtr> numerator_factors{SymbolicExpr::exact_number(coeff)};
+		for (size_t j = 0; j < rest.size(); j++) {
+			if (j != i) numerator_factors.push_back(rest[j]);
+		}
+		Polynomial numerator, denominator;
+		if (!Polynomial::from_symbolic(f->operands[0], denominator)
+			|| !Polynomial::from_symbolic(SymbolicExpr::multiply(numerator_factors), numerator)) continue;
+		auto [quotient, remainder] = numerator.divide(denominator);
+		if (remainder.is_zero()) return quotient.to_symbolic();
+	}
+	return nullptr;
+}
+
+std::shared_ptr<SymbolicExpr> SymbolicExpr::multiply_expand() const {
+	::Rational coeff;
+	std::vector<ExprPtr> rest;
+	split_factors(*this, coeff, rest);
+	// 含加法因子：都是多项式时直接相乘，否则把第一个加法因子分配到其余因子上
+	auto sum_it = std::find_if(rest.begin(), rest.end(), [](const ExprPtr& f) { return f->type == Type::Add; });
+	if (sum_it == rest.end()) return nullptr;
+	std::vector<ExprPtr> all{SymbolicExpr::exact_number(coeff)};
+	all.insert(all.end(), rest.begin(), rest.end());
+	Polynomial product;
+	if (Polynomial::from_symbolic(SymbolicExpr::multiply(all), product)) return product.to_symbolic();
+
+	const ExprPtr sum = *sum_it;
+	rest.erase(sum_it);
+	std::vector<ExprPtr> others{SymbolicExpr::exact_number(coeff)};
+	others.insert(others.end(), rest.begin(), rest.end());
+	const ExprPtr other = SymbolicExpr::multiply(others);
+	std::vector<ExprPtr> terms;
+	terms.reserve(sum->operands.size());
+	for (const auto& t : sum->operands) terms.push_back(SymbolicExpr::multiply(t, other)->simplify());
+	return SymbolicExpr::add(terms)->simplify();
+}
+
+std::shared_ptr<SymbolicExpr> SymbolicExpr::multiply_collect() const {
+	::Rational coeff;
+	std::vector<ExprPtr> rest;
+	split_factors(*this, coeff, rest);
+	if (coeff == ::Rational(0)) return SymbolicExpr::number(0);
+	if (rest.empty()) return SymbolicExpr::exact_number(coeff);
+
+	// 同底数的幂合并指数：底数按结构相等归组，√x 看作 x^(1/2)
+	StructuralIndex bases;
+	std::vector<ExprPtr> exponents;
+	for (const auto& f : rest) {
+		ExprPtr base = f, exponent = SymbolicExpr::number(1);
+		if (f->type == Type::Power) {
+			base = f->operands[0];
+			exponent = f->operands[1];
+		} else if (f->type == Type::Sqrt) {
+			base = f->operands[0];
+			exponent = SymbolicExpr::number(::Rational(1, 2));
+		}
+		const size_t g = bases.find_or_add(base);
+		if (g == exponents.size()) {
+			exponents.push_back(exponent);
+		} else if (exponents[g]->is_number() && exponent->is_number()) {
+			exponents[g] = SymbolicExpr::exact_number(exponents[g]->convert_rational() + exponent->convert_rational());
+		} else {
+			exponents[g] = SymbolicExpr::add(exponents[g], exponent)->simplify();
+		}
+	}
+
+	// 数字底数：指数相同的根式合并底数（√2·√3 = √6），化简后的数字并入系数
+	std::map<::Rational, ::Rational> radicals;	// 指数 -> 底数之积
+	std::vector<ExprPtr> result;
+	auto absorb = [&](const ExprPtr& f) {
+		if (f->is_number()) {
+			coeff = coeff * f->convert_rational();
+		} else if (f->type == Type::Multiply) {
+			for (const auto& op : f->operands) {
+				if (op->is_number()) coeff = coeff * op->convert_rational();
+				else result.push_back(op);
 			}
-			
-			// TODO: Debug output:
-			err_stream << "[Debug output] End of power-compatible process" << std::endl;
-			
 		} else {
-			
-			// 开始尝试 flatten
-			std::function<bool(const std::shared_ptr<SymbolicExpr>&, std::shared_ptr<SymbolicExpr>)> flatten_multiply;
-			// 暂时只支持有理指数化简
-			// 键为底数的值，值为指数的值
-			// TODO: 这样可能需要额外判断双层根号问题，以及分母有理化问题
-			std::map<::Rational, ::Rational> base_ref;
-			std::map<SymbolicExpr::HashData::HashType, std::shared_ptr<SymbolicExpr> > base_special;
-			std::map<SymbolicExpr::HashData::HashType, std::shared_ptr<SymbolicExpr> > base_special_ref;
-			std::shared_ptr<SymbolicExpr> split_special_base = SymbolicExpr::number(1);	// 还是不要空指针为好
-			std::map<::Rational, std::shared_ptr<SymbolicExpr>> exponent_ref;
-			std::vector<std::shared_ptr<SymbolicExpr>> result;
-			flatten_multiply = [&](const std::shared_ptr<SymbolicExpr>& expr, std::shared_ptr<SymbolicExpr> pre_timing) -> bool {
-				if (expr->type == SymbolicExpr::Type::Multiply) {
-					for (auto &i : expr->operands) {
-						if (!flatten_multiply(i, pre_timing)) return false;
-					}
-					return true;
-				} else if (is_power_compatible(expr)) {
-					auto current = power_compatible(expr);
-					if (!has_no_multiply_effect(pre_timing))	// 略微加快速度
-						current->operands[1] = SymbolicExpr::multiply(current->operands[1], pre_timing)->simplify();
-					if (current->operands[0]->type == SymbolicExpr::Type::Multiply) {
-						for (auto &i : current->operands[0]->operands) {
-							if (!flatten_multiply(i, current->operands[1])) return false;
-						}
-					} else {
-						// TODO: Debug output:
-						err_stream << "Converting " << expr->to_string() << " to " << current->to_string() << std::endl;
-						result.push_back(current);
-						return true;
-					}
-				}
-				return false;
-			};
-			// 这样传递可能有性能问题
-			// TODO: Debug output:
-			err_stream << "[Debug output] [2] Begin flat operation" << std::endl;
-			bool able = flatten_multiply(std::make_shared<SymbolicExpr>(*this), SymbolicExpr::number(1));
-			// TODO: Debug output:
-			err_stream << "[Debug output] [2] End flat operation with " << able << std::endl;
-			if (able) {
-				// 尝试合并指数
-				bool exponent_merger = true, base_merger = true;
-				err_stream << "[Debug output] [2] Preloading" << std::endl;
-				for (auto &cvt : result) {
-					if (cvt->is_number()) continue;
-					if (cvt->operands.size() < 2) {
-						err_stream << "[Debug output] [2] WARNING: Format error at " << cvt->to_string() << std::endl;
-						continue;
-					}
-					if (!cvt->operands[0]->is_number()) {
-						// 底数不是 number，TODO: 上哈希（仅对非 number 项上哈希！！）
-						// TODO: Debug output:
-						err_stream << "[Debug output] [2] Flat: exponent fails at " << cvt->operands[0]->to_string() << std::endl;
-						err_stream << "[Debug output] [2] Flat: (of " << cvt->to_string() << ")\n";
-						//exponent_merger = false;
-					}
-					if (!cvt->operands[1]->is_number()) {
-						// 指数不是 number，真没办法
-						// TODO: Debug output:
-						err_stream << "[Debug output] [2] Flat: fails at " << cvt->operands[1]->to_string() << std::endl;
-						err_stream << "[Debug output] [2] Flat: (of " << cvt->to_string() << ")\n";
-						base_merger = false;
-						exponent_merger = false;
-					}
-				}
-				
-				int exponent_merger_cnt = 0, base_merger_cnt = 0;
-				
-				if (exponent_merger) {
-					err_stream << "[Debug output] [2m] Ready for exp merger" << std::endl;
-					// 同底数合并
-					for (auto &cvt : result) {
-						if (!(cvt->operands[0]->is_number() && cvt->operands[1]->is_number())) {
-							auto hd = SymbolicExpr::HashData(cvt->operands[0]);
-							auto hds = hd.hash;
-							auto hdo = hd.hash_obj;
-							auto exps = cvt->operands[1];
-							// 如果指数是有理数，根号之类的东西分离出来 -- 理论上不应该用
-							if (!cvt->operands[1]->is_number()) {
-								hds = hd.to_single_hash();
-								hdo = cvt->operands[0];
-								exps = SymbolicExpr::number(1);
-							} else {
-								if (split_special_base == nullptr) split_special_base = SymbolicExpr::number(1);
-								split_special_base = SymbolicExpr::multiply(split_special_base, SymbolicExpr::power(hd.get_combined_k(), exps));
-							}
-							if (base_special.count(hd.hash)) {
-								base_special[hd.hash] = SymbolicExpr::add(base_special[hd.hash], exps);
-							} else {
-								base_special[hd.hash] = exps;
-							}
-							base_special_ref[hds] = cvt->operands[0];
-							exponent_merger_cnt++;	// 只算一半权重
-							continue;
-						}
-						::Rational base = cvt->operands[0]->convert_rational();
-						::Rational exponent = cvt->operands[1]->convert_rational();
-						auto finder = base_ref.find(base);
-						if (finder != base_ref.end()) {
-							finder->second = finder->second + exponent;
-							exponent_merger_cnt += 2;
-						} else {
-							base_ref[base] = exponent;
-						}
-					}
-				}
-				
-				if (base_merger) {
-					err_stream << "[Debug output] [2n] Ready for base merger" << std::endl;
-					// 同指数合并
-					for (auto &cvt : result) {
-						auto cvt_rational = cvt->operands[1]->convert_rational();
-						auto finder = exponent_ref.find(cvt_rational);
-						if (finder != exponent_ref.end()) {
-							// 问题是这里会导致继续循环调用
-							finder->second = SymbolicExpr::multiply(finder->second, cvt->operands[0]);
-							// 为 1 不允许继续合并，否则死循环
-							if (cvt_rational != ::Rational(1)) {
-								finder->second = finder->second->simplify();
-								base_merger_cnt++;
-							}
-							base_merger_cnt++;
-						} else {
-							exponent_ref[cvt_rational] = cvt->operands[0];
-						}
-						if (cvt_rational == ::Rational(0)) exponent_ref[cvt_rational] = SymbolicExpr::number(1);
-					}
-				}
-				
-				if (exponent_merger && (exponent_merger_cnt >= base_merger_cnt)) {
-					// 由于只允许两项乘法，此处需要递归构造
-					// 为了后续处理方便，现在构造成 数值*后续表达式 的形式，如果要提升性能可以改二叉树
-					auto res = SymbolicExpr::number(1);
-					bool inits = true;
-					for (auto &i : base_ref) {
-						if (i.first == ::Rational(0)) return SymbolicExpr::number(0);
-						if (i.second == ::Rational(0)) continue;
-						if (i.first == ::Rational(1)) continue;
-						// TODO: Debug output:
-						err_stream << "[Debug output] [2] exponent referring (" << i.first.to_string() << ")^(" << i.second.to_string() << ")\n";
-						auto cres = SymbolicExpr::power(SymbolicExpr::number(i.first), SymbolicExpr::number(i.second))->simplify();
-						if (cres->is_number() && cres->convert_rational() == ::Rational(1)) continue;
-						if (inits) {
-							res = cres;
-							inits = false;
-						}
-						else res = SymbolicExpr::multiply(cres, res);
-					}
-					for (auto &i : base_special) {
-						if (i.second->is_number()) {
-							if (i.second->convert_rational() == ::Rational(0)) continue;
-							if (i.second->convert_rational() == ::Rational(1)) {
-								res = inits ? base_special_ref[i.first] : SymbolicExpr::multiply(res, base_special_ref[i.first]);
-								inits = false;
-								continue;
-							}
-						}
-						// TODO: Debug output:
-						err_stream << "[Debug output] [2] extra exponent referring (" << base_special_ref[i.first]->to_string() << ")^(" << i.second->to_string() << ")\n";
-						res = inits ? SymbolicExpr::power(base_special_ref[i.first], i.second) 
-								: SymbolicExpr::multiply(res, SymbolicExpr::power(base_special_ref[i.first], i.second->simplify()));
-					}
-					return res;
-				} else if (base_merger && (base_merger_cnt >= exponent_merger_cnt)) {
-					auto res = SymbolicExpr::number(1);
-					bool inits = true;
-					
-					// TODO: Debug output:
-					err_stream << "[Debug output] [2] base merging\n";
-					
-					for (auto &i : exponent_ref) {
-						// 不要化简
-						
-						// TODO: Debug output:
-						err_stream << "[Debug output] [2] base merging: {" << i.second->to_string() << "}^(" << i.first.to_string() << ")\n";
-						
-						if (i.first == ::Rational(0)) continue;
-						std::shared_ptr<SymbolicExpr> cres;
-						if (i.first == ::Rational(1)) cres = i.second;
-						else cres = SymbolicExpr::power(i.second, SymbolicExpr::number(i.first))->simplify();
-						if (inits) {
-							res = cres;
-							inits = false;
-						}
-						else res = SymbolicExpr::multiply(cres, res);
-					}
-					return res;
-				} else {
-					// 至少把数值（数字和根号）化简到一起
-					err_stream << "[Debug output] fallback to alternative simplifier\n";
-					::Rational number_collection = ::Rational(1);
-					std::shared_ptr<SymbolicExpr> large_numbers = nullptr;
-					std::shared_ptr<SymbolicExpr> sqrt_collection = SymbolicExpr::number(1);
-					std::shared_ptr<SymbolicExpr> auxiliary = nullptr;
-					for (auto &i : result) {
-						err_stream << "[Debug output] dealing with " << i->to_string() << std::endl;
-						switch (i->type) {
-							case SymbolicExpr::Type::Number:
-								number_collection = number_collection * i->convert_rational();
-								break;
-							case SymbolicExpr::Type::Sqrt:
-								sqrt_collection = SymbolicExpr::multiply(sqrt_collection, i);
-								break;
-							case SymbolicExpr::Type::Power:
-								if (i->operands[1]->is_number()) {
-									bool failed = true;
-									::Rational eval_res;
-									auto icrt = i->operands[1]->convert_rational();
-									auto inum = icrt.get_numerator();
-									auto idem = icrt.get_denominator();
-									if (idem == ::BigInt(1)) {
-										switch (i->operands[0]->type) {
-											case SymbolicExpr::Type::Number:
-												// 尝试计算
-												eval_res = i->operands[0]->convert_rational().power(inum);
-												number_collection = number_collection * eval_res;
-												failed = false;
-												break;
-											case SymbolicExpr::Type::Sqrt:
-												// 理论上不应该这样，先不处理
-												err_stream << "[Debug output] unreachable sqrt processor!\n";
-											default:
-												break;
-										}
-									} else if (idem == ::BigInt(2)) {
-										// 按根号处理
-										sqrt_collection = SymbolicExpr::multiply(sqrt_collection, SymbolicExpr::power(i->operands[0], SymbolicExpr::number(inum)));
-										failed = false;
-									}
-									if (!failed) break;
-								}
-								// 这里没有 break，是故意的
-							default:
-								if (auxiliary == nullptr) auxiliary = i;
-								else auxiliary = SymbolicExpr::multiply(auxiliary, i);
-						}
-					}
-					sqrt_collection = SymbolicExpr::sqrt(sqrt_collection)->simplify();
-					err_stream << "[Debug output] end of Sqrt-collection simplifier\n";
-					err_stream << "[Debug output] number collection: " << number_collection.to_string() << std::endl;
-					err_stream << "[Debug output] sqrt collection: " << sqrt_collection->to_string() << std::endl;
-					err_stream << "[Debug output] large number: " << (large_numbers != nullptr ? large_numbers->to_string() : std::string("null")) << std::endl;
-					
-					auto lalt = (number_collection == ::Rational(1)) ? large_numbers
-							: (
-								large_numbers == nullptr ? SymbolicExpr::number(number_collection)
-								: SymbolicExpr::multiply(SymbolicExpr::number(number_collection), large_numbers)
-							);
-					std::shared_ptr<SymbolicExpr> ralt;
-					
-					if (sqrt_collection->is_number()) {
-						number_collection = number_collection * sqrt_collection->convert_rational();
-						ralt = auxiliary;
-					} else {
-						ralt = SymbolicExpr::multiply(sqrt_collection, auxiliary);
-					}
-					err_stream << "[Debug output] determined: &lalt = " << (unsigned long long)(lalt != nullptr) << "; &ralt = " << (unsigned long long)(ralt != nullptr) << std::endl;
-					err_stream << "[Debug output] lalt = " << (lalt == nullptr ? std::string("null") : lalt->to_string()) << "; ralt = " << (ralt == nullptr ? std::string("null") : ralt->to_string()) << std::endl;
-					if (lalt == nullptr && ralt == nullptr) return SymbolicExpr::number(1);
-					else if (lalt == nullptr) return ralt;
-					else if (ralt == nullptr) return lalt;
-					else return SymbolicExpr::multiply(lalt, ralt);
-					// TODO: 考虑是否允许向后化简
-				}
-				
-				
+			result.push_back(f);
+		}
+	};
+	for (size_t g = 0; g < bases.size(); g++) {
+		const auto& base = bases.key(g);
+		const auto& exponent = exponents[g];
+		if (exponent->is_number() && exponent->convert_rational() == ::Rational(0)) continue;
+		if (base->is_number() && exponent->is_number()) {
+			const ::Rational e = exponent->convert_rational();
+			if (e.is_integer()) {
+				absorb(SymbolicExpr::power(base, exponent)->simplify());
+				continue;
 			}
-			// 否则无法化简，保留原表达式
+			auto it = radicals.find(e);
+			if (it == radicals.end()) radicals.emplace(e, base->convert_rational());
+			else it->second = it->second * base->convert_rational();
+			continue;
+		}
+		if (exponent->is_number() && exponent->convert_rational() == ::Rational(1)) {
+			result.push_back(base);
+		} else if (exponent->is_number() && exponent->convert_rational() == ::Rational(1, 2)) {
+			result.push_back(SymbolicExpr::sqrt(base));
+		} else if (base->type == Type::Add || base->type == Type::Multiply) {
+			absorb(SymbolicExpr::power(base, exponent)->simplify());
+		} else {
+			result.push_back(SymbolicExpr::power(base, exponent));
 		}
-		
-		// 到此处：未能化简，（以后这里可能引入欧拉公式等等）
-		// TODO: 考虑是否需要配合分母有理化（很可能不用）
-		
+	}
+	for (const auto& [e, b] : radicals) {
+		absorb(SymbolicExpr::power(SymbolicExpr::exact_number(b), SymbolicExpr::exact_number(e))->simplify());
 	}
 
-	return sqrt_and_auxiliary(std::make_shared<SymbolicExpr>(*this), true);
+	if (coeff == ::Rational(0)) return SymbolicExpr::number(0);
+	// 重建的因子展开为加法时重新分配
+	if (std::any_of(result.begin(), result.end(), [](const ExprPtr& f) { return f->type == Type::Add; })) {
+		result.push_back(SymbolicExpr::exact_number(coeff));
+		return SymbolicExpr::multiply(result)->simplify();
+	}
+	if (result.empty()) return SymbolicExpr::exact_number(coeff);
+	SymbolicExpr::sort_factors(result);
+	return scaled(coeff, SymbolicExpr::multiply(result));
 }
 
-std::shared_ptr<SymbolicExpr> SymbolicExpr::simplify_add() const {
-    if (operands.size() != 2) return std::make_shared<SymbolicExpr>(*this);
+// 展开嵌套加法：操作数已化简，只需展开一层
+std::shared_ptr<SymbolicExpr> SymbolicExpr::add_flatten() const {
+	if (std::none_of(operands.begin(), operands.end(), [](const ExprPtr& op) { return op->type == Type::Add; }))
+		return nullptr;
+	std::vector<ExprPtr> terms;
+	for (const auto& op : operands) {
+		if (op->type == Type::Add) terms.insert(terms.end(), op->operands.begin(), op->operands.end());
+		else terms.push_back(op);
+	}
+	return SymbolicExpr::add(terms);
+}
 
-    auto left = operands[0]->simplify();
-    auto right = operands[1]->simplify();
-	
-	if (left->type == SymbolicExpr::Type::Infinity) return left;
-	if (right->type == SymbolicExpr::Type::Infinity) return right;
-
-    // 解析根号
-	// 如果为根号，其中 coeff 为根式的系数，radicand 为根号下的值
-	std::function<bool(const std::shared_ptr<SymbolicExpr>&,::Rational&,::Rational&)> extract_sqrt;
-    extract_sqrt = [&extract_sqrt](const std::shared_ptr<SymbolicExpr>& expr, ::Rational& coeff, ::Rational& radicand) -> bool {
-		if (expr->type == SymbolicExpr::Type::Number) {
-			coeff = expr->convert_rational();
-			radicand = ::Rational(1);
-			return true;
+std::shared_ptr<SymbolicExpr> SymbolicExpr::add_collect() const {
+	const auto& terms = operands;
+	// 同类项：每项拆成 数字系数 × 其余部分，其余部分按结构相等归组，系数一次性累加
+	::Rational number_term(0);
+	StructuralIndex rests;
+	std::vector<::Rational> coeffs;
+	for (const auto& term : terms) {
+		if (term->is_number()) {
+			number_term = number_term + term->convert_rational();
+			continue;
 		}
-        if (expr->type == SymbolicExpr::Type::Sqrt && expr->operands.size() == 1 && expr->operands[0]->is_number()) {
-            coeff = ::Rational(1);
-            radicand = expr->operands[0]->convert_rational();
-            return true;
-        }
-        if (expr->type == SymbolicExpr::Type::Multiply && expr->operands.size() == 2) {
-			// 先特殊判断两项的情况
-            if (expr->operands[0]->is_number() && expr->operands[1]->type == SymbolicExpr::Type::Sqrt && expr->operands[1]->operands.size() == 1 && expr->operands[1]->operands[0]->is_number()) {
-                coeff = expr->operands[0]->convert_rational();
-				//std::holds_alternative<::Rational>(expr->operands[0]->get_number()) ? std::get<::Rational>(expr->operands[0]->get_number()) : ::Rational(std::get<int>(expr->operands[0]->get_number()));
-				
-                radicand = expr->operands[1]->operands[0]->convert_rational();
-                return true;
-            }
-			::Rational coeff1, radicand1, coeff2, radicand2;
-			if (extract_sqrt(expr->operands[0], coeff1, radicand1) && extract_sqrt(expr->operands[1], coeff2, radicand2)) {
-				coeff = coeff1 * coeff2;
-				radicand = radicand1 * radicand2;
-				return true;
-			}
-        }
-        return false;
-    };
-
-    // TODO: 解析变量
-    /*auto extract_variable = [](const std::shared_ptr<SymbolicExpr>& expr, ::Rational& coeff) -> bool {
-        // type应该是变量或者乘法
-        if (expr->type == SymbolicExpr::Type::Variable && expr->operands.size() == 1) {
-            return true;
+		::Rational k;
+		ExprPtr rest;
+		split_coefficient(term, k, rest);
+		const size_t g = rests.find_or_add(rest);
+		if (g == coeffs.size()) coeffs.push_back(k);
+		else coeffs[g] = coeffs[g] + k;
+	}
+
+	std::vector<ExprPtr> result_terms;
+	for (size_t g = 0; g < rests.size(); g++) {
+		if (coeffs[g] == ::Rational(0)) continue;
+		result_terms.push_back(scaled(coeffs[g], rests.key(g)));
+	}
+	if (number_term != 0) result_terms.push_back(SymbolicExpr::exact_number(number_term));
+	// 结果为一个 n 元加法节点，项按规范顺序排列：高次项在前，常数在最后
+	SymbolicExpr::sort_terms(result_terms);
+	return SymbolicExpr::add(result_terms);
+}
+
+// 数字的整数次幂
+std::shared_ptr<SymbolicExpr> SymbolicExpr::power_of_number() const {
+    const auto& base = operands[0];
+    const auto& exponent = operands[1];
+    if (!base->is_number() || !(exponent->is_int() || exponent->is_big_int())) return nullptr;
+	auto banum = base->convert_rational();
+	auto exnum = exponent->convert_rational();
+	
+	if (exnum < ::Rational(0)) {
+		return SymbolicExpr::power(SymbolicExpr::number(banum.reciprocal()), SymbolicExpr::number(::Rational(0) - exnum))->simplify();
+	}
+	
+    auto expr = SymbolicExpr::make_node(Type::Number);
+    // 底数是分数，结果为分数
+	err_stream << "[Debug output] now simplifying power by literal\n";
+	
+    if (base->is_rational() || exponent->is_rational()) {
+		err_stream << "[Debug output] simplifying with rational power value\n";
+        if (exponent->is_int()) {
+			expr->number_value = (base->get_rational()).power(BigInt(exponent->get_int()));
+        } else if (exponent->is_big_int()) {
+			expr->number_value = (base->get_rational()).power(exponent->get_big_int());
         }
-    };*/
-
-    // 解析数字
-    auto extract_number = [](const std::shared_ptr<SymbolicExpr> expr, Rational& n) -> bool {
-        if (expr->type != SymbolicExpr::Type::Number) return false;
-		n = n + expr->convert_rational();
-        return true;
-    };
-
-    std::vector<std::shared_ptr<SymbolicExpr>> terms;
-    std::function<void(const std::shared_ptr<SymbolicExpr>&)> flatten_add;
-	// 展开所有加法项
-    flatten_add = [&](const std::shared_ptr<SymbolicExpr>& expr) {
-        if (expr->type == SymbolicExpr::Type::Add && expr->operands.size() == 2) {
-            flatten_add(expr->operands[0]);
-            flatten_add(expr->operands[1]);
+    } else {// 否则结果为大整数
+        BigInt b;
+        if (base->is_int()) {
+            b = BigInt(std::get<int>(base->get_number()));
         } else {
-            terms.push_back(expr);
+            b = std::get<BigInt>(base->get_number());
         }
-    };
-    flatten_add(left);
-    flatten_add(right);
-    std::map<::Rational, ::Rational> sqrt_terms;// radicand -> sum of coeffs
-    // std::map<std::string, ::Rational> variable_terms;// TODO
-    Rational number_term(0);// 数字部分
-    std::vector<std::shared_ptr<SymbolicExpr>> others;// other things (now reserved for others)
-	
-	err_stream << "[Debug output] adder: end flatten add\n";
-	// 键：其余项目，值：系数
-	std::map<SymbolicExpr::HashData::HashType, std::shared_ptr<SymbolicExpr> > undealt_items; 
-	std::map<SymbolicExpr::HashData::HashType, std::shared_ptr<SymbolicExpr> > hash_ref;
-	
-    for (const auto& term : terms) {
-        ::Rational coeff;
-        ::Rational radicand;
-        if (extract_sqrt(term, coeff, radicand)) {
-            sqrt_terms[radicand] = sqrt_terms[radicand] + coeff;
-			err_stream << "[Debug output] adder: got sqrt term " << coeff.to_string() << " at sqrt:" << radicand.to_string() << std::endl;
-        } else if (extract_number(term, number_term)) {
-            // Do nothing yet
+        BigInt e;
+        if (exponent->is_int()) {
+            e = BigInt(std::get<int>(exponent->get_number()));
         } else {
-			// TODO: 这边上哈希
-			err_stream << "[Debug output] adder: special item " << term->to_string() << std::endl;
-            //others.push_back(term);
-			SymbolicExpr::HashData hd(term);
-			auto cb = hd.get_combined_k();
-			hash_ref[hd.hash] = hd.hash_obj;
-			if (undealt_items.count(hd.hash)) {
-				undealt_items[hd.hash] = SymbolicExpr::add(undealt_items[hd.hash], cb);
-			} else {
-				undealt_items[hd.hash] = cb;
-			}
+            e = std::get<BigInt>(exponent->get_number());
         }
-    }
-	
-	err_stream << "[Debug output] adder: number term = " << number_term.to_string() << std::endl;
-	
-    std::vector<std::shared_ptr<SymbolicExpr>> result_terms;
-    for (const auto& [radicand, coeff] : sqrt_terms) {
-        if (coeff.is_integer() && coeff.get_numerator().to_int() == 0) continue;
-		
-		err_stream << "[Debug output] adder: sqrt term coeff:" << coeff.to_string() << "; radicand:" << radicand.to_string() << std::endl;
-		
-        if (radicand == ::Rational(1)) {
-			result_terms.push_back(SymbolicExpr::number(coeff));
-		} else if (coeff == ::Rational(1)) {
-            result_terms.push_back(SymbolicExpr::sqrt(SymbolicExpr::number(radicand)));
+        if (e.to_int() >= 0) {
+            expr->number_value = b.power(e);
         } else {
-            result_terms.push_back(SymbolicExpr::multiply(SymbolicExpr::number(coeff), SymbolicExpr::sqrt(SymbolicExpr::number(radicand))));
+            
+            expr->number_value = Rational(BigInt(1), b.power(e.negate()));
         }
     }
-    result_terms.insert(result_terms.end(), others.begin(), others.end());
-	for (const auto& i : undealt_items) {
-		// TODO: 可能此处有化简 hash_ref[i.first] 项的需求？（千万不要化简整个 multiply）
-		auto isv = i.second->simplify();
-		if (isv->is_number()) {
-			auto icr = isv->convert_rational();
-			if (icr == ::Rational(0)) continue;
-			if (icr == ::Rational(1)) {
-				result_terms.push_back(hash_ref[i.first]->simplify());
-				continue;
-			}
-		}
-		result_terms.push_back(SymbolicExpr::multiply(isv, hash_ref[i.first]->simplify()));
-	}
-	
-    if (number_term != 0) {// 非0时才添加数字
-        result_terms.push_back(SymbolicExpr::number(number_term));
-    }
-    if (result_terms.empty()) return SymbolicExpr::number(0);
-    if (result_terms.size() == 1) return result_terms[0];
 
-    std::shared_ptr<SymbolicExpr> sum = result_terms[0];
-    for (size_t i = 1; i < result_terms.size(); ++i) {
-        sum = SymbolicExpr::add(sum, result_terms[i]);
-    }
-    return sum;
+    return expr;
 }
 
-std::shared_ptr<SymbolicExpr> SymbolicExpr::simplify_power() const {
-    // 如果底数是数字，且指数是整数，用数字储存
-    auto base = operands[0]->simplify();
-    auto exponent = operands[1]->simplify();
+// 数字的分数次幂：能开尽的部分开出，分母为 2 时交给平方根化简
+std::shared_ptr<SymbolicExpr> SymbolicExpr::root_of_number() const {
+    const auto& base = operands[0];
+    const auto& exponent = operands[1];
+    if (!base->is_number() || !exponent->is_rational()) return nullptr;
+    // 底数是数字，指数是分数
+    // 用符号储存
+	// 必要的化简如 8^(1/3)
+	auto bsr = base->convert_rational();
+	auto expr = exponent->convert_rational();
 	
-	// TODO: 理论上有未定式
-	if (exponent->type == SymbolicExpr::Type::Number && exponent->convert_rational() == ::Rational(0)) return SymbolicExpr::number(1);
-	if (base->type == SymbolicExpr::Type::Number && base->convert_rational() == ::Rational(0)) return SymbolicExpr::number(0);
-	if (exponent->is_number() && exponent->convert_rational() == ::Rational(1)) return base;
-	if (base->is_number() && base->convert_rational() == ::Rational(1)) return base;
-	
-	if (base->type == SymbolicExpr::Type::Infinity) return base;
-	if (exponent->type == SymbolicExpr::Type::Infinity) return exponent;
-	
-	// TODO: Debug output:
-	err_stream << "[Debug output] Simplifying power: base = " << base->to_string() << "; exponent = " << exponent->to_string()
-		<< std::endl;
+	auto in_range = [](const ::Rational& val) -> bool {
+		auto vn = val.get_numerator(), vd = val.get_denominator();
+		const ::BigInt lower = ::BigInt(INT_MIN), upper = ::BigInt(INT_MAX);
+		return (vn >= lower && vn <= upper) && (vd >= lower && vd <= upper);
+	};
 	
-    if (base->is_number() && (exponent->is_int() || exponent->is_big_int())) {
-		auto banum = base->convert_rational();
-		auto exnum = exponent->convert_rational();
+	if (in_range(bsr) && in_range(expr)) {
+		// TODO: Debug output:
+		err_stream << "[Debug output] Power simplifying (rational ^ rational) expressions" << std::endl;
 		
-		if (exnum < ::Rational(0)) {
-			return SymbolicExpr::power(SymbolicExpr::number(banum.reciprocal()), SymbolicExpr::number(::Rational(0) - exnum))->simplify();
-		}
+		if (expr == ::Rational(1)) return SymbolicExpr::number(bsr);
 		
-        auto expr = std::make_shared<SymbolicExpr>(Type::Number);
-        // 底数是分数，结果为分数
-		err_stream << "[Debug output] now simplifying power by literal\n";
+		int bs_n = bsr.get_numerator().to_int(), bs_d = bsr.get_denominator().to_int();
+		int es_n = expr.get_numerator().to_int(), es_d = expr.get_denominator().to_int();
+		// TODO: Debug output:
+		err_stream << "[Debug output] bs = " << bs_n << "/" << bs_d << "; es = " << es_n << "/" << es_d << std::endl;
 		
-        if (base->is_rational() || exponent->is_rational()) {
-			err_stream << "[Debug output] simplifying with rational power value\n";
-            if (exponent->is_int()) {
-				expr->number_value = (base->get_rational()).power(BigInt(exponent->get_int()));
-            } else if (exponent->is_big_int()) {
-				expr->number_value = (base->get_rational()).power(exponent->get_big_int());
-            }
-        } else {// 否则结果为大整数
-            BigInt b;
-            if (base->is_int()) {
-                b = BigInt(std::get<int>(base->get_number()));
-            } else {
-                b = std::get<BigInt>(base->get_number());
-            }
-            BigInt e;
-            if (exponent->is_int()) {
-                e = BigInt(std::get<int>(exponent->get_number()));
-            } else {
-                e = std::get<BigInt>(exponent->get_number());
-            }
-            if (e.to_int() >= 0) {
-                expr->number_value = b.power(e);
-            } else {
-                
-                expr->number_value = Rational(BigInt(1), b.power(e.negate()));
-            }
-        }
-
-        return expr;
-    } else if (base->is_number() && exponent->is_rational()) {
-        // 底数是数字，指数是分数
-        // 用符号储存
-		// 必要的化简如 8^(1/3)
-		auto bsr = base->convert_rational();
-		auto expr = exponent->convert_rational();
+		// 如果成功，返回非 0，origin 为修改后的值，保证 origin 不增大
+		// 如果失败，返回 0，origin 不做修改
+		// 注意，要保证既约分数（gcd(num, denom) = 1）
+		// TODO: 考虑是否特判 1
+		// 返回：0: 无法化简，否则返回 es_d 应当被除以多少
 		
-		auto in_range = [](const ::Rational& val) -> bool {
-			auto vn = val.get_numerator(), vd = val.get_denominator();
-			const ::BigInt lower = ::BigInt(INT_MIN), upper = ::BigInt(INT_MAX);
-			return (vn >= lower && vn <= upper) && (vd >= lower && vd <= upper);
+		std::function<int(int,int)> __int_gcd;
+		__int_gcd = [&__int_gcd](int a, int b) -> int {
+			if (b == 0) return a;
+			else return __int_gcd(b, a%b);
 		};
 		
-		if (in_range(bsr) && in_range(expr)) {
-			// TODO: Debug output:
-			err_stream << "[Debug output] Power simplifying (rational ^ rational) expressions" << std::endl;
-			
-			if (expr == ::Rational(1)) return SymbolicExpr::number(bsr);
-			
-			int bs_n = bsr.get_numerator().to_int(), bs_d = bsr.get_denominator().to_int();
-			int es_n = expr.get_numerator().to_int(), es_d = expr.get_denominator().to_int();
-			// TODO: Debug output:
-			err_stream << "[Debug output] bs = " << bs_n << "/" << bs_d << "; es = " << es_n << "/" << es_d << std::endl;
-			
-			// 如果成功，返回非 0，origin 为修改后的值，保证 origin 不增大
-			// 如果失败，返回 0，origin 不做修改
-			// 注意，要保证既约分数（gcd(num, denom) = 1）
-			// TODO: 考虑是否特判 1
-			// 返回：0: 无法化简，否则返回 es_d 应当被除以多少
-			
-			std::function<int(int,int)> __int_gcd;
-			__int_gcd = [&__int_gcd](int a, int b) -> int {
-				if (b == 0) return a;
-				else return __int_gcd(b, a%b);
-			};
-			
-			auto simplify_inner = [&__int_gcd](int& origin, const int& denom) -> int {
-				if (denom == 1) return 1;	// 无条件成功
-				int ediv = denom, target = origin;
-				for (int i = 2; 1ll * i * i <= target; i++) {
-					int exphere = 0;
-					while (target % i == 0) {
-						exphere++;
-						target /= i;
-					}
-					if (exphere) {
-						ediv = __int_gcd(ediv, exphere);
-					}
+		auto simplify_inner = [&__int_gcd](int& origin, const int& denom) -> int {
+			if (denom == 1) return 1;	// 无条件成功
+			int ediv = denom, target = origin;
+			for (int i = 2; 1ll * i * i <= target; i++) {
+				int exphere = 0;
+				while (target % i == 0) {
+					exphere++;
+					target /= i;
 				}
-				if (ediv <= 1) return 0;
-				// 可以优化
-				int answer = 1;
-				target = origin;
-				for (int i = 2; 1ll * i * i <= target; i++) {
-					int exphere = 0;
-					while (target % i == 0) {
-						exphere++;
-						target /= i;
-					}
-					if (exphere && (exphere % ediv == 0)) {
-						int contb = exphere / ediv;
-						for (int j = 0; j < contb; j++) answer *= i;
-					} else return false;
+				if (exphere) {
+					ediv = __int_gcd(ediv, exphere);
 				}
-				if (target != 1) {
-					if (ediv != 1) {
-						// TODO: Debug output:
-						err_stream << "[Debug output] warning: target != 1\n";
-						return 0;
-					}
-					answer *= target;
+			}
+			if (ediv <= 1) return 0;
+			// 可以优化
+			int answer = 1;
+			target = origin;
+			for (int i = 2; 1ll * i * i <= target; i++) {
+				int exphere = 0;
+				while (target % i == 0) {
+					exphere++;
+					target /= i;
 				}
-				// TODO: Debug output:
-				err_stream << "[Debug output] Denom = " << denom << ", Simplifying " << target << " to " << answer << std::endl;
-				origin = answer;
-				return ediv;
-			};
-			
-			int simp1 = 1, simp2 = 1;
-			if ((simp1 = simplify_inner(bs_n, es_d)) >= 1 && (simp2 = simplify_inner(bs_d, es_d)) >= 1) {
-				int simps = __int_gcd(simp1, simp2);
-				if (simps >= 1) {
-					// 化简成功
+				if (exphere && (exphere % ediv == 0)) {
+					int contb = exphere / ediv;
+					for (int j = 0; j < contb; j++) answer *= i;
+				} else return false;
+			}
+			if (target != 1) {
+				if (ediv != 1) {
 					// TODO: Debug output:
-					es_d /= simps;
-					err_stream << "[Debug output] Post-operation bs = " << bs_n << "/" << bs_d << "; es = " << es_n << "/" << es_d << std::endl;
-					err_stream << "[Debug output] Power simplifying (rational ^ rational) - success" << std::endl;
-					auto current_new_base = SymbolicExpr::number((::Rational(bs_n, bs_d)).power(::BigInt(es_n)));
-					if (es_d == 1) return current_new_base;
-					return SymbolicExpr::power(current_new_base, SymbolicExpr::number(::Rational(::BigInt(1), ::BigInt(es_d))));
+					err_stream << "[Debug output] warning: target != 1\n";
+					return 0;
 				}
-				
+				answer *= target;
+			}
+			// TODO: Debug output:
+			err_stream << "[Debug output] Denom = " << denom << ", Simplifying " << target << " to " << answer << std::endl;
+			origin = answer;
+			return ediv;
+		};
+		
+		int simp1 = 1, simp2 = 1;
+		if ((simp1 = simplify_inner(bs_n, es_d)) >= 1 && (simp2 = simplify_inner(bs_d, es_d)) >= 1) {
+			int simps = __int_gcd(simp1, simp2);
+			if (simps >= 1) {
+				// 化简成功
+				// TODO: Debug output:
+				es_d /= simps;
+				err_stream << "[Debug output] Post-operation bs = " << bs_n << "/" << bs_d << "; es = " << es_n << "/" << es_d << std::endl;
+				err_stream << "[Debug output] Power simplifying (rational ^ rational) - success" << std::endl;
+				auto current_new_base = SymbolicExpr::number((::Rational(bs_n, bs_d)).power(::BigInt(es_n)));
+				if (es_d == 1) return current_new_base;
+				return SymbolicExpr::power(current_new_base, SymbolicExpr::number(::Rational(::BigInt(1), ::BigInt(es_d))));
 			}
-			// 否则化简失败，注意 bs_n 和 bs_d 可能需要重新获取
 			
 		}
+		// 否则化简失败，注意 bs_n 和 bs_d 可能需要重新获取
 		
-		// 避免修改，重新获取
-		auto rconv = exponent->convert_rational();
-		
-		if (rconv.get_denominator() == ::BigInt(2) && rconv.get_numerator() >= ::BigInt(-3) 
-			&& rconv.get_numerator() <= ::BigInt(3)) {
-			err_stream << "[Debug output] call of sqrt simplifier\n";
-			return SymbolicExpr::sqrt(SymbolicExpr::power(base, SymbolicExpr::number(rconv.get_numerator())))->simplify();
-		}
-    } else if (base->type == SymbolicExpr::Type::Power || base->type == SymbolicExpr::Type::Sqrt) {
-		if (base->type == SymbolicExpr::Type::Sqrt) {
-			base = SymbolicExpr::power(base->operands[0], SymbolicExpr::number(::Rational(1, 2)));
-		}
-		// TODO: Debug output:
-		err_stream << "[Debug output] Power simplifying embedded power / sqrt" << std::endl;
-		auto pwr = SymbolicExpr::multiply(base->operands[1], exponent)->simplify();
-		if (pwr->type == SymbolicExpr::Type::Number && pwr->convert_rational() == ::Rational(1))
-			return base->operands[0]->simplify();
-		return SymbolicExpr::power(base->operands[0]->simplify(), pwr);
 	}
 	
-	if (exponent->is_int() || exponent->is_big_int()) {
-		auto rconv = exponent->convert_rational();
-		if (rconv == ::Rational(0)) return SymbolicExpr::number(1);
-		if (rconv == ::Rational(1)) return std::make_shared<SymbolicExpr>(*base);
-		if (rconv == ::Rational(-1)) {
-			// 这里一定不是整数，尝试分母有理化
-			
-			std::function<bool(const std::shared_ptr<SymbolicExpr> &)> processable;
-			processable = [&processable](const std::shared_ptr<SymbolicExpr> &obj) -> bool {
-				return obj->type == SymbolicExpr::Type::Number || obj->type == SymbolicExpr::Type::Sqrt
-					|| (obj->type == SymbolicExpr::Type::Multiply && obj->operands.size() == 2
-						&& processable(obj->operands[0]) && processable(obj->operands[1]));
-			};
-			
-			err_stream << "[Debug output] begin rationalizing attempt\n";
-			
-			if (base->type == SymbolicExpr::Type::Add && base->operands.size() == 2 &&
-				processable(base->operands[0]) && processable(base->operands[1])) {
-				auto new_term = SymbolicExpr::multiply(SymbolicExpr::number(-1), base->operands[1])->simplify();
-				// TODO: Debug output:
-				err_stream << "[Debug output] term processor ended\n";
-				auto new_nume = SymbolicExpr::add(base->operands[0], new_term);
-				err_stream << "[Debug output] nume processor ended\n";
-				auto new_denom = SymbolicExpr::multiply(base, new_nume)->simplify();
-				err_stream << "[Debug output] denom processor ended\n";
-				if (new_denom->type == SymbolicExpr::Type::Number) {
-					err_stream << "[Debug output] term = " << new_term->to_string() << "; denom = " << new_denom->to_string() << std::endl;
-					return SymbolicExpr::multiply(SymbolicExpr::number(new_denom->convert_rational().reciprocal()), 
-							new_nume)->simplify();
-				} else {
-					// 有理化失败
-					// TODO: Debug output
-					err_stream << "[Debug output] Pow: rationalize failed!\n";
-				}
-				
-			}
+	// 避免修改，重新获取
+	auto rconv = exponent->convert_rational();
+	
+	if (rconv.get_denominator() == ::BigInt(2) && rconv.get_numerator() >= ::BigInt(-3) 
+		&& rconv.get_numerator() <= ::BigInt(3)) {
+		err_stream << "[Debug output] call of sqrt simplifier\n";
+		return SymbolicExpr::sqrt(SymbolicExpr::power(base, SymbolicExpr::number(rconv.get_numerator())))->simplify();
+	}
+    return nullptr;
+}
+
+// 幂的幂、根式的幂：指数相乘
+std::shared_ptr<SymbolicExpr> SymbolicExpr::power_of_power() const {
+    auto base = operands[0];
+    const auto& exponent = operands[1];
+    if (base->type != SymbolicExpr::Type::Power && base->type != SymbolicExpr::Type::Sqrt) return nullptr;
+	if (base->type == SymbolicExpr::Type::Sqrt) {
+		base = SymbolicExpr::power(base->operands[0], SymbolicExpr::number(::Rational(1, 2)));
+	}
+	// TODO: Debug output:
+	err_stream << "[Debug output] Power simplifying embedded power / sqrt" << std::endl;
+	auto pwr = SymbolicExpr::multiply(base->operands[1], exponent)->simplify();
+	if (pwr->type == SymbolicExpr::Type::Number && pwr->convert_rational() == ::Rational(1))
+		return base->operands[0]->simplify();
+	return SymbolicExpr::power(base->operands[0]->simplify(), pwr);
+}
+
+// 分母有理化：(a + b)^-1，a、b 为数字或数字的根式
+std::shared_ptr<SymbolicExpr> SymbolicExpr::power_rationalize() const {
+    const auto& base = operands[0];
+    const auto& exponent = operands[1];
+    if (!exponent->is_number() || !(exponent->convert_rational() == ::Rational(-1))) return nullptr;
+	std::function<bool(const std::shared_ptr<SymbolicExpr> &)> processable;
+	processable = [&processable](const std::shared_ptr<SymbolicExpr> &obj) -> bool {
+		return obj->type == SymbolicExpr::Type::Number || obj->type == SymbolicExpr::Type::Sqrt
+			|| (obj->type == SymbolicExpr::Type::Multiply && obj->operands.size() == 2
+				&& processable(obj->operands[0]) && processable(obj->operands[1]));
+	};
+	
+	err_stream << "[Debug output] begin rationalizing attempt\n";
+	
+	if (base->type == SymbolicExpr::Type::Add && base->operands.size() == 2 &&
+		processable(base->operands[0]) && processable(base->operands[1])) {
+		auto new_term = SymbolicExpr::multiply(SymbolicExpr::number(-1), base->operands[1])->simplify();
+		// TODO: Debug output:
+		err_stream << "[Debug output] term processor ended\n";
+		auto new_nume = SymbolicExpr::add(base->operands[0], new_term);
+		err_stream << "[Debug output] nume processor ended\n";
+		auto new_denom = SymbolicExpr::multiply(base, new_nume)->simplify();
+		err_stream << "[Debug output] denom processor ended\n";
+		if (new_denom->type == SymbolicExpr::Type::Number) {
+			err_stream << "[Debug output] term = " << new_term->to_string() << "; denom = " << new_denom->to_string() << std::endl;
+			return SymbolicExpr::multiply(SymbolicExpr::number(new_denom->convert_rational().reciprocal()), 
+					new_nume)->simplify();
+		} else {
+			// 有理化失败
+			// TODO: Debug output
+			err_stream << "[Debug output] Pow: rationalize failed!\n";
 		}
-		// 防止死循环
-		if (rconv.get_denominator() == ::BigInt(1) && rconv.get_numerator() >= ::BigInt(-3) && rconv.get_numerator() < ::BigInt(-1)) {
-			// 转为倒数的情况
-			return SymbolicExpr::power(SymbolicExpr::power(base, SymbolicExpr::number(rconv.get_numerator())), SymbolicExpr::number(-1))->simplify();
+		
+	}
+	return nullptr;
+}
+
+// 负整数次幂转为倒数：a^-n = (a^n)^-1
+std::shared_ptr<SymbolicExpr> SymbolicExpr::power_reciprocal() const {
+    const auto& base = operands[0];
+    const auto& exponent = operands[1];
+    if (!(exponent->is_int() || exponent->is_big_int()) || base->is_number()) return nullptr;
+    auto rconv = exponent->convert_rational();
+	// 防止死循环
+	if (rconv.get_denominator() == ::BigInt(1) && rconv.get_numerator() >= ::BigInt(-3) && rconv.get_numerator() < ::BigInt(-1)) {
+		// 转为倒数的情况
+		return SymbolicExpr::power(SymbolicExpr::power(base, SymbolicExpr::exact_number(-rconv)), SymbolicExpr::number(-1))->simplify();
+	}
+	return nullptr;
+}
+
+// 加法、乘法的正整数次幂展开
+std::shared_ptr<SymbolicExpr> SymbolicExpr::power_expand() const {
+    const auto& base = operands[0];
+    const auto& exponent = operands[1];
+    if (!(exponent->is_int() || exponent->is_big_int())) return nullptr;
+    if (base->type != SymbolicExpr::Type::Add && base->type != SymbolicExpr::Type::Multiply) return nullptr;
+    auto rconv = exponent->convert_rational();
+	if (rconv.get_denominator() == ::BigInt(1) && rconv.get_numerator() > ::BigInt(1)) {
+		// 多项式底数在规模限制内直接展开
+		Polynomial bp;
+		if (base->type == SymbolicExpr::Type::Add && Polynomial::from_symbolic(SymbolicExpr::power(base, exponent), bp)) {
+			return bp.to_symbolic();
 		}
-		if (rconv.get_denominator() == ::BigInt(1) && rconv.get_numerator() > ::BigInt(1) && rconv.get_numerator() <= ::BigInt(4)) {
+		if (rconv.get_numerator() <= ::BigInt(4)) {
 			int exps = rconv.get_numerator().to_int();
-			std::shared_ptr<SymbolicExpr> result = std::make_shared<SymbolicExpr>(*base);
+			std::shared_ptr<SymbolicExpr> result = SymbolicExpr::make_node(*base);
 			for (int i = 2; i <= exps; i++)
 				result = SymbolicExpr::multiply(result, base)->simplify();
 			return result;
 		}
 	}
-
-    return SymbolicExpr::power(base, exponent);
+	return nullptr;
 }
 
 
 std::string SymbolicExpr::to_string() const {
-	
-	auto get_output = [](std::shared_ptr<const SymbolicExpr> expr) -> std::string {
-		const std::string lbrace = std::string("("), rbrace = std::string(")");
-		if ((expr->type == SymbolicExpr::Type::Number && (expr->convert_rational().get_denominator() == ::BigInt(1))) || expr->type == SymbolicExpr::Type::Variable
-			|| expr->type == SymbolicExpr::Type::Sqrt) return expr->to_string();
-		else return lbrace + expr->to_string() + rbrace;
+	std::string out;
+	write_to(out);
+	return out;
+}
+
+void SymbolicExpr::write_to(std::string& out) const {
+	// 整数、变量、根号以外的操作数加括号
+	auto write_operand = [&out](const std::shared_ptr<SymbolicExpr>& expr) {
+		bool bare = (expr->type == SymbolicExpr::Type::Number && (expr->convert_rational().get_denominator() == ::BigInt(1)))
+			|| expr->type == SymbolicExpr::Type::Variable || expr->type == SymbolicExpr::Type::Sqrt;
+		if (!bare) out += '(';
+		expr->write_to(out);
+		if (!bare) out += ')';
 	};
 	
     switch (type) {
         case Type::Number:
             if (std::holds_alternative<int>(number_value)) {
-                return std::to_string(std::get<int>(number_value));
+                out += std::to_string(std::get<int>(number_value));
             } else if (std::holds_alternative<::BigInt>(number_value)) {
-                return std::get<::BigInt>(number_value).to_string();
-            } else if (std::holds_alternative<::Rational>(number_value)) {
-                return std::get<::Rational>(number_value).to_string();
+                std::get<::BigInt>(number_value).write_to(out);
+            } else {
+                std::get<::Rational>(number_value).write_to(out);
             }
-            return "0";
+            return;
             
         case Type::Variable:
-            return identifier;
+            out += identifier;
+            return;
 			
 		case Type::Infinity:
-			if (std::get<int>(number_value) > 0) return "inf";
-			else return "-inf";
+			out += std::get<int>(number_value) > 0 ? "inf" : "-inf";
+			return;
             
         case Type::Sqrt:
-            if (operands.empty()) return "√()";
-            return "√" + get_output(operands[0]);
+            if (operands.empty()) {
+                out += "√()";
+                return;
+            }
+            out += "√";
+            write_operand(operands[0]);
+            return;
             
         case Type::Multiply:
-            if (operands.size() < 2) return "*(?)";
-
-            if (operands[0]->is_number() && operands[1]->type == Type::Sqrt) {
-                return operands[0]->to_string() + operands[1]->to_string();
+            if (operands.size() < 2) {
+                out += "*(?)";
+                return;
             }
-            return get_output(operands[0]) + "*" + get_output(operands[1]);
+            if (operands.size() == 2 && operands[0]->is_number() && operands[1]->type == Type::Sqrt) {
+                write_operand(operands[0]);
+                operands[1]->write_to(out);
+                return;
+            }
+            write_operand(operands[0]);
+            for (size_t i = 1; i < operands.size(); ++i) {
+                out += '*';
+                write_operand(operands[i]);
+            }
+            return;
             
         case Type::Add: {
-            if (operands.size() < 2) return "+(?)";
-			
-            std::vector<std::shared_ptr<SymbolicExpr>> terms;
-            std::function<void(const std::shared_ptr<SymbolicExpr>&)> flatten_add;
-            flatten_add = [&](const std::shared_ptr<SymbolicExpr>& expr) {
-                if (expr->type == Type::Add && expr->operands.size() == 2) {
-                    flatten_add(expr->operands[0]);
-                    flatten_add(expr->operands[1]);
+            if (operands.size() < 2) {
+                out += "+(?)";
+                return;
+            }
+            // 嵌套的加法展开成一串，按原顺序输出
+            bool first = true;
+            std::function<void(const std::shared_ptr<SymbolicExpr>&)> write_terms;
+            write_terms = [&](const std::shared_ptr<SymbolicExpr>& expr) {
+                if (expr->type == Type::Add && expr->operands.size() >= 2) {
+                    for (const auto& op : expr->operands) write_terms(op);
+                    return;
+                }
+                if (!first) out += '+';
+                // 负数项加括号，避免出现 "+-"
+                if (!first && expr->is_number() && expr->convert_rational() < ::Rational(0)) {
+                    out += '(';
+                    expr->write_to(out);
+                    out += ')';
                 } else {
-                    terms.push_back(expr);
+                    write_operand(expr);
                 }
+                first = false;
             };
-            flatten_add(std::make_shared<SymbolicExpr>(*this));
-
-            std::vector<std::string> result_terms;
-			result_terms.reserve(terms.size());
-            for (auto &term : terms) {
-                result_terms.push_back(get_output(term));
-            }
-
-            if (result_terms.empty()) return "0";
-            std::string res = result_terms[0];
-            for (size_t i = 1; i < result_terms.size(); ++i) {
-                res += "+" + result_terms[i];
-            }
-            return res;
+            for (const auto& op : operands) write_terms(op);
+            return;
         }
             
         case Type::Power:
-            if (operands.size() < 2) return "^(?)";
-            return get_output(operands[0]) + "^" + get_output(operands[1]);
+            if (operands.size() < 2) {
+                out += "^(?)";
+                return;
+            }
+            write_operand(operands[0]);
+            out += '^';
+            write_operand(operands[1]);
+            return;
             
         default:
-            return "Unknown";
+            out += "Unknown";
     }
 }
 
 double SymbolicExpr::to_double() const {
-    switch (type) {
-        case Type::Number:
-            if (std::holds_alternative<int>(number_value)) {
-                return static_cast<double>(std::get<int>(number_value));
-            } else if (std::holds_alternative<::BigInt>(number_value)) {
-                return std::get<::BigInt>(number_value).to_double();
-            } else if (std::holds_alternative<::Rational>(number_value)) {
-                return std::get<::Rational>(number_value).to_double();
-            }
-            return 0.0;
+	if (!interned) return compile().evaluate(nullptr);
+	// 驻留节点不会再被修改，编译一次即可；不含自由变量时程序只是一个常数
+	std::shared_ptr<const SymbolicProgram> prog;
+	{
+		std::lock_guard<std::mutex> lock(program_cache_mutex);
+		prog = program_cache;
+	}
+	if (!prog) {
+		prog = std::make_shared<const SymbolicProgram>(compile());
+		std::lock_guard<std::mutex> lock(program_cache_mutex);
+		program_cache = prog;
+	}
+	return prog->evaluate(nullptr);
+}
 
-        case Type::Variable:
-            if (identifier == "π" || identifier == "pi") {
-                #ifdef M_PI
-                return M_PI;
-                #else
-                return 3.14159265358979323846;
-                #endif
-            }
-			if (identifier == "e") {
-				return 2.718281828459045;
+SymbolicProgram SymbolicExpr::compile(const std::vector<std::string>& variables) const {
+	using Op = SymbolicProgram::Op;
+	SymbolicProgram prog;
+	prog.variables = variables;
+	auto& code = prog.code;
+	size_t depth = 0;
+
+	auto push = [&](SymbolicProgram::Instr ins) {
+		code.push_back(ins);
+		prog.max_stack = std::max(prog.max_stack, ++depth);
+	};
+	auto constant = [&](double v) { push({Op::Const, 0, v}); };
+	// 弹出最后 n 条指令并合并为 op 的一条指令；n 个操作数都是常数时直接算出结果
+	// 常数操作数恰好是最后 n 条指令（每个常数子树只留下一条 Const），所以折叠不需要再遍历子树
+	auto combine = [&](Op op, size_t n) {
+		depth -= n;
+		const bool folded = std::all_of(code.end() - n, code.end(),
+			[](const SymbolicProgram::Instr& ins) { return ins.op == Op::Const; });
+		if (!folded) {
+			push({op, static_cast<unsigned int>(n), 0.0});
+			return;
+		}
+		double v = code.back().value;
+		switch (op) {
+			case Op::Add:
+				v = 0.0;
+				for (auto it = code.end() - n; it != code.end(); ++it) v += it->value;
+				break;
+			case Op::Mul:
+				v = 1.0;
+				for (auto it = code.end() - n; it != code.end(); ++it) v *= it->value;
+				break;
+			case Op::Pow:
+				v = std::pow(code[code.size() - 2].value, v);
+				break;
+			case Op::Sqrt:
+				v = std::sqrt(v);
+				break;
+			default:
+				break;
+		}
+		code.resize(code.size() - n);
+		constant(v);
+	};
+
+	std::function<void(const SymbolicExpr&)> emit = [&](const SymbolicExpr& expr) {
+		switch (expr.type) {
+			case Type::Number:
+				if (std::holds_alternative<int>(expr.number_value)) {
+					constant(static_cast<double>(std::get<int>(expr.number_value)));
+				} else if (std::holds_alternative<::BigInt>(expr.number_value)) {
+					constant(std::get<::BigInt>(expr.number_value).to_double());
+				} else {
+					constant(std::get<::Rational>(expr.number_value).to_double());
+				}
+				return;
+
+			case Type::Variable: {
+				if (expr.identifier == "π" || expr.identifier == "pi") {
+					#ifdef M_PI
+					constant(M_PI);
+					#else
+					constant(3.14159265358979323846);
+					#endif
+					return;
+				}
+				if (expr.identifier == "e") {
+					constant(2.718281828459045);
+					return;
+				}
+				auto it = std::find(variables.begin(), variables.end(), expr.identifier);
+				// 其他变量没有给出槽位时抛异常
+				if (it == variables.end()) throw std::runtime_error("Symbolic variable cannot be converted to double");
+				push({Op::Load, static_cast<unsigned int>(it - variables.begin()), 0.0});
+				return;
 			}
-            // 其他变量仍抛异常
-            throw std::runtime_error("Symbolic variable cannot be converted to double");
 
-		case Type::Infinity:
-			if (std::get<int>(number_value) > 0) return std::numeric_limits<double>::infinity();
-			else return -std::numeric_limits<double>::infinity();
+			case Type::Infinity:
+				constant(std::get<int>(expr.number_value) > 0 ? std::numeric_limits<double>::infinity()
+					: -std::numeric_limits<double>::infinity());
+				return;
 
-        case Type::Sqrt:
-            if (!operands.empty()) {
-                return std::sqrt(operands[0]->to_double());
-            }
-            return 0.0;
+			case Type::Sqrt:
+				if (expr.operands.empty()) break;
+				emit(*expr.operands[0]);
+				combine(Op::Sqrt, 1);
+				return;
 
-        case Type::Multiply:
-            if (operands.size() >= 2) {
-                return operands[0]->to_double() * operands[1]->to_double();
-            }
-            return 0.0;
-			
-		case Type::Add:
-			if (operands.size() >= 2) {
-                return operands[0]->to_double() + operands[1]->to_double();
-            }
-            return 0.0;
-			
-		case Type::Power:
-			return std::pow(operands[0]->to_double(), operands[1]->to_double());
+			case Type::Power:
+				emit(*expr.operands[0]);
+				emit(*expr.operands[1]);
+				combine(Op::Pow, 2);
+				return;
 
-        default:
-            return 0.0;
-    }
+			case Type::Multiply:
+			case Type::Add:
+				if (expr.operands.size() < 2) break;
+				for (const auto& op : expr.operands) emit(*op);
+				combine(expr.type == Type::Add ? Op::Add : Op::Mul, expr.operands.size());
+				return;
+
+			default:
+				break;
+		}
+		constant(0.0);
+	};
+	emit(*this);
+	return prog;
+}
+
+double SymbolicProgram::evaluate(const double* bindings) const {
+	if (code.size() == 1 && code[0].op == Op::Const) return code[0].value;
+	double small_stack[32];
+	std::vector<double> big_stack;
+	double* stack = small_stack;
+	if (max_stack > 32) {
+		big_stack.resize(max_stack);
+		stack = big_stack.data();
+	}
+	size_t sp = 0;
+	for (const auto& ins : code) {
+		switch (ins.op) {
+			case Op::Const: stack[sp++] = ins.value; break;
+			case Op::Load: stack[sp++] = bindings[ins.arg]; break;
+			case Op::Add: {
+				double acc = stack[sp - ins.arg];
+				for (size_t i = sp - ins.arg + 1; i < sp; i++) acc += stack[i];
+				sp -= ins.arg;
+				stack[sp++] = acc;
+				break;
+			}
+			case Op::Mul: {
+				double acc = stack[sp - ins.arg];
+				for (size_t i = sp - ins.arg + 1; i < sp; i++) acc *= stack[i];
+				sp -= ins.arg;
+				stack[sp++] = acc;
+				break;
+			}
+			case Op::Pow:
+				sp--;
+				stack[sp - 1] = std::pow(stack[sp - 1], stack[sp]);
+				break;
+			case Op::Sqrt:
+				stack[sp - 1] = std::sqrt(stack[sp - 1]);
+				break;
+		}
+	}
+	return sp ? stack[sp - 1] : 0.0;
+}
+
+namespace {
+	// 定点区间：真实值位于 [(mid - rad) / 10^p, (mid + rad) / 10^p]
+	struct DecimalBall {
+		::BigInt mid;
+		::BigInt rad;
+	};
+
+	// 区间包含 0 等无法在当前精度下确定的情况
+	struct PrecisionShortage : std::runtime_error {
+		PrecisionShortage() : std::runtime_error("precision shortage") {}
+	};
+
+	::BigInt pow10_big(size_t n) {
+		::BigInt r(1);
+		r.mul_pow10(n);
+		return r;
+	}
+
+	// 整数 n 次方根（向下取整），x >= 0
+	::BigInt int_root(const ::BigInt& x, int n) {
+		if (x.is_zero()) return ::BigInt(0);
+		if (n == 2) return x.sqrt();
+		::BigInt nb(n), nm1(n - 1);
+		::BigInt r = pow10_big((x.digits.size() + n - 1) / n);	// 初值不小于真实根
+		while (true) {
+			::BigInt y = (nm1 * r + x / r.power(nm1)) / nb;
+			if (!(y < r)) break;
+			r = y;
+		}
+		return r;
+	}
+
+	// arctan(1/x) 的定点值，scale 为 10^p
+	::BigInt arctan_inv(int x, const ::BigInt& scale) {
+		::BigInt x2(x * x), power = scale / ::BigInt(x), sum(0);
+		for (int k = 0; !power.is_zero(); k++) {
+			::BigInt term = power / ::BigInt(2 * k + 1);
+			if (k % 2) sum -= term;
+			else sum += term;
+			power = power / x2;
+		}
+		return sum;
+	}
+
+	DecimalBall ball_pi(size_t p) {
+		// Machin 公式，多算 10 位保护位抵消每项的截断误差
+		::BigInt scale = pow10_big(p + 10);
+		::BigInt v = ::BigInt(16) * arctan_inv(5, scale) - ::BigInt(4) * arctan_inv(239, scale);
+		return {v / pow10_big(10), ::BigInt(2)};
+	}
+
+	DecimalBall ball_e(size_t p) {
+		::BigInt scale = pow10_big(p + 10), term = scale, sum(0);
+		for (int k = 1; !term.is_zero(); k++) {
+			sum += term;
+			term = term / ::BigInt(k);
+		}
+		return {sum / pow10_big(10), ::BigInt(2)};
+	}
+
+	DecimalBall ball_mul(const DecimalBall& a, const DecimalBall& b, const ::BigInt& scale) {
+		::BigInt err = a.mid.abs() * b.rad + b.mid.abs() * a.rad + a.rad * b.rad;
+		return {a.mid * b.mid / scale, err / scale + ::BigInt(1)};
+	}
+
+	DecimalBall ball_reciprocal(const DecimalBall& a, const ::BigInt& scale) {
+		::BigInt lo = a.mid.abs() - a.rad, hi = a.mid.abs() + a.rad;
+		if (!(lo > ::BigInt(0))) throw PrecisionShortage();
+		// 1/x 单调，分别对端点求值
+		::BigInt s2 = scale * scale;
+		::BigInt r_lo = s2 / hi, r_hi = s2 / lo + ::BigInt(1);
+		::BigInt mid = (r_lo + r_hi) / ::BigInt(2);
+		DecimalBall res{mid, r_hi - mid + ::BigInt(1)};
+		if (a.mid.negative) res.mid = res.mid.negate();
+		return res;
+	}
+
+	// x^(1/n)
+	DecimalBall ball_root(const DecimalBall& a, int n, const ::BigInt& scale) {
+		bool neg = a.mid.negative;
+		::BigInt lo = a.mid.abs() - a.rad, hi = a.mid.abs() + a.rad;
+		if (neg && n % 2 == 0) {
+			if (lo > ::BigInt(0)) throw std::runtime_error("Square root of negative number");
+			throw PrecisionShortage();
+		}
+		if (lo.negative) {
+			if (n % 2 == 1) throw PrecisionShortage();
+			lo = ::BigInt(0);
+		}
+		::BigInt shift = scale.power(::BigInt(n - 1));
+		::BigInt r_lo = int_root(lo * shift, n), r_hi = int_root(hi * shift, n) + ::BigInt(1);
+		::BigInt mid = (r_lo + r_hi) / ::BigInt(2);
+		DecimalBall res{mid, r_hi - mid + ::BigInt(1)};
+		if (neg) res.mid = res.mid.negate();
+		return res;
+	}
+
+	DecimalBall ball_int_power(const DecimalBall& a, ::BigInt e, const ::BigInt& scale) {
+		bool inv = e.negative;
+		e = e.abs();
+		DecimalBall result{scale, ::BigInt(0)}, base = a;
+		while (!e.is_zero()) {
+			if (e.digits[0] % 2 == 1) result = ball_mul(result, base, scale);
+			e = e / ::BigInt(2);
+			if (!e.is_zero()) base = ball_mul(base, base, scale);
+		}
+		return inv ? ball_reciprocal(result, scale) : result;
+	}
+
+	DecimalBall ball_eval(const SymbolicExpr& expr, size_t p, const ::BigInt& scale) {
+		switch (expr.type) {
+			case SymbolicExpr::Type::Number: {
+				::Rational r = expr.convert_rational();
+				::BigInt scaled = r.get_numerator() * scale;
+				::BigInt q = scaled / r.get_denominator();
+				bool exact = (q * r.get_denominator()) == scaled;
+				return {q, ::BigInt(exact ? 0 : 1)};
+			}
+			case SymbolicExpr::Type::Variable:
+				if (expr.identifier == "π" || expr.identifier == "pi") return ball_pi(p);
+				if (expr.identifier == "e") return ball_e(p);
+				throw std::runtime_error("Symbolic variable cannot be converted to decimal");
+			case SymbolicExpr::Type::Sqrt:
+				return ball_root(ball_eval(*expr.operands[0], p, scale), 2, scale);
+			case SymbolicExpr::Type::Add: {
+				DecimalBall res{::BigInt(0), ::BigInt(0)};
+				for (const auto& op : expr.operands) {
+					auto b = ball_eval(*op, p, scale);
+					res.mid += b.mid;
+					res.rad += b.rad;
+				}
+				return res;
+			}
+			case SymbolicExpr::Type::Multiply: {
+				DecimalBall res{scale, ::BigInt(0)};
+				for (const auto& op : expr.operands) res = ball_mul(res, ball_eval(*op, p, scale), scale);
+				return res;
+			}
+			case SymbolicExpr::Type::Power: {
+				if (!expr.operands[1]->is_number()) throw std::runtime_error("Non-rational exponent cannot be converted to decimal");
+				::Rational ex = expr.operands[1]->convert_rational();
+				auto base = ball_eval(*expr.operands[0], p, scale);
+				auto powered = ball_int_power(base, ex.get_numerator(), scale);
+				::BigInt den = ex.get_denominator();
+				if (den == ::BigInt(1)) return powered;
+				if (den > ::BigInt(64)) throw std::runtime_error("Exponent denominator too large");
+				return ball_root(powered, den.to_int(), scale);
+			}
+			default:
+				throw std::runtime_error("Expression cannot be converted to decimal");
+		}
+	}
+}
+
+std::string SymbolicExpr::to_decimal_string(int digits) const {
+	if (digits < 0) digits = 0;
+	const size_t n = static_cast<size_t>(digits);
+	// 精度不够时逐步提高，直到区间两端截断后的结果一致；值恰好落在截断边界上时永远无法确认，到上限后报错
+	const size_t max_p = 4 * n + 1000;
+	::BigInt truncated;
+	bool certified = false;
+	for (size_t p = n + 10; p <= max_p && !certified; p += std::max<size_t>(p / 2, 10)) {
+		::BigInt scale = pow10_big(p);
+		DecimalBall b;
+		try {
+			b = ball_eval(*this, p, scale);
+		} catch (const PrecisionShortage&) {
+			continue;
+		}
+		::BigInt drop = pow10_big(p - n);
+		::BigInt lo = (b.mid - b.rad) / drop, hi = (b.mid + b.rad) / drop;
+		truncated = lo;
+		certified = lo == hi;
+	}
+	if (!certified) throw std::runtime_error("Cannot certify " + std::to_string(n) + " decimal digits of the expression");
+
+	bool neg = truncated.negative;
+	std::string body = truncated.abs().to_string();
+	if (body.size() <= n) body.insert(0, n + 1 - body.size(), '0');
+	if (n > 0) body.insert(body.end() - n, '.');
+	return neg ? "-" + body : body;
 }
 
 #ifdef _SYMBOLIC_DEBUG_CERR_OVERRIDDEN
@@ -10,6 +10,9 @@
 #include <map>
 #include <functional>
 #include <iostream>
+#include <cstddef>
+#include <memory_resource>
+#include <atomic>
 
 #define _SYMBOLIC_DEBUG 0
 
@@ -43,7 +46,11 @@ std::ostream nullstream(&nbf);
 // 符号表达式系统
 // 支持精确的数学表达式，不进行数值近似
 
-class LAMINA_API SymbolicExpr {
+class SymbolicProgram;
+
+class RewriteEngine;
+
+class LAMINA_API SymbolicExpr : public std::enable_shared_from_this<SymbolicExpr> {
 public:
     enum class Type {
         Number,      // 数字 (BigInt, Rational, int)
@@ -57,149 +64,6 @@ public:
         Variable     // 变量 (如 π, e)
 
     };
-	
-	/*
-	哈希要保证的一些因素：
-	- 乘法交换律（乘法：奇数二进制位参与运算）
-	- 加法交换律（加法：偶数二进制位参与运算）
-	- 加法和乘法区分
-	这个函数在加法化简时使用。
-	*/
-	struct HashData {
-#define _HASH_PARAMS		ODDBIT, EVENBIT, SQRBIT, HALFBIT
-		using HashType = unsigned long long;
-		// TODO: 允许多个 HashData 对象之间的不同以减少哈希冲突概率
-		// 下方变量的名字不重要。
-#define ODDBIT_D 0x555555555555555ull
-#define EVENBIT_D 0xAAAAAAAAAAAAAAAull
-#define SQRBIT_D 0xBDEEBD77BDEEBD7ull
-#define HALFBIT_D 0x969969669699696ull
-#define EMPTY 0ull
-#define INFINITY_D 0xFFF7FFFFDEADBEEFull
-#define PI_H 0x1451419810C0000ull
-#define E_H 0x9198101145C0000ull
-#define UNKNOWN_H 0xAD0AA0BEEFC0000ull
-		
-		HashType ODDBIT;
-		HashType EVENBIT;
-		HashType SQRBIT;
-		HashType HALFBIT;
-		
-		::Rational k = ::Rational(1), ksqrt = ::Rational(1);
-		HashType hash = EMPTY;
-		std::shared_ptr<SymbolicExpr> hash_obj = SymbolicExpr::number(1);	// 因为是乘法，1为默认状态。此处存储被 hash 的项目对应的值
-		
-		static HashType bigint_hash(const BigInt& rt) {
-			// 直接哈希所有 digits
-			HashType weight = 1ull, ans = 0ull;
-			for (auto &i : rt.digits) {
-				ans = ans * weight + (i + 3ull);
-				weight *= 17ull;			// 不用 10 减少哈希冲突
-			}
-			if (rt.negative) return ~ans;
-			return ans;
-		}
-		
-		static HashType rational_hash(const Rational& rt) {
-			return bigint_hash(rt.get_numerator()) ^ bigint_hash(rt.get_denominator());
-		}
-		
-		HashType to_single_hash() {
-			return (rational_hash(k) & HALFBIT) ^ (rational_hash(ksqrt) & SQRBIT) ^ hash;
-		}
-		
-		// TODO: 考虑优化
-		std::shared_ptr<SymbolicExpr> get_combined_k() {
-			return SymbolicExpr::multiply(SymbolicExpr::number(k), SymbolicExpr::sqrt(SymbolicExpr::number(ksqrt)))->simplify();
-		}
-		
-		HashData() {
-			
-		}
-		
-		HashData(std::shared_ptr<SymbolicExpr> obj, 
-			HashType ODDBIT = ODDBIT_D, HashType EVENBIT = EVENBIT_D, HashType SQRBIT = SQRBIT_D, HashType HALFBIT = HALFBIT_D)
-			: ODDBIT(ODDBIT), EVENBIT(EVENBIT), SQRBIT(SQRBIT), HALFBIT(HALFBIT) {
-			// Evaluate hash
-			HashData ld, rd;
-			HashType prehash = 0, rterm = 0;
-			switch (obj->type) {
-				case Type::Number:
-					this->k = obj->convert_rational();
-					err_stream << "[HPP Debug] Return as value " << k.to_string() << "\n";
-					break;
-				case Type::Infinity:
-					this->hash = INFINITY_D;
-					break;
-				
-				case Type::Sqrt:
-					ld = HashData(obj->operands[0], _HASH_PARAMS);
-					// sqrt 里面还有 sqrt，取值异或哈希
-					this->ksqrt = ld.k;
-					ld.k = ::Rational(0);
-					this->hash = ld.to_single_hash() * SQRBIT;	// 表明这是个 sqrt，里面没东西则恰好为 0
-					this->hash_obj = SymbolicExpr::sqrt(ld.hash_obj);
-					break;
-				case Type::Multiply:
-					ld = HashData(obj->operands[0], _HASH_PARAMS);
-					rd = HashData(obj->operands[1], _HASH_PARAMS);
-					this->k = ld.k * rd.k;
-					this->ksqrt = ld.ksqrt * rd.ksqrt;
-					this->hash = (obj->operands[0]->is_number() ? 1 : ld.hash) * (obj->operands[1]->is_number() ? 1 : rd.hash);
-					err_stream << "[HPP Debug] LDHash: " << ld.hash_obj->to_string() << ", RDHash: " << rd.hash_obj->to_string() << std::endl;
-					err_stream << "[HPP Debug] My hash value is " << this->hash << std::endl;
-					err_stream << "[HPP Debug] L applied: " << (obj->operands[0]->is_number() ? 1 : ld.hash) <<
-						", R applied: " << (obj->operands[1]->is_number() ? 1 : rd.hash) << std::endl;
-					if (!(ld.hash | rd.hash)) this->hash = 0;	// 里面没有东西
-					this->hash_obj = SymbolicExpr::multiply(ld.hash_obj, rd.hash_obj)->simplify();
-					break;
-				case Type::Add:
-					ld = HashData(obj->operands[0], _HASH_PARAMS);
-					rd = HashData(obj->operands[1], _HASH_PARAMS);
-					this->hash = ld.to_single_hash() + rd.to_single_hash();
-					this->hash_obj = obj;	// 没有做任何处理
-					break;
-				case Type::Power:
-					// TODO: 此处引入类似根式化简的机制，暂时直接 hash（可能有问题）
-					ld = HashData(obj->operands[0], _HASH_PARAMS);
-					rd = HashData(obj->operands[1], _HASH_PARAMS);
-					// 不是特别恰当，但可以先这样
-					// 保证 1，2，-1 等常见数值
-					rterm = rd.to_single_hash() - 1;
-					this->hash = ld.to_single_hash() ^ rterm ^ (rterm << 8) ^ (rterm << 16) ^ (rterm << 32);
-					this->hash_obj = obj;	// 没有做任何处理
-					break;
-				case Type::Variable:
-					if (obj->identifier == "π" || obj->identifier == "pi") this->hash = PI_H;
-					else if (obj->identifier == "e") this->hash = E_H;
-					else this->hash = UNKNOWN_H;
-					this->hash_obj = obj;	// 没有做任何处理
-					break;
-				default:
-					// 如果某个 hash 不能用就调过来
-					defs: this->hash = EMPTY;
-					for (auto &i : obj->operands) {
-						if (obj->type == Type::Add) {
-							this->hash += HashData(i).to_single_hash();	// 令其自然溢出，同时避免异或消除
-						} else {
-							this->hash *= HashData(i).to_single_hash() + 1;	// 令其自然溢出，同时避免异或消除
-						}
-					}
-					this->hash ^= prehash;
-					this->hash_obj = obj;
-			}
-			// TODO: 可能考虑在这里做根式化简
-		}
-#undef ODDBIT_D
-#undef EVENBIT_D
-#undef SQRBIT_D
-#undef HALFBIT_D
-#undef EMPTY
-#undef INFINITY_D
-#undef PI_H
-#undef E_H
-#undef UNKNOWN_H		
-	};
 
     Type type;
 
@@ -212,88 +76,166 @@ public:
     // 字符串标识（用于变量名或操作符）
     std::string identifier;
 
-	// 是否已经化简完成
-	bool already_simplified = false;
+	// 是否已经化简完成（驻留节点可能被多个线程同时化简）
+	std::atomic<bool> already_simplified = false;
 
     // 构造函数
     SymbolicExpr(Type t) : type(t) {}
 
+	// 复制得到的节点不在驻留表中，且可能被修改，因此不继承哈希缓存和化简标记
+	SymbolicExpr(const SymbolicExpr& other)
+		: std::enable_shared_from_this<SymbolicExpr>(), type(other.type), number_value(other.number_value),
+		  operands(other.operands), identifier(other.identifier) {}
+	SymbolicExpr& operator=(const SymbolicExpr& other) {
+		type = other.type;
+		number_value = other.number_value;
+		operands = other.operands;
+		identifier = other.identifier;
+		already_simplified = false;
+		hash_cached = false;
+		interned = false;
+		simplified_cache.reset();
+		program_cache.reset();
+		return *this;
+	}
+
+	// 节点内存池：节点与 shared_ptr 控制块一次分配，释放后由池复用
+	static std::pmr::memory_resource* node_pool();
+
+	template <typename... Args>
+	static std::shared_ptr<SymbolicExpr> make_node(Args&&... args) {
+		return std::allocate_shared<SymbolicExpr>(
+			std::pmr::polymorphic_allocator<SymbolicExpr>(node_pool()), std::forward<Args>(args)...);
+	}
+
+	// 结构哈希（结果缓存在节点内）
+	std::size_t structural_hash() const;
+
+	// 结构相等：驻留节点之间直接比较指针
+	static bool structurally_equal(const std::shared_ptr<SymbolicExpr>& a, const std::shared_ptr<SymbolicExpr>& b);
+
+	// 哈希共享（hash-consing）：结构相同的节点只保留一份
+	// 驻留后的节点不应再被修改，需要修改时先复制
+	static std::shared_ptr<SymbolicExpr> intern(std::shared_ptr<SymbolicExpr> expr);
+
+	// 驻留表中的节点数（包括尚未清理的失效项）
+	static std::size_t intern_table_size();
+
+	bool is_interned() const { return interned; }
+
     // 数字构造函数
     static std::shared_ptr<SymbolicExpr> number(int n) {
-        auto expr = std::make_shared<SymbolicExpr>(Type::Number);
+        auto expr = make_node(Type::Number);
         expr->number_value = n;
-        return expr;
+        return intern(expr);
     }
 
     static std::shared_ptr<SymbolicExpr> number(const ::BigInt& bi) {
-        auto expr = std::make_shared<SymbolicExpr>(Type::Number);
+        auto expr = make_node(Type::Number);
         expr->number_value = bi;
-        return expr;
+        return intern(expr);
     }
 
     static std::shared_ptr<SymbolicExpr> number(const ::Rational& r) {
-        auto expr = std::make_shared<SymbolicExpr>(Type::Number);
+        auto expr = make_node(Type::Number);
         expr->number_value = r;
-        return expr;
+        return intern(expr);
+    }
+
+    // 有理数常量：整数能放进 int 时用 int 表示，与其余化简规则一致
+    static std::shared_ptr<SymbolicExpr> exact_number(const ::Rational& q) {
+        if (!q.is_integer()) return number(q);
+        const ::BigInt n = q.get_numerator();
+        if (n >= ::BigInt(INT_MIN) && n <= ::BigInt(INT_MAX)) return number(n.to_int());
+        return number(n);
     }
 
 	static std::shared_ptr<SymbolicExpr> infinity(int k = 1) {
-		auto expr = std::make_shared<SymbolicExpr>(Type::Infinity);
+		auto expr = make_node(Type::Infinity);
 		expr->number_value = k;
-		return expr;
+		return intern(expr);
 	}
 
     // 平方根构造函数
     static std::shared_ptr<SymbolicExpr> sqrt(std::shared_ptr<SymbolicExpr> operands) {
-        auto expr = std::make_shared<SymbolicExpr>(Type::Sqrt);
+        auto expr = make_node(Type::Sqrt);
         expr->operands.push_back(operands);
-        return expr;
+        return intern(expr);
     }
 
     // 乘法构造函数
     static std::shared_ptr<SymbolicExpr> multiply(std::shared_ptr<SymbolicExpr> left, std::shared_ptr<SymbolicExpr> right) {
-        auto expr = std::make_shared<SymbolicExpr>(Type::Multiply);
+        auto expr = make_node(Type::Multiply);
         if (right->is_number()) {
             // 将数字移至前端
             expr->operands.push_back(right);
             expr->operands.push_back(left);
-            return expr;
+            return intern(expr);
         }
         expr->operands.push_back(left);
         expr->operands.push_back(right);
-        return expr;
+        return intern(expr);
     }
 
     // 加法构造函数
     static std::shared_ptr<SymbolicExpr> add(std::shared_ptr<SymbolicExpr> left, std::shared_ptr<SymbolicExpr> right) {
-        auto expr = std::make_shared<SymbolicExpr>(Type::Add);
+        auto expr = make_node(Type::Add);
         expr->operands.push_back(left);
         expr->operands.push_back(right);
-        return expr;
+        return intern(expr);
+    }
+
+    // n 元加法构造函数，项按给定顺序保存
+    static std::shared_ptr<SymbolicExpr> add(const std::vector<std::shared_ptr<SymbolicExpr>>& terms) {
+        if (terms.empty()) return number(0);
+        if (terms.size() == 1) return terms[0];
+        auto expr = make_node(Type::Add);
+        expr->operands = terms;
+        return intern(expr);
+    }
+
+    // n 元乘法构造函数，数字因子移至前端
+    static std::shared_ptr<SymbolicExpr> multiply(const std::vector<std::shared_ptr<SymbolicExpr>>& factors) {
+        if (factors.empty()) return number(1);
+        if (factors.size() == 1) return factors[0];
+        auto expr = make_node(Type::Multiply);
+        expr->operands = factors;
+        std::stable_partition(expr->operands.begin(), expr->operands.end(),
+            [](const std::shared_ptr<SymbolicExpr>& f) { return f->is_number(); });
+        return intern(expr);
     }
 
     // 幂次构造函数
     static std::shared_ptr<SymbolicExpr> power(std::shared_ptr<SymbolicExpr> base, std::shared_ptr<SymbolicExpr> exponent) {
 
         // 直接符号储存
-        auto expr = std::make_shared<SymbolicExpr>(Type::Power);
+        auto expr = make_node(Type::Power);
         expr->operands.push_back(base);
         expr->operands.push_back(exponent);
-        return expr;
+        return intern(expr);
     }
 
     // 变量构造函数
     static std::shared_ptr<SymbolicExpr> variable(const std::string& name) {
-        auto expr = std::make_shared<SymbolicExpr>(Type::Variable);
+        auto expr = make_node(Type::Variable);
         expr->identifier = name;
-        return expr;
+        return intern(expr);
     }
 
     // 化简表达式
     std::shared_ptr<SymbolicExpr> simplify() const;
 
+	// 规范顺序：返回负数、0 或正数；数字最前，幂与同底的非幂项相邻，π、e 排在其他变量前
+	static int compare(const std::shared_ptr<SymbolicExpr>& a, const std::shared_ptr<SymbolicExpr>& b);
+	// 乘法因子按规范顺序升序排列
+	static void sort_factors(std::vector<std::shared_ptr<SymbolicExpr>>& factors);
+	// 加法项按次数降序排列，同次数时按底数的字典序（π^2·e 在 π·e^2 前），常数在最后
+	static void sort_terms(std::vector<std::shared_ptr<SymbolicExpr>>& terms);
+
     // 转换为字符串表示
     std::string to_string() const;
+    // 追加到 out 末尾，避免递归拼接临时字符串
+    void write_to(std::string& out) const;
 
     // 检查是否为数字
     bool is_number() const { return type == Type::Number; }
@@ -344,12 +286,73 @@ public:
 	
 
     // 尝试计算数值（如果可能的话）
+    // 驻留节点的编译结果缓存在节点上，重复求值不再遍历表达式树
     double to_double() const;
 
+    // 编译为扁平的栈式指令序列，用于同一表达式的大量数值求值
+    // variables 为自由变量的槽位顺序（π、e 是常数，不占槽位）；不含自由变量的子树在编译时折叠为常数
+    SymbolicProgram compile(const std::vector<std::string>& variables = {}) const;
+
+    // 任意精度数值：保留 digits 位小数（截断），用区间运算保证输出的每一位都准确
+    // 无法确认每一位时（如值恰好落在截断边界上）抛出 std::runtime_error，不返回未经确认的结果
+    std::string to_decimal_string(int digits) const;
+
 private:
+	// 哈希缓存与驻留标记，不参与复制
+	mutable std::size_t hash_value = 0;
+	mutable bool hash_cached = false;
+	bool interned = false;
+	// 驻留节点的化简结果，强引用，与本节点同生存期；结果中含有本节点时不缓存，以免循环引用
+	mutable std::shared_ptr<SymbolicExpr> simplified_cache;
+	// 驻留节点的编译结果，to_double 使用
+	mutable std::shared_ptr<const SymbolicProgram> program_cache;
+
     // 内部化简函数
-    std::shared_ptr<SymbolicExpr> simplify_sqrt() const;
-    std::shared_ptr<SymbolicExpr> simplify_multiply() const;
-    std::shared_ptr<SymbolicExpr> simplify_add() const;
-    std::shared_ptr<SymbolicExpr> simplify_power() const;
+    // 按头部类型和操作数形状索引的改写规则，首次使用时构建
+    static const RewriteEngine& rewrite_engine();
+    std::shared_ptr<SymbolicExpr> simplify_step() const;
+    // 改写规则的动作：操作数均已化简，规则不适用时返回 nullptr
+    std::shared_ptr<SymbolicExpr> sqrt_number() const;
+    std::shared_ptr<SymbolicExpr> sqrt_square() const;
+    std::shared_ptr<SymbolicExpr> multiply_flatten() const;
+    std::shared_ptr<SymbolicExpr> multiply_divide() const;
+    std::shared_ptr<SymbolicExpr> multiply_expand() const;
+    std::shared_ptr<SymbolicExpr> multiply_collect() const;
+    std::shared_ptr<SymbolicExpr> add_flatten() const;
+    std::shared_ptr<SymbolicExpr> add_collect() const;
+    std::shared_ptr<SymbolicExpr> power_of_number() const;
+    std::shared_ptr<SymbolicExpr> root_of_number() const;
+    std::shared_ptr<SymbolicExpr> power_of_power() const;
+    std::shared_ptr<SymbolicExpr> power_rationalize() const;
+    std::shared_ptr<SymbolicExpr> power_reciprocal() const;
+    std::shared_ptr<SymbolicExpr> power_expand() const;
+};
+
+// SymbolicExpr::compile 的结果：后序排列的栈式指令
+class LAMINA_API SymbolicProgram {
+public:
+    enum class Op : unsigned char {
+        Const,      // 压入 value
+        Load,       // 压入第 arg 个变量
+        Add,        // 弹出 arg 个值，压入和
+        Mul,        // 弹出 arg 个值，压入积
+        Pow,        // 弹出底数和指数，压入幂
+        Sqrt        // 栈顶开平方
+    };
+
+    struct Instr {
+        Op op;
+        unsigned int arg = 0;
+        double value = 0.0;
+    };
+
+    std::vector<Instr> code;
+    std::vector<std::string> variables;
+    size_t max_stack = 0;
+
+    // bindings 按 variables 的顺序给出，不含自由变量时可以为 nullptr
+    double evaluate(const double* bindings) const;
+    double evaluate(const std::vector<double>& bindings) const {
+        return evaluate(bindings.data());
+    }
 };
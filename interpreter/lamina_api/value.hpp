@@ -1,14 +1,21 @@
 #pragma once
 #include "bigint.hpp"
+#include "exact.hpp"
+#include "gemm.hpp"
 #include "irrational.hpp"
+#include "numarray.hpp"
 #include "rational.hpp"
 #include "symbolic.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <functional>
 #include <iostream>
 #include <set>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <variant>
@@ -42,64 +49,80 @@ struct LmCppFunction {
 struct LambdaDeclExpr;
 class lmStruct;
 LAMINA_API std::string lStruct_to_string(const std::shared_ptr<lmStruct>& lstruct);
+LAMINA_API void lStruct_write_to(const std::shared_ptr<lmStruct>& lstruct, std::string& out);
+
+// CAS 表达式树，定义在 extensions/standard/cas.hpp
+namespace LaminaCAS {
+    class Expr;
+}
+LAMINA_API void cas_expr_write_to(const std::shared_ptr<const LaminaCAS::Expr>& expr, std::string& out);
 
 class LAMINA_API Value final {
 public:
-    enum class Type {
+    enum class Type : unsigned char {
         Lambda, lmStruct, Symbolic,
         lmModule, lmCppFunction,
         Null, Bool, Infinity,
         Int, Float, BigInt,
         lmInt, lmDecimal, // 预留
         Rational, Irrational,
-        String, Array, Set, Matrix }; // ToDO: 完善set相关函数
+        String, Array, Set, Matrix, // ToDO: 完善set相关函数
+        CasExpr, NumArray };
     Type type;
 
-	using DataType = std::variant<
-		std::nullptr_t,
-		bool, int, double, std::string,
-		std::shared_ptr<LmModule>,
-		std::shared_ptr<LmCppFunction>,
-		std::set<Value>,
-		std::vector<Value>,
-		std::vector<std::vector<Value>>,
-		std::vector<std::pair<std::string, Value>>,
-		::BigInt, ::Rational, ::Irrational,
-		std::shared_ptr<SymbolicExpr>,
-		std::shared_ptr<lmStruct>,
-		std::shared_ptr<LambdaDeclExpr>>;
-
-    DataType data;
-
-    ~Value() = default;
+    // 值为 16 字节：类型标记 + 8 字节负载
+    // null/bool/int/double 直接存放在负载里，其余类型放在带引用计数的堆单元中，
+    // 复制 Value 只增加引用计数，修改时（get_mut）若单元被共享则先复制一份（写时复制）
+    using Alternatives = std::tuple<
+        std::nullptr_t,
+        bool, int, double, std::string,
+        std::shared_ptr<LmModule>,
+        std::shared_ptr<LmCppFunction>,
+        std::set<Value>,
+        std::vector<Value>,
+        std::vector<std::vector<Value>>,
+        std::vector<std::pair<std::string, Value>>,
+        ::BigInt, ::Rational, ::Irrational,
+        std::shared_ptr<SymbolicExpr>,
+        std::shared_ptr<lmStruct>,
+        std::shared_ptr<LambdaDeclExpr>,
+        std::shared_ptr<const LaminaCAS::Expr>,
+        ::NumArray>;
 
     // Constructors
-    Value() : type(Type::Null), data(std::in_place_index<0>, nullptr) {}// 0对应std::nullptr_t类型
+    Value() : type(Type::Null) {}
 
-    // 其他构造函数需要同步修改初始化方式
-    Value(std::nullptr_t) : type(Type::Null), data(std::in_place_index<0>, nullptr) {}
-    Value(bool b) : type(Type::Bool), data(std::in_place_index<1>, b) {}
-    Value(int i) : type(Type::Int), data(std::in_place_index<2>, i) {}
-	Value(double f) : type(Type::Float), data(std::in_place_index<3>, f) {
+    Value(std::nullptr_t) : type(Type::Null) {}
+    Value(bool b) : type(Type::Bool) { emplace<bool>(b); }
+    Value(int i) : type(Type::Int) { emplace<int>(i); }
+	Value(double f) : type(Type::Float) {
 		int res = std::isinf(f);
 		if (res) {
 			if (f < 0) res = -1;
 			this->type = Type::Infinity;
-			this->data = DataType(std::in_place_index<2>, res);
+			emplace<int>(res);
+		} else {
+			emplace<double>(f);
 		}
 	}
-    Value(const std::string& s) : type(Type::String), data(s) {}
-    Value(const char* s) : type(Type::String), data(std::string(s)) {}
-    Value(const char s) : type(Type::String), data(std::string(1,s)) {}
-    Value(const ::BigInt& bi) : type(Type::BigInt), data(bi) {}
-    Value(const ::Rational& r) : type(Type::Rational), data(r) {}
-    Value(const ::Irrational& ir) : type(Type::Irrational), data(ir) {}
-    Value(const std::shared_ptr<lmStruct>& lstruct) : type(Type::lmStruct), data(lstruct) {}
-    Value(const std::set<Value>& set) : type(Type::Set), data(set) {}
-    Value(const std::shared_ptr<LambdaDeclExpr>& func_def_stmt) : type(Type::Lambda), data(func_def_stmt) {}
-    Value(const std::shared_ptr<SymbolicExpr>& sym) : type(Type::Symbolic), data(sym) {}
-    Value(const std::shared_ptr<LmCppFunction>& func) : type(Type::lmCppFunction), data(func) {}
-    Value(const std::shared_ptr<LmModule>& module) : type(Type::lmModule), data(module) {}
+    Value(const std::string& s) : type(Type::String) { emplace<std::string>(s); }
+    Value(std::string&& s) : type(Type::String) { emplace<std::string>(std::move(s)); }
+    Value(const char* s) : type(Type::String) { emplace<std::string>(s); }
+    Value(const char s) : type(Type::String) { emplace<std::string>(1, s); }
+    Value(const ::BigInt& bi) : type(Type::BigInt) { emplace<::BigInt>(bi); }
+    Value(const ::Rational& r) : type(Type::Rational) { emplace<::Rational>(r); }
+    Value(const ::Irrational& ir) : type(Type::Irrational) { emplace<::Irrational>(ir); }
+    Value(const std::shared_ptr<lmStruct>& lstruct) : type(Type::lmStruct) { emplace<std::shared_ptr<lmStruct>>(lstruct); }
+    Value(const std::set<Value>& set) : type(Type::Set) { emplace<std::set<Value>>(set); }
+    Value(const std::shared_ptr<LambdaDeclExpr>& func_def_stmt) : type(Type::Lambda) { emplace<std::shared_ptr<LambdaDeclExpr>>(func_def_stmt); }
+    Value(const std::shared_ptr<SymbolicExpr>& sym) : type(Type::Symbolic) { emplace<std::shared_ptr<SymbolicExpr>>(sym); }
+    Value(const std::shared_ptr<LmCppFunction>& func) : type(Type::lmCppFunction) { emplace<std::shared_ptr<LmCppFunction>>(func); }
+    Value(const std::shared_ptr<LmModule>& module) : type(Type::lmModule) { emplace<std::shared_ptr<LmModule>>(module); }
+    // 已解析的 CAS 表达式，树不可变，可在多个值之间共享
+    Value(const std::shared_ptr<const LaminaCAS::Expr>& expr) : type(Type::CasExpr) { emplace<std::shared_ptr<const LaminaCAS::Expr>>(expr); }
+    // 同类型数值数组，元素连续存放
+    Value(const ::NumArray& arr) : type(Type::NumArray) { emplace<::NumArray>(arr); }
+    Value(::NumArray&& arr) : type(Type::NumArray) { emplace<::NumArray>(std::move(arr)); }
     Value(const std::vector<Value>& arr) {
         // Check if this is a matrix (array of arrays)
         bool is_matrix = !arr.empty() && arr[0].is_array();
@@ -108,24 +131,86 @@ public:
             std::vector<std::vector<Value>> matrix;
             for (const auto& row: arr) {
                 if (row.is_array()) {
-                    matrix.push_back(std::get<std::vector<Value>>(row.data));
+                    matrix.push_back(row.get<std::vector<Value>>());
                 } else {
                     // Mixed types, treat as array
                     type = Type::Array;
-                    data = arr;
+                    emplace<std::vector<Value>>(arr);
                     return;
                 }
             }
             type = Type::Matrix;
-            data = matrix;
+            emplace<std::vector<std::vector<Value>>>(std::move(matrix));
         } else {
             type = Type::Array;
-            data = arr;
+            emplace<std::vector<Value>>(arr);
+        }
+    }
+
+
+    Value(const std::vector<std::vector<Value>>& mat) : type(Type::Matrix) { emplace<std::vector<std::vector<Value>>>(mat); }
+
+    Value(const Value& other) : type(other.type), kind(other.kind), payload(other.payload) {
+        if (boxed()) payload.cell->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    Value(Value&& other) noexcept : type(other.type), kind(other.kind), payload(other.payload) {
+        other.type = Type::Null;
+        other.kind = 0;
+    }
+    Value& operator=(const Value& other) {
+        if (this != &other) {
+            Value tmp(other);
+            swap(tmp);
         }
+        return *this;
+    }
+    Value& operator=(Value&& other) noexcept {
+        if (this != &other) {
+            Value tmp(std::move(other));
+            swap(tmp);
+        }
+        return *this;
+    }
+    ~Value() {
+        release();
+    }
+
+    void swap(Value& other) noexcept {
+        std::swap(type, other.type);
+        std::swap(kind, other.kind);
+        std::swap(payload, other.payload);
     }
 
+    // 负载访问，类型不符时抛出 std::bad_variant_access
+    template<class T>
+    bool holds() const { return kind == index_of<T>(); }
 
-    Value(const std::vector<std::vector<Value>>& mat) : type(Type::Matrix), data(mat) {}
+    template<class T>
+    const T& get() const {
+        if (!holds<T>()) throw std::bad_variant_access();
+        return *ptr<T>();
+    }
+
+    template<class T>
+    const T* get_if() const {
+        return holds<T>() ? ptr<T>() : nullptr;
+    }
+
+    // 取可修改的引用；堆单元被其他 Value 共享时先复制
+    template<class T>
+    T& get_mut() {
+        if (!holds<T>()) throw std::bad_variant_access();
+        if constexpr (!is_immediate<T>()) {
+            if (payload.cell->refs.load(std::memory_order_acquire) != 1) {
+                Cell* copy = payload.cell->clone();
+                const unsigned char k = kind;
+                release();
+                kind = k;
+                payload.cell = copy;
+            }
+        }
+        return const_cast<T&>(*ptr<T>());
+    }
 
     // Type checking helpers
     bool is_null() const { return type == Type::Null; }
@@ -136,6 +221,8 @@ public:
     bool is_string() const { return type == Type::String; }
     bool is_array() const { return type == Type::Array; }
     bool is_matrix() const { return type == Type::Matrix; }
+    bool is_cas_expr() const { return type == Type::CasExpr; }
+    bool is_numarray() const { return type == Type::NumArray; }
     bool is_bigint() const { return type == Type::BigInt; }
     bool is_rational() const { return type == Type::Rational; }
     bool is_set() const { return type == Type::Set; }
@@ -148,12 +235,12 @@ public:
     bool is_numeric() const { return type == Type::Int || type == Type::Float || type == Type::BigInt || type == Type::Rational || type == Type::Irrational || type == Type::Symbolic; }
     // Get numeric value as double
     double as_number() const {
-		if (type == Type::Infinity) return (1.0 * std::get<int>(data) / 0.0);
-		if (type == Type::Int) return static_cast<double>(std::get<int>(data));
-        if (type == Type::Float) return std::get<double>(data);
+		if (type == Type::Infinity) return (1.0 * get<int>() / 0.0);
+		if (type == Type::Int) return static_cast<double>(get<int>());
+        if (type == Type::Float) return get<double>();
         if (type == Type::BigInt) {
             // For BigInt, try to convert to int first, then to double
-            const auto& bigint_val = std::get<::BigInt>(data);
+            const auto& bigint_val = get<::BigInt>();
             int int_val = bigint_val.to_int();
             if (int_val == INT_MAX || int_val == INT_MIN) {
                 // BigInt was too large for int, use double conversion
@@ -162,48 +249,45 @@ public:
             return static_cast<double>(int_val);
         }
         if (type == Type::Rational) {
-            return std::get<::Rational>(data).to_double();
+            return get<::Rational>().to_double();
         }
         if (type == Type::Irrational) {
-            return std::get<::Irrational>(data).to_double();
+            return get<::Irrational>().to_double();
         }
         if (type == Type::Symbolic) {
-            return std::get<std::shared_ptr<SymbolicExpr>>(data)->to_double();
+            return get<std::shared_ptr<SymbolicExpr>>()->to_double();
         }
         return 0.0;
     }
 
     // Get numeric value as Rational (for precise calculations)
     ::Rational as_rational() const {
-        if (type == Type::Rational) return std::get<::Rational>(data);
-        if (type == Type::Int) return ::Rational(std::get<int>(data));
-        if (type == Type::Float) return ::Rational::from_double(std::get<double>(data));
+        if (type == Type::Rational) return get<::Rational>();
+        if (type == Type::Int) return ::Rational(get<int>());
+        if (type == Type::Float) return ::Rational::from_double(get<double>());
         if (type == Type::BigInt) {
-            int int_val = std::get<::BigInt>(data).to_int();
+            int int_val = get<::BigInt>().to_int();
             return ::Rational(int_val);
         }
         if (type == Type::Irrational) {
-            return ::Rational::from_double(std::get<::Irrational>(data).to_double());
+            return ::Rational::from_double(get<::Irrational>().to_double());
         }
         return ::Rational(0);
     }
 
     // Get numeric value as Irrational (for exact irrational calculations)
     ::Irrational as_irrational() const {
-        if (type == Type::Irrational) return std::get<::Irrational>(data);
-        if (type == Type::Int) return ::Irrational::constant(std::get<int>(data));
-        if (type == Type::Float) return ::Irrational::constant(std::get<double>(data));
-        if (type == Type::Rational) return ::Irrational::constant(std::get<::Rational>(data).to_double());
-        if (type == Type::BigInt) {
-            int int_val = std::get<::BigInt>(data).to_int();
-            return ::Irrational::constant(int_val);
-        }
-        return ::Irrational::constant(0);
+        if (type == Type::Irrational) return get<::Irrational>();
+        if (type == Type::Int) return ::Irrational::constant(::Rational(get<int>()));
+        if (type == Type::Float) return ::Irrational::constant(get<double>());
+        if (type == Type::Rational) return ::Irrational::constant(get<::Rational>());
+        if (type == Type::BigInt) return ::Irrational::constant(::Rational(get<::BigInt>()));
+        return ::Irrational();
     }
 
 	std::shared_ptr<SymbolicExpr> as_symbolic() const {
-		if (type == Type::Infinity) return SymbolicExpr::infinity(std::get<int>(data));
-		if (type == Type::Symbolic) return std::get<std::shared_ptr<SymbolicExpr>>(data);
+		if (type == Type::Infinity) return SymbolicExpr::infinity(get<int>());
+		if (type == Type::Symbolic) return get<std::shared_ptr<SymbolicExpr>>();
 		if (type == Type::Int || type == Type::Float || type == Type::Rational || type == Type::BigInt) {
 			return SymbolicExpr::number(as_rational());
 		}
@@ -223,105 +307,143 @@ public:
     // Get boolean value
     bool as_bool() const {
 		if (type == Type::Infinity) return true;
-		if (type == Type::Bool) return std::get<bool>(data);
-        if (type == Type::Int) return std::get<int>(data) != 0;
-        if (type == Type::Float) return std::get<double>(data) != 0.0;
-        if (type == Type::BigInt) return !std::get<::BigInt>(data).is_zero();
-        if (type == Type::Rational) return !std::get<::Rational>(data).is_zero();
-        if (type == Type::Irrational) return !std::get<::Irrational>(data).is_zero();
-        if (type == Type::String) return !std::get<std::string>(data).empty();
-        if (type == Type::Array) return !std::get<std::vector<Value>>(data).empty();
+		if (type == Type::Bool) return get<bool>();
+        if (type == Type::Int) return get<int>() != 0;
+        if (type == Type::Float) return get<double>() != 0.0;
+        if (type == Type::BigInt) return !get<::BigInt>().is_zero();
+        if (type == Type::Rational) return !get<::Rational>().is_zero();
+        if (type == Type::Irrational) return !get<::Irrational>().is_zero();
+        if (type == Type::String) return !get<std::string>().empty();
+        if (type == Type::Array) return !get<std::vector<Value>>().empty();
+        if (type == Type::NumArray) return get<::NumArray>().size() != 0;
+        if (type == Type::CasExpr) return true;
         return false;
     }
 
     // String conversion
     std::string to_string() const {
+        std::string out;
+        write_to(out);
+        return out;
+    }
+
+    // 追加到 out 末尾；数组、矩阵、结构体等嵌套值全部写入同一个缓冲区
+    void write_to(std::string& out) const {
         switch (type) {
 			case Type::Infinity:
-			return std::get<int>(data) > 0 ? "inf" : "-inf";
+				out += get<int>() > 0 ? "inf" : "-inf";
+				return;
 			case Type::Null:
-                return "null";
+                out += "null";
+                return;
             case Type::Bool:
-                return std::get<bool>(data) ? "true" : "false";
+                out += get<bool>() ? "true" : "false";
+                return;
             case Type::Int:
-                return std::to_string(std::get<int>(data));
+                out += std::to_string(get<int>());
+                return;
             case Type::Float: {
-                double val = std::get<double>(data);
+                double val = get<double>();
                 // Remove trailing zeros for cleaner output
                 std::string str = std::to_string(val);
                 str.erase(str.find_last_not_of('0') + 1, std::string::npos);
                 str.erase(str.find_last_not_of('.') + 1, std::string::npos);
-                return str;
+                out += str;
+                return;
             }
             case Type::String:
-                return std::get<std::string>(data);
+                out += get<std::string>();
+                return;
             case Type::Array: {
-                std::string res = "[";
-                const auto& arr = std::get<std::vector<Value>>(data);
+                out += '[';
+                const auto& arr = get<std::vector<Value>>();
                 for (size_t i = 0; i < arr.size(); ++i) {
-                    if (i) res += ", ";
-                    res += arr[i].to_string();
+                    if (i) out += ", ";
+                    arr[i].write_to(out);
                 }
-                res += "]";
-                return res;
+                out += ']';
+                return;
             }
             case Type::Matrix: {
-                std::string res = "[";
-                const auto& mat = std::get<std::vector<std::vector<Value>>>(data);
+                out += '[';
+                const auto& mat = get<std::vector<std::vector<Value>>>();
                 for (size_t i = 0; i < mat.size(); ++i) {
-                    if (i) res += ", ";
-                    res += "[";
+                    if (i) out += ", ";
+                    out += '[';
                     for (size_t j = 0; j < mat[i].size(); ++j) {
-                        if (j) res += ", ";
-                        res += mat[i][j].to_string();
+                        if (j) out += ", ";
+                        mat[i][j].write_to(out);
                     }
-                    res += "]";
+                    out += ']';
                 }
-                res += "]";
-                return res;
-            }
-            case Type::BigInt: {
-                return std::get<::BigInt>(data).to_string();
-            }
-            case Type::Rational: {
-                return std::get<::Rational>(data).to_string();
-            }
-            case Type::Irrational: {
-                return std::get<::Irrational>(data).to_string();
-            }
-            case Type::Symbolic: {
-                return std::get<std::shared_ptr<SymbolicExpr>>(data)->to_string();
-            }
-            case Type::lmStruct: {
-                return lStruct_to_string(std::get<std::shared_ptr<lmStruct>>(data));
-            }
-            case Type::Lambda: {
-                const auto* func_ptr = std::get<std::shared_ptr<LambdaDeclExpr>>(data).get();
-                std::stringstream ss;
-                ss << std::hex << func_ptr;// 以十六进制格式输出指针地址
-                return "<Lamina lambda at " + ss.str() + ">";
+                out += ']';
+                return;
             }
+            case Type::BigInt:
+                get<::BigInt>().write_to(out);
+                return;
+            case Type::Rational:
+                get<::Rational>().write_to(out);
+                return;
+            case Type::Irrational:
+                get<::Irrational>().write_to(out);
+                return;
+            case Type::Symbolic:
+                get<std::shared_ptr<SymbolicExpr>>()->write_to(out);
+                return;
+            case Type::lmStruct:
+                lStruct_write_to(get<std::shared_ptr<lmStruct>>(), out);
+                return;
+            case Type::Lambda:
+                write_pointer(out, "<Lamina lambda at ", get<std::shared_ptr<LambdaDeclExpr>>().get());
+                return;
             case Type::Set: {
-                std::string text = "{";
-                for (const auto & i: std::get<std::set<Value>>(data)) {
-                    text += i.to_string() + ", ";
+                out += '{';
+                for (const auto& i : get<std::set<Value>>()) {
+                    i.write_to(out);
+                    out += ", ";
                 }
-                return text + "}";
-            }
-            case Type::lmCppFunction: {
-                const auto* cpp_funv__ptr = std::get<std::shared_ptr<LmCppFunction>>(data).get();
-                std::stringstream ss;
-                ss << std::hex << cpp_funv__ptr;// 以十六进制格式输出指针地址
-                return "<Lamina c++ function at " + ss.str() + ">";
+                out += '}';
+                return;
             }
-            case Type::lmModule: {
-                const auto* module_ptr = std::get<std::shared_ptr<LmModule>>(data).get();
-                std::stringstream ss;
-                ss << std::hex << module_ptr;// 以十六进制格式输出指针地址
-                return "<Lamina module at " + ss.str() + ">";
+            case Type::lmCppFunction:
+                write_pointer(out, "<Lamina c++ function at ", get<std::shared_ptr<LmCppFunction>>().get());
+                return;
+            case Type::lmModule:
+                write_pointer(out, "<Lamina module at ", get<std::shared_ptr<LmModule>>().get());
+                return;
+            case Type::CasExpr:
+                cas_expr_write_to(get<std::shared_ptr<const LaminaCAS::Expr>>(), out);
+                return;
+            case Type::NumArray: {
+                // 多维数组按行优先顺序输出，下标进位时补上对应层数的括号
+                const auto& arr = get<::NumArray>();
+                const auto& shape = arr.shape();
+                const size_t n = arr.size();
+                if (n == 0) {
+                    out.append(shape.size(), '[');
+                    out.append(shape.size(), ']');
+                    return;
+                }
+                std::vector<size_t> idx(shape.size(), 0);
+                for (size_t i = 0; i < n; ++i) {
+                    size_t open = 0;
+                    while (open < shape.size() && idx[shape.size() - 1 - open] == 0) open++;
+                    if (i) out += ", ";
+                    out.append(open, '[');
+                    if (arr.is_integral()) out += std::to_string(arr.integer(i));
+                    else Value(arr.number(i)).write_to(out);
+                    size_t close = 0;
+                    for (size_t d = shape.size(); d-- > 0; close++) {
+                        if (++idx[d] < shape[d]) break;
+                        idx[d] = 0;
+                    }
+                    out.append(close, ']');
+                }
+                return;
             }
             default:
-                return "<unknown>";
+                out += "<unknown>";
         }
     }
 
@@ -333,6 +455,40 @@ public:
         return false;
     }
 
+    // 类型化数组按行优先顺序的第 i 个元素；int64 超出 int 范围时返回 BigInt
+    static Value numarray_element(const ::NumArray& arr, size_t i) {
+        if (!arr.is_integral()) return Value(arr.number(i));
+        const std::int64_t v = arr.integer(i);
+        if (v >= INT_MIN && v <= INT_MAX) return Value(static_cast<int>(v));
+        return Value(::BigInt(std::to_string(v)));
+    }
+
+    // 矩阵按行优先写入 out；各行长度须为 cols 且元素为数值
+    static bool pack_matrix(const std::vector<std::vector<Value>>& mat, size_t cols, double* out) {
+        for (const auto& row: mat) {
+            if (row.size() != cols) {
+                std::cerr << "Error: Invalid matrix dimensions for multiplication" << std::endl;
+                return false;
+            }
+            for (const auto& elem: row) {
+                if (!elem.is_numeric()) {
+                    std::cerr << "Error: Matrix elements must be numeric" << std::endl;
+                    return false;
+                }
+                *out++ = elem.as_number();
+            }
+        }
+        return true;
+    }
+
+    // 有理数结果为整数时还原为 int 或 BigInt
+    static Value from_rational(const ::Rational& q) {
+        if (!q.is_integer()) return Value(q);
+        ::BigInt n = q.get_numerator();
+        if (n >= ::BigInt(INT_MIN) && n <= ::BigInt(INT_MAX)) return Value(n.to_int());
+        return Value(n);
+    }
+
     // Vector operations
     Value vector_add(const Value& other) const {
         if (!is_array() || !other.is_array()) {
@@ -340,13 +496,16 @@ public:
             return Value();
         }
 
-        const auto& a = std::get<std::vector<Value>>(data);
-        const auto& b = std::get<std::vector<Value>>(other.data);
+        const auto& a = get<std::vector<Value>>();
+        const auto& b = other.get<std::vector<Value>>();
 
         if (a.size() != b.size()) {
             std::cerr << "Error: Vector addition requires same dimensions" << std::endl;
             return Value();
         }
+        if (is_exact_vector(a) && is_exact_vector(b)) {
+            return Value(exact_vector_add(a, b, false));
+        }
 
         std::vector<Value> result;
         for (size_t i = 0; i < a.size(); ++i) {
@@ -366,13 +525,16 @@ public:
             return Value();
         }
 
-        const auto& a = std::get<std::vector<Value>>(data);
-        const auto& b = std::get<std::vector<Value>>(other.data);
+        const auto& a = get<std::vector<Value>>();
+        const auto& b = other.get<std::vector<Value>>();
 
         if (a.size() != b.size()) {
             std::cerr << "Error: Vector minus requires same dimensions" << std::endl;
             return Value();
         }
+        if (is_exact_vector(a) && is_exact_vector(b)) {
+            return Value(exact_vector_add(a, b, true));
+        }
 
         std::vector<Value> result;
         for (size_t i = 0; i < a.size(); ++i) {
@@ -393,13 +555,16 @@ public:
             return Value();
         }
 
-        const auto& a = std::get<std::vector<Value>>(data);
-        const auto& b = std::get<std::vector<Value>>(other.data);
+        const auto& a = get<std::vector<Value>>();
+        const auto& b = other.get<std::vector<Value>>();
 
         if (a.size() != b.size()) {
             std::cerr << "Error: Dot product requires same dimensions" << std::endl;
             return Value();
         }
+        if (is_exact_vector(a) && is_exact_vector(b)) {
+            return exact_dot(a, b);
+        }
 
         double result = 0.0;
         for (size_t i = 0; i < a.size(); ++i) {
@@ -413,13 +578,22 @@ public:
         return Value(result);
     }
     // Scalar multiplication
+    // 数组元素和标量都是整数 / 有理数时结果保持精确
+    Value scalar_multiply(const Value& scalar) const {
+        if (is_array() && (scalar.is_int() || scalar.is_bigint() || scalar.is_rational()) &&
+            is_exact_vector(get<std::vector<Value>>())) {
+            return Value(exact_scale(get<std::vector<Value>>(), scalar));
+        }
+        return scalar_multiply(scalar.as_number());
+    }
+
     Value scalar_multiply(double scalar) const {
         if (!is_array()) {
             std::cerr << "Error: Scalar multiplication requires an array" << std::endl;
             return Value();
         }
 
-        const auto& arr = std::get<std::vector<Value>>(data);
+        const auto& arr = get<std::vector<Value>>();
         std::vector<Value> result;
 
         for (const auto& elem: arr) {
@@ -440,8 +614,8 @@ public:
             return Value();
         }
 
-        const auto& a = std::get<std::vector<Value>>(data);
-        const auto& b = std::get<std::vector<Value>>(other.data);
+        const auto& a = get<std::vector<Value>>();
+        const auto& b = other.get<std::vector<Value>>();
 
         if (a.size() != 3 || b.size() != 3) {
             std::cerr << "Error: Cross product requires 3D vectors" << std::endl;
@@ -472,7 +646,7 @@ public:
             return Value();
         }
 
-        const auto& arr = std::get<std::vector<Value>>(data);
+        const auto& arr = get<std::vector<Value>>();
         double sum = 0.0;
 
         for (const auto& elem: arr) {
@@ -504,8 +678,8 @@ public:
             return Value();
         }
 
-        const auto& a = std::get<std::vector<std::vector<Value>>>(data);
-        const auto& b = std::get<std::vector<std::vector<Value>>>(other.data);
+        const auto& a = get<std::vector<std::vector<Value>>>();
+        const auto& b = other.get<std::vector<std::vector<Value>>>();
 
         if (a.empty() || b.empty() || a[0].size() != b.size()) {
             std::cerr << "Error: Invalid matrix dimensions for multiplication" << std::endl;
@@ -516,71 +690,110 @@ public:
         size_t cols = b[0].size();
         size_t inner = a[0].size();
 
-        std::vector<std::vector<Value>> result(rows, std::vector<Value>(cols, Value(0.0)));
+        // 元素全为整数 / 有理数时做精确乘法
+        const auto exact_rows = [](const std::vector<std::vector<Value>>& mat, size_t width) {
+            return std::all_of(mat.begin(), mat.end(), [&](const std::vector<Value>& row) {
+                return row.size() == width && is_exact_vector(row);
+            });
+        };
+        if (exact_rows(a, inner) && exact_rows(b, cols)) {
+            return Value(exact_matmul(a, b));
+        }
+
+        // 拷进连续的 double 数组，交给分块的 gemm
+        std::vector<double> lhs(rows * inner), rhs(inner * cols), out(rows * cols);
+        if (!pack_matrix(a, inner, lhs.data()) || !pack_matrix(b, cols, rhs.data())) {
+            return Value();
+        }
+        gemm(rows, cols, inner, lhs.data(), rhs.data(), out.data());
 
+        std::vector<std::vector<Value>> result(rows);
         for (size_t i = 0; i < rows; ++i) {
+            result[i].reserve(cols);
             for (size_t j = 0; j < cols; ++j) {
-                double sum = 0.0;
-                for (size_t k = 0; k < inner; ++k) {
-                    if (!a[i][k].is_numeric() || !b[k][j].is_numeric()) {
-                        std::cerr << "Error: Matrix elements must be numeric" << std::endl;
-                        return Value();
-                    }
-                    sum += a[i][k].as_number() * b[k][j].as_number();
-                }
-                result[i][j] = Value(sum);
+                result[i].emplace_back(out[i * cols + j]);
             }
         }
         return Value(result);
     }
 
-    // Matrix determinant (2x2 and 3x3 only)
-    Value determinant() const {
-        if (!is_matrix()) {
-            std::cerr << "Error: Determinant requires a matrix" << std::endl;
-            return Value();
-        }
-
-        const auto& mat = std::get<std::vector<std::vector<Value>>>(data);
+private:
+    // 堆单元：引用计数 + 实际对象
+    struct Cell {
+        std::atomic<unsigned int> refs{1};
+        virtual ~Cell() = default;
+        virtual Cell* clone() const = 0;
+    };
+
+    template<class T>
+    struct Box final : Cell {
+        T value;
+        template<class... Args>
+        explicit Box(Args&&... args) : value(std::forward<Args>(args)...) {}
+        Cell* clone() const override { return new Box(value); }
+    };
+
+    template<class T, size_t I = 0>
+    static constexpr unsigned char index_of() {
+        static_assert(I < std::tuple_size_v<Alternatives>, "type is not a Value alternative");
+        if constexpr (std::is_same_v<T, std::tuple_element_t<I, Alternatives>>) return I;
+        else return index_of<T, I + 1>();
+    }
 
-        if (mat.size() != mat[0].size()) {
-            std::cerr << "Error: Determinant requires a square matrix" << std::endl;
-            return Value();
-        }
+    template<class T>
+    static constexpr bool is_immediate() {
+        return std::is_same_v<T, std::nullptr_t> || std::is_same_v<T, bool> ||
+               std::is_same_v<T, int> || std::is_same_v<T, double>;
+    }
 
-        size_t n = mat.size();
+    // 负载中存放的是哪个备选类型（Alternatives 的下标）
+    unsigned char kind = 0;
+    union Payload {
+        std::nullptr_t null;
+        bool b;
+        int i;
+        double f;
+        Cell* cell;
+    } payload{nullptr};
+
+    bool boxed() const {
+        return kind > index_of<double>();
+    }
 
-        if (n == 2) {
-            // 2x2 determinant: ad - bc
-            if (!mat[0][0].is_numeric() || !mat[0][1].is_numeric() ||
-                !mat[1][0].is_numeric() || !mat[1][1].is_numeric()) {
-                std::cerr << "Error: Matrix elements must be numeric" << std::endl;
-                return Value();
-            }
-            double a = mat[0][0].as_number();
-            double b = mat[0][1].as_number();
-            double c = mat[1][0].as_number();
-            double d = mat[1][1].as_number();
-            return Value(a * d - b * c);
-        } else if (n == 3) {
-            // 3x3 determinant using rule of Sarrus
-            for (size_t i = 0; i < 3; ++i) {
-                for (size_t j = 0; j < 3; ++j) {
-                    if (!mat[i][j].is_numeric()) {
-                        std::cerr << "Error: Matrix elements must be numeric" << std::endl;
-                        return Value();
-                    }
-                }
-            }
+    template<class T, class... Args>
+    void emplace(Args&&... args) {
+        kind = index_of<T>();
+        if constexpr (std::is_same_v<T, bool>) payload.b = T(std::forward<Args>(args)...);
+        else if constexpr (std::is_same_v<T, int>) payload.i = T(std::forward<Args>(args)...);
+        else if constexpr (std::is_same_v<T, double>) payload.f = T(std::forward<Args>(args)...);
+        else payload.cell = new Box<T>(std::forward<Args>(args)...);
+    }
 
-            double a = mat[0][0].as_number(), b = mat[0][1].as_number(), c = mat[0][2].as_number();
-            double d = mat[1][0].as_number(), e = mat[1][1].as_number(), f = mat[1][2].as_number();
-            double g = mat[2][0].as_number(), h = mat[2][1].as_number(), i = mat[2][2].as_number();
+    template<class T>
+    const T* ptr() const {
+        if constexpr (std::is_same_v<T, std::nullptr_t>) return &payload.null;
+        else if constexpr (std::is_same_v<T, bool>) return &payload.b;
+        else if constexpr (std::is_same_v<T, int>) return &payload.i;
+        else if constexpr (std::is_same_v<T, double>) return &payload.f;
+        else return &static_cast<const Box<T>*>(payload.cell)->value;
+    }
 
-            return Value(a * e * i + b * f * g + c * d * h - c * e * g - b * d * i - a * f * h);
-        } else {
-            std::cerr << "Error: Determinant only supported for 2x2 and 3x3 matrices" << std::endl;
-            return Value();
+    void release() {
+        if (boxed() && payload.cell->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete payload.cell;
         }
+        kind = 0;
+    }
+
+    // 以十六进制格式输出指针地址
+    static void write_pointer(std::string& out, const char* prefix, const void* ptr) {
+        std::stringstream ss;
+        ss << std::hex << ptr;
+        out += prefix;
+        out += ss.str();
+        out += '>';
     }
 };
+
+// 类型标记 + 8 字节负载，新增类型或改动负载时不能让 Value 变大
+static_assert(sizeof(Value) == 16, "Value must stay a 16-byte tagged word");
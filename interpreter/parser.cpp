@@ -178,8 +178,16 @@ std::unique_ptr<Statement> Parser::parse_stmt() {
             auto set_mem = std::make_unique<SetMemberExpr>(std::move(expr), std::move(value));
             return std::make_unique<ExprStmt>(std::move(set_mem));
         }
-        //非成员访问表达式后不能跟 =
-        throw StdLibException("invalid assignment target: expected member access");
+        if (dynamic_cast<GetItemExpr*>(expr.get())) {
+            skip_token("=");
+            auto value = parse_expression();
+            skip_end_of_ln();
+
+            auto set_item = std::make_unique<SetItemExpr>(std::move(expr), std::move(value));
+            return std::make_unique<ExprStmt>(std::move(set_item));
+        }
+        //非成员访问或下标表达式后不能跟 =
+        throw StdLibException("invalid assignment target: expected member access or subscript");
     }
     if (expr != nullptr) {
         skip_end_of_ln();
@@ -36,6 +36,9 @@ target("lamina_core")
     if is_plat("windows") then
         add_links("imagehlp")
     end
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
     add_rules("utils.symbols.export_all")
     set_configdir("interpreter")
     add_configfiles("interpreter/*.in",{pattern="@(.-)@"})